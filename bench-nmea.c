@@ -0,0 +1,171 @@
+/*
+ * NMEA parser microbenchmark.
+ *
+ * Frames a capture of receiver output with nmea_ring and parses it
+ * repeatedly, reporting sentences per second together with counters of
+ * rejected sentences. Without a capture a built-in 20 Hz sample of GGA,
+ * RMC, VTG, GSA and GST sentences is used.
+ *
+ * usage: bench-nmea [-n loops] [capture.nmea]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include "nmea-ring.h"
+#include "nmea-parse.h"
+#include "internals.h"
+#include "debug.h"
+#include "timing.h"
+
+#define BENCH_LOOPS_DEFAULT	20000
+#define BENCH_LINES_MAX		4096
+
+static const char *bench_sample[] = {
+	"GPGGA,123519.00,2830.123456,N,07710.654321,E,4,12,0.8,301.2,M,-42.1,M,1.0,0131",
+	"GPRMC,123519.00,A,2830.123456,N,07710.654321,E,118.3,084.4,170526,0.4,W,D",
+	"GPVTG,084.4,T,085.0,M,118.3,N,219.1,K,D",
+	"GPGSA,A,3,02,05,12,14,15,18,21,24,25,29,,,1.5,0.8,1.2",
+	"GPGST,123519.00,0.9,0.02,0.01,35.2,0.018,0.015,0.031",
+};
+
+struct bench_lines {
+	char *text[BENCH_LINES_MAX];
+	size_t len[BENCH_LINES_MAX];
+	int nr;
+};
+
+static int bench_add(struct bench_lines *bl, const char *s, size_t len)
+{
+	if (bl->nr == BENCH_LINES_MAX)
+		return -1;
+
+	bl->text[bl->nr] = strndup(s, len);
+	if (bl->text[bl->nr] == NULL) {
+		SYSERR("Failed to allocate line.");
+		return -1;
+	}
+	bl->len[bl->nr++] = len;
+	return 0;
+}
+
+/* Built-in sample completed with '$' and checksum */
+static int bench_load_sample(struct bench_lines *bl)
+{
+	char buff[NMEA_LINE_MAX];
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(bench_sample); i++) {
+		const char *s = bench_sample[i];
+		unsigned char sum = 0;
+		int len;
+
+		while (*s)
+			sum ^= *s++;
+		len = snprintf(buff, sizeof(buff), "$%s*%02X",
+			       bench_sample[i], sum);
+		if (bench_add(bl, buff, len) != 0)
+			return -1;
+	}
+	return 0;
+}
+
+static int bench_load_capture(struct bench_lines *bl, const char *file)
+{
+	struct nmea_ring ring;
+	struct nmea_view v;
+	int fd, retval = -1;
+
+	fd = open(file, O_RDONLY);
+	if (fd < 0) {
+		SYSERR("Failed to open capture: %s", file);
+		return -1;
+	}
+
+	nmea_ring_init(&ring);
+	while (nmea_ring_fill(&ring, fd) > 0) {
+		while (nmea_ring_next(&ring, &v)) {
+			if (bench_add(bl, v.s, v.len) != 0)
+				goto exit;
+		}
+	}
+	retval = 0;
+
+ exit:
+	close(fd);
+	return retval;
+}
+
+int main(int argc, char **argv)
+{
+	static const char *names[NMEA_SENTENCES_NR] = {
+		"unknown", "GGA", "RMC", "VTG", "GSA", "GST",
+	};
+	struct bench_lines bl = { .nr = 0 };
+	unsigned long parsed[NMEA_SENTENCES_NR] = { 0 };
+	struct nmea_parser parser;
+	struct gps_data gps;
+	const struct nmea_stats *st = &parser.stats;
+	int loops = BENCH_LOOPS_DEFAULT;
+	unsigned long t, total = 0;
+	int opt, i, j;
+
+	while ((opt = getopt(argc, argv, "n:")) != -1) {
+		switch (opt) {
+		case 'n':
+			loops = atoi(optarg);
+			break;
+		default:
+			goto usage;
+		}
+	}
+	if (loops <= 0)
+		goto usage;
+
+	if (optind < argc) {
+		if (bench_load_capture(&bl, argv[optind]) != 0)
+			return EXIT_FAILURE;
+	} else if (bench_load_sample(&bl) != 0) {
+		return EXIT_FAILURE;
+	}
+	if (bl.nr == 0) {
+		fprintf(stderr, "No lines to parse.\n");
+		return EXIT_FAILURE;
+	}
+
+	memset(&gps, 0, sizeof(gps));
+	nmea_parser_init(&parser);
+
+	t = timing_now();
+	for (i = 0; i < loops; i++) {
+		for (j = 0; j < bl.nr; j++) {
+			nmea_sentence_t type = nmea_parse(&parser, &gps,
+							  bl.text[j],
+							  bl.len[j]);
+			if (type != NMEA_INVALID)
+				parsed[type]++;
+		}
+	}
+	t = timing_now() - t;
+	total = (unsigned long)loops * bl.nr;
+
+	printf("%lu sentences in %.3f s, %.0f sentences/s, %.1f ns each\n",
+	       total, t / 1e6, t ? total * 1e6 / t : 0.0,
+	       total ? t * 1e3 / total : 0.0);
+	for (i = 0; i < NMEA_SENTENCES_NR; i++) {
+		printf("%-8s%12lu parsed%12lu bad field\n", names[i],
+		       parsed[i], st->bad_field[i]);
+	}
+	printf("bad frame %lu, bad checksum %lu\n",
+	       st->bad_frame, st->bad_checksum);
+
+	for (j = 0; j < bl.nr; j++)
+		free(bl.text[j]);
+	return EXIT_SUCCESS;
+
+ usage:
+	fprintf(stderr, "usage: %s [-n loops] [capture.nmea]\n", argv[0]);
+	return EXIT_FAILURE;
+}
@@ -0,0 +1,286 @@
+/*
+ * Offline rendering benchmark.
+ *
+ * Runs the cockpit widget tree against the headless frame buffer, feeds
+ * it with a recorded GPGS data file or simulated flight and reports the
+ * distribution of frame times for every view.
+ *
+ * usage: bench-render [-n frames] [-r record.dat] course.pgn
+ *        bench-render -p capture.dl
+ *
+ * The second form replays a display list capture instead, timing the
+ * backend primitives alone.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+
+#include "svgalib.h"
+#include "config.h"
+#include "debug.h"
+#include "gps.h"
+#include "ral.h"
+#include "mag.h"
+#include "course.h"
+#include "flight.h"
+#include "timing.h"
+
+#define BENCH_FRAMES_DEFAULT	500
+
+struct bench_view {
+	main_frame_view_t view;
+	const char *name;
+	struct timing_hist hist;
+};
+
+static struct bench_view bench_views[] = {
+	{ VIEW_GPS_CONTEXT, "GPS" },
+	{ VIEW_FILE_CONTEXT, "FILE" },
+	{ VIEW_MAG_CONTEXT, "MAG" },
+	{ VIEW_MAP_CONTEXT, "MAP" },
+};
+
+struct bench_input {
+	FILE *fp;
+	run_mode_t mode;
+	unsigned long nr;
+};
+
+static void __count_entry(const struct course *cp, const void *entry,
+			  void *userdata)
+{
+	(*(int *)userdata)++;
+}
+
+static void bench_course_info(const struct course *cp, const char *file)
+{
+	int lines = 0, ties = 0, wps = 0, corners = 0;
+
+	course_for_each(cp, COURSE_FLT_LINE, __count_entry, &lines);
+	course_for_each(cp, COURSE_TIE_LINE, __count_entry, &ties);
+	course_for_each(cp, COURSE_WAY_POINT, __count_entry, &wps);
+	course_for_each(cp, COURSE_CORNER_POINT, __count_entry, &corners);
+	printf("Course %s: %d flight lines, %d tie lines, "
+	       "%d waypoints, %d corner points\n",
+	       file, lines, ties, wps, corners);
+}
+
+/* Next record of a GPGS data file, rewinding at its end */
+static int bench_read_record(struct bench_input *in, struct gps_data *gps,
+			     struct ral_data *ral, struct mag_data *mag)
+{
+	char buff[256] = "";
+	int line, retry = 1;
+
+	for (;;) {
+		if (fgets(buff, 256, in->fp) == NULL) {
+			if (!retry--)
+				return -1;
+			rewind(in->fp);
+			continue;
+		}
+		if (sscanf(buff, "%lf,%lf,%lf,%lf,%lf,%d,%lf",
+			   &gps->gga.utc_time, &gps->gga.latitude,
+			   &gps->gga.longitude, &gps->gga.altitude,
+			   &ral->agl_height, &line, &mag->field_value) == 7)
+			break;
+	}
+	gps->gga.fix = 1;
+	return 0;
+}
+
+/* Straight survey flight with noisy height and magnetic field */
+static void bench_simulate(struct bench_input *in, struct gps_data *gps,
+			   struct ral_data *ral, struct mag_data *mag)
+{
+	double t = in->nr * 0.2;
+
+	gps->gga.utc_time = 100000.0 + t;
+	gps->gga.latitude = 2830.0 + t * 0.001;
+	gps->gga.longitude = 7710.0 + t * 0.0005;
+	gps->gga.altitude = 300.0 + ((random() % 20) - 9.5) / 10.0;
+	gps->gga.fix = 1;
+	gps->gga.nsat = 9;
+	ral->agl_height = 263.0 + ((random() % 20) - 9.5) / 10.0;
+	mag->field_value = 48.0 + 0.2 * sin(t * 0.1) +
+			   (random() % 100) * 1e-4;
+}
+
+static rc_t bench_feed(struct bench_input *in, struct gps_data *gps,
+		       struct ral_data *ral, struct mag_data *mag)
+{
+	if (in->fp == NULL || bench_read_record(in, gps, ral, mag) != 0)
+		bench_simulate(in, gps, ral, mag);
+	in->nr++;
+
+	snprintf(gps->nmea_string, sizeof(gps->nmea_string),
+		 "$GPGGA,%09.2lf,%011.6lf,N,%012.6lf,E,%d,%02d,1.0,%.1lf,M",
+		 gps->gga.utc_time, gps->gga.latitude, gps->gga.longitude,
+		 gps->gga.fix, gps->gga.nsat, gps->gga.altitude);
+	return RC_GPS_UPDATE | RC_RAL_UPDATE | RC_MAG_UPDATE;
+}
+
+struct bench_replay {
+	struct timing_hist hist;
+	unsigned long t;
+};
+
+static int bench_replay_frame(int frame, void *userdata)
+{
+	struct bench_replay *br = (struct bench_replay *)userdata;
+	unsigned long t = timing_now();
+
+	timing_hist_add(&br->hist, t - br->t);
+	br->t = t;
+	return 0;
+}
+
+static int bench_replay(const char *capture)
+{
+	struct bench_replay br;
+	const struct timing_hist *h = &br.hist;
+	int frames;
+
+	if (svgalib_init(VGAMODE) != 0) {
+		DEBUG("svgalib_init() failed.");
+		return EXIT_FAILURE;
+	}
+
+	timing_hist_reset(&br.hist);
+	br.t = timing_now();
+	frames = svgalib_replay(capture, bench_replay_frame, &br);
+	svgalib_exit();
+	if (frames < 0)
+		return EXIT_FAILURE;
+
+	printf("%-8s%8s%10s%10s%10s%10s  (ms)\n",
+	       "replay", "frames", "p50", "p90", "p99", "max");
+	printf("%-8s%8u%10.2f%10.2f%10.2f%10.2f\n", "", h->count,
+	       timing_hist_percentile(h, 50) / 1000.0,
+	       timing_hist_percentile(h, 90) / 1000.0,
+	       timing_hist_percentile(h, 99) / 1000.0,
+	       timing_hist_max(h) / 1000.0);
+	return EXIT_SUCCESS;
+}
+
+static void bench_report(const struct bench_view *bv)
+{
+	const struct timing_hist *h = &bv->hist;
+
+	printf("%-6s%8u%10.2f%10.2f%10.2f%10.2f\n", bv->name, h->count,
+	       timing_hist_percentile(h, 50) / 1000.0,
+	       timing_hist_percentile(h, 90) / 1000.0,
+	       timing_hist_percentile(h, 99) / 1000.0,
+	       timing_hist_max(h) / 1000.0);
+}
+
+int main(int argc, char **argv)
+{
+	struct gps_data gps;
+	struct mag_data mag;
+	struct ral_data ral;
+	struct course course;
+	struct flight_data flt;
+	struct graphics_context *gc = NULL;
+	struct bench_input in = { NULL, RUN_SIM_AUTO, 0 };
+	const char *record = NULL;
+	char *p = NULL;
+	int frames = BENCH_FRAMES_DEFAULT;
+	int opt, retval = EXIT_FAILURE;
+	register int i, j;
+
+	while ((opt = getopt(argc, argv, "n:r:p:")) != -1) {
+		switch (opt) {
+		case 'p':
+			return bench_replay(optarg);
+		case 'n':
+			frames = atoi(optarg);
+			break;
+		case 'r':
+			record = optarg;
+			break;
+		default:
+			goto usage;
+		}
+	}
+	if (optind >= argc || frames <= 0)
+		goto usage;
+
+	if (record != NULL) {
+		in.fp = fopen(record, "r");
+		if (in.fp == NULL) {
+			SYSERR("Failed to open record: %s", record);
+			return EXIT_FAILURE;
+		}
+		in.mode = RUN_REAL_TIME;
+	}
+
+	/* File view lists the directory of the course */
+	snprintf(map_directory, 256, "%s", argv[optind]);
+	p = strrchr(map_directory, '/');
+	if (p != NULL)
+		p[1] = '\0';
+	else
+		snprintf(map_directory, 256, "./");
+
+	if (svgalib_init(VGAMODE) != 0) {
+		DEBUG("svgalib_init() failed.");
+		goto exit_close;
+	}
+	icons_initialize();
+
+	gps_data_init(&gps);
+	mag_data_init(&mag);
+	ral_data_init(&ral);
+	course_init(&course);
+	flight_init(&flt);
+
+	if (graphics_context_init(&gc, &course, &flt, &gps, &mag) != 0) {
+		DEBUG("graphics_context_init() failed.");
+		goto exit_svgalib;
+	}
+	graphics_update(gc, graphics_load_course(gc, &course, &flt,
+						 argv[optind]));
+	graphics_render(gc);
+	bench_course_info(&course, argv[optind]);
+
+	for (i = 0; i < ARRAY_SIZE(bench_views); i++) {
+		struct bench_view *bv = &bench_views[i];
+
+		timing_hist_reset(&bv->hist);
+		graphics_set_view(gc, bv->view);
+
+		for (j = 0; j < frames; j++) {
+			rc_t rc = bench_feed(&in, &gps, &ral, &mag);
+			unsigned long t = timing_now();
+
+			rc |= flight_update(&flt, &course, &gps, &ral,
+					    in.mode, rc);
+			rc |= course_update(&course, &flt, rc);
+			graphics_update(gc, rc);
+			graphics_render(gc);
+			timing_hist_add(&bv->hist, timing_now() - t);
+		}
+	}
+
+	printf("%-6s%8s%10s%10s%10s%10s  (ms)\n",
+	       "view", "frames", "p50", "p90", "p99", "max");
+	for (i = 0; i < ARRAY_SIZE(bench_views); i++)
+		bench_report(&bench_views[i]);
+	retval = EXIT_SUCCESS;
+
+	graphics_context_destroy(gc);
+ exit_svgalib:
+	svgalib_exit();
+ exit_close:
+	if (in.fp != NULL)
+		fclose(in.fp);
+	return retval;
+
+ usage:
+	fprintf(stderr, "usage: %s [-n frames] [-r record.dat] course.pgn\n"
+		"       %s -p capture.dl\n", argv[0], argv[0]);
+	return EXIT_FAILURE;
+}
@@ -0,0 +1,347 @@
+/*
+ * NovAtel binary log decoder check.
+ *
+ * Feeds CRC-valid BESTPOS, BESTVEL and TIME frames through a pty, the
+ * same way receiver output arrives on the GPS port: read into an
+ * nmea_ring, which cuts the frames out of the lines, and decoded.
+ * Frames are written whole, split in pieces and byte by byte, next to
+ * garbage, command replies and a frame failing CRC, and in a run longer
+ * than a line with no LF in it. Decoded fields, decoder counters and
+ * the reply lines left are compared against what was written.
+ *
+ * usage: check-novatel
+ */
+#define _GNU_SOURCE		/* posix_openpt(), cfmakeraw() */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <math.h>
+
+#include "novatel.h"
+#include "nmea-ring.h"
+#include "internals.h"
+#include "debug.h"
+
+#define CHECK_HEADER_LEN	28
+#define CHECK_READ_TIMEOUT	1000	/* ms */
+#define CHECK_RUN_FRAMES	6	/* BESTPOS, more than a line long */
+
+/* Encoded values, chosen to be exact in NMEA ddmm.mmmmmm */
+#define CHECK_LATITUDE		(28.0 + 30.123456 / 60.0)
+#define CHECK_LONGITUDE		(-(77.0 + 10.654321 / 60.0))
+#define CHECK_HEIGHT		301.25
+#define CHECK_POS_TYPE		50	/* NARROW_INT, GGA quality 4 */
+#define CHECK_NSAT		12
+#define CHECK_SPEED		61.5
+#define CHECK_TRACK		84.25
+#define CHECK_VERTICAL_SPEED	-1.75
+#define CHECK_UTC_OFFSET	-18.0
+#define CHECK_GPS_MS		(45319000 + 18000)	/* 12:35:19 UTC */
+
+struct check_port {
+	int master;			/* receiver side */
+	int slave;			/* GPS port side */
+	struct nmea_ring ring;
+	struct novatel_decoder decoder;
+	struct gps_data gps;
+	int mask;			/* NOVATEL_*_UPDATE seen */
+	int replies;			/* <OK lines framed */
+	char line[NMEA_LINE_MAX];	/* last line framed */
+};
+
+static int check_failures;
+
+static void check(int ok, const char *what)
+{
+	if (ok)
+		return;
+	printf("%s: failed\n", what);
+	check_failures++;
+}
+
+static void put_u16(unsigned char *p, unsigned int v)
+{
+	p[0] = v;
+	p[1] = v >> 8;
+}
+
+static void put_u32(unsigned char *p, uint32_t v)
+{
+	put_u16(p, v);
+	put_u16(p + 2, v >> 16);
+}
+
+static void put_f32(unsigned char *p, float f)
+{
+	uint32_t u;
+
+	memcpy(&u, &f, sizeof(u));
+	put_u32(p, u);
+}
+
+static void put_f64(unsigned char *p, double d)
+{
+	uint64_t u;
+
+	memcpy(&u, &d, sizeof(u));
+	put_u32(p, u);
+	put_u32(p + 4, u >> 32);
+}
+
+/* Frame @len bytes of @msg as binary log @id, returns frame length */
+static size_t check_frame(unsigned char *f, unsigned int id,
+			  const unsigned char *msg, unsigned int len)
+{
+	memset(f, 0, CHECK_HEADER_LEN);
+	f[0] = 0xAA;
+	f[1] = 0x44;
+	f[2] = 0x12;
+	f[3] = CHECK_HEADER_LEN;
+	put_u16(f + 4, id);
+	put_u16(f + 8, len);
+	put_u16(f + 14, 2400);			/* GPS week */
+	put_u32(f + 16, CHECK_GPS_MS);
+	memcpy(f + CHECK_HEADER_LEN, msg, len);
+	len += CHECK_HEADER_LEN;
+	put_u32(f + len, novatel_crc32(f, len));
+	return len + 4;
+}
+
+static size_t check_bestpos(unsigned char *f)
+{
+	unsigned char msg[72];
+
+	memset(msg, 0, sizeof(msg));
+	put_u32(msg + 4, CHECK_POS_TYPE);
+	put_f64(msg + 8, CHECK_LATITUDE);
+	put_f64(msg + 16, CHECK_LONGITUDE);
+	put_f64(msg + 24, CHECK_HEIGHT);
+	put_f32(msg + 40, 0.25);
+	put_f32(msg + 44, 0.125);
+	put_f32(msg + 48, 0.5);
+	msg[64] = CHECK_NSAT;
+	msg[65] = CHECK_NSAT;
+	return check_frame(f, NOVATEL_BESTPOS, msg, sizeof(msg));
+}
+
+static size_t check_bestvel(unsigned char *f)
+{
+	unsigned char msg[44];
+
+	memset(msg, 0, sizeof(msg));
+	put_u32(msg + 4, CHECK_POS_TYPE);
+	put_f64(msg + 16, CHECK_SPEED);
+	put_f64(msg + 24, CHECK_TRACK);
+	put_f64(msg + 32, CHECK_VERTICAL_SPEED);
+	return check_frame(f, NOVATEL_BESTVEL, msg, sizeof(msg));
+}
+
+static size_t check_time(unsigned char *f)
+{
+	unsigned char msg[44];
+
+	memset(msg, 0, sizeof(msg));
+	put_f64(msg + 20, CHECK_UTC_OFFSET);
+	put_u32(msg + 40, 1);			/* UTC valid */
+	return check_frame(f, NOVATEL_TIME, msg, sizeof(msg));
+}
+
+static int check_port_open(struct check_port *cp)
+{
+	struct termios tio;
+
+	cp->master = posix_openpt(O_RDWR | O_NOCTTY);
+	if (cp->master < 0 || grantpt(cp->master) != 0 ||
+	    unlockpt(cp->master) != 0) {
+		SYSERR("Failed to allocate pty.");
+		return -1;
+	}
+
+	cp->slave = open(ptsname(cp->master), O_RDWR | O_NOCTTY | O_NONBLOCK);
+	if (cp->slave < 0) {
+		SYSERR("Failed to open pty slave.");
+		return -1;
+	}
+
+	/* Binary data must pass untouched, as on a raw serial port */
+	if (tcgetattr(cp->slave, &tio) != 0)
+		return -1;
+	cfmakeraw(&tio);
+	if (tcsetattr(cp->slave, TCSANOW, &tio) != 0)
+		return -1;
+
+	nmea_ring_init(&cp->ring);
+	nmea_ring_set_framer(&cp->ring, NOVATEL_SYNC0, novatel_frame_len);
+	novatel_decoder_init(&cp->decoder);
+	memset(&cp->gps, 0, sizeof(cp->gps));
+	return 0;
+}
+
+/* Receive side as in gps_port_acquire(), returns bytes read */
+static ssize_t check_port_read(struct check_port *cp)
+{
+	struct nmea_ring *r = &cp->ring;
+	struct pollfd pfd = { .fd = cp->slave, .events = POLLIN };
+	struct nmea_view v;
+	ssize_t n;
+
+	if (poll(&pfd, 1, CHECK_READ_TIMEOUT) <= 0)
+		return -1;
+
+	n = nmea_ring_fill(r, cp->slave);
+	while (nmea_ring_next(r, &v)) {
+		if (v.frame) {
+			cp->mask |= novatel_decode(&cp->decoder, &cp->gps,
+						   v.s, v.len);
+			continue;
+		}
+		snprintf(cp->line, sizeof(cp->line), "%s", v.s);
+		if (strcmp(v.s, "<OK") == 0 || strcmp(v.s, "[COM1]<OK") == 0)
+			cp->replies++;
+	}
+	return n;
+}
+
+/* Write @size bytes as the receiver would and read them all back */
+static int check_feed(struct check_port *cp, const void *buf, size_t size)
+{
+	size_t got = 0;
+	ssize_t n;
+
+	if (write(cp->master, buf, size) != (ssize_t)size) {
+		SYSERR("Failed to write pty.");
+		return -1;
+	}
+
+	while (got < size) {
+		n = check_port_read(cp);
+		if (n < 0) {
+			printf("read: %zu of %zu bytes arrived\n", got, size);
+			return -1;
+		}
+		got += n;
+	}
+	return 0;
+}
+
+/* Feed in pieces ending at each of @cuts, then the rest */
+static int check_feed_split(struct check_port *cp, const unsigned char *buf,
+			    size_t size, const size_t *cuts, int nr)
+{
+	size_t at = 0;
+	int i;
+
+	for (i = 0; i < nr; i++) {
+		if (check_feed(cp, buf + at, cuts[i] - at) != 0)
+			return -1;
+		at = cuts[i];
+	}
+	return check_feed(cp, buf + at, size - at);
+}
+
+static int check_run(struct check_port *cp)
+{
+	static const unsigned char garbage[] = "\x01\xAA\x44\x13$GP\xAA\r\n";
+	static const char reply[] = "<OK\r\n[COM1]";
+	static const char reply_end[] = "<OK\r\n";
+	unsigned char frame[CHECK_RUN_FRAMES * NOVATEL_FRAME_MAX];
+	const struct novatel_decoder *d = &cp->decoder;
+	const struct gga *gga = &cp->gps.gga;
+	size_t len, more, i, cuts[] = { 1, 3, 20, 40, 100 };
+
+	/* Whole frame after garbage holding false sync bytes */
+	if (check_feed(cp, garbage, sizeof(garbage) - 1) != 0)
+		return -1;
+	len = check_time(frame);
+	if (check_feed(cp, frame, len) != 0)
+		return -1;
+	check(cp->mask == NOVATEL_TIME_UPDATE, "TIME decoded");
+	check(d->utc_valid && d->utc_offset == CHECK_UTC_OFFSET,
+	      "TIME UTC offset");
+
+	/* Split within sync, header, message and CRC */
+	cp->mask = 0;
+	len = check_bestpos(frame);
+	if (check_feed_split(cp, frame, len, cuts, ARRAY_SIZE(cuts)) != 0)
+		return -1;
+	check(cp->mask == NOVATEL_POS_UPDATE, "BESTPOS decoded");
+	check(fabs(gga->latitude - 2830.123456) < 1e-6 &&
+	      gga->latitude_hemisphere == 'N', "BESTPOS latitude");
+	check(fabs(gga->longitude - 7710.654321) < 1e-6 &&
+	      gga->longitude_hemisphere == 'W', "BESTPOS longitude");
+	check(gga->altitude == CHECK_HEIGHT, "BESTPOS height");
+	check(gga->fix == 4 && gga->nsat == CHECK_NSAT, "BESTPOS fix");
+	check(fabs(gga->utc_time - 123519.0) < 1e-6, "BESTPOS UTC time");
+	check(strncmp(cp->gps.nmea_string, "$GPGGA,123519.00,", 17) == 0,
+	      "BESTPOS GPGGA sentence");
+
+	/* Byte by byte, with a reply in between */
+	cp->mask = 0;
+	if (check_feed(cp, reply, sizeof(reply) - 1) != 0)
+		return -1;
+	len = check_bestvel(frame);
+	for (i = 0; i < len; i++) {
+		if (check_feed(cp, frame + i, 1) != 0)
+			return -1;
+	}
+	check(cp->mask == NOVATEL_VEL_UPDATE, "BESTVEL decoded");
+	check(d->speed == CHECK_SPEED && d->track == CHECK_TRACK &&
+	      d->vertical_speed == CHECK_VERTICAL_SPEED, "BESTVEL fields");
+
+	/* Frame failing CRC must not hide the valid one following it */
+	cp->mask = 0;
+	memset(&cp->gps, 0, sizeof(cp->gps));
+	len = check_bestpos(frame);
+	frame[40] ^= 0x10;
+	more = check_bestvel(frame + len);
+	if (check_feed(cp, frame, len + more) != 0)
+		return -1;
+	check(cp->mask == NOVATEL_VEL_UPDATE, "bad CRC frame skipped");
+	check(gga->fix == 0 && gga->latitude == 0.0, "bad CRC frame ignored");
+
+	/* Run longer than a line, reply split by it must come out whole */
+	cp->mask = 0;
+	for (len = i = 0; i < CHECK_RUN_FRAMES; i++)
+		len += check_bestpos(frame + len);
+	check(len >= NMEA_LINE_MAX && memchr(frame, '\n', len) == NULL,
+	      "run without LF");
+	memcpy(frame + len, reply_end, sizeof(reply_end) - 1);
+	if (check_feed(cp, frame, len + sizeof(reply_end) - 1) != 0)
+		return -1;
+	check(cp->mask == NOVATEL_POS_UPDATE, "run decoded");
+	check(strcmp(cp->line, "[COM1]<OK") == 0, "reply joined over run");
+
+	check(cp->replies == 2, "replies framed");
+	check(d->stats.frames == 4 + CHECK_RUN_FRAMES, "frames counted");
+	check(d->stats.bad_crc == 1, "bad CRC counted");
+	check(cp->ring.overruns == 0, "no line overrun");
+
+	printf("%s: %lu frames, %lu bad CRC, %d replies\n",
+	       check_failures ? "FAIL" : "PASS",
+	       d->stats.frames, d->stats.bad_crc, cp->replies);
+	return check_failures ? -1 : 0;
+}
+
+int main(int argc, char **argv)
+{
+	struct check_port cp;
+	int retval;
+
+	if (argc > 1) {
+		fprintf(stderr, "usage: %s\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	if (check_port_open(&cp) != 0)
+		return EXIT_FAILURE;
+
+	retval = check_run(&cp);
+	close(cp.slave);
+	close(cp.master);
+	return retval ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,171 @@
+/*
+ * Batched transform check.
+ *
+ * Compares transform_batch(), vectorized when built with SSE2, and its
+ * scalar path transform_batch_scalar() against do_transform() over
+ * random transforms and points. Batches of odd length, unaligned and in
+ * place are included, so the vector loop, its tail and aliasing are all
+ * covered.
+ *
+ * usage: check-transform [-n transforms] [-s seed]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+
+#include "transform-batch.h"
+
+#define CHECK_TRANSFORMS_DEFAULT	10000
+#define CHECK_POINTS_MAX		67
+
+/*
+ * Results may differ from do_transform() by rounding only. Allowed
+ * error is relative to the largest term of the affine sum, so that it
+ * holds for world coordinates of millions of metres as well.
+ */
+#define CHECK_TOLERANCE			1e-12
+
+/* Mismatches printed before only being counted */
+#define CHECK_REPORT_MAX		10
+
+struct check_stats {
+	unsigned long points;
+	unsigned long mismatches;
+	double max_error;		/* relative to tolerance bound */
+};
+
+static double check_random(double lo, double hi)
+{
+	return lo + (hi - lo) * (random() / (double)RAND_MAX);
+}
+
+/* Rotation, scale and position as map.c sets them */
+static void check_random_transform(struct transform *tr, struct point *pos)
+{
+	double fi = check_random(0.0, 2.0 * M_PI);
+	struct point ref = {
+		check_random(0.0, 640.0), check_random(0.0, 480.0),
+	};
+
+	transform_init(tr, 0.0, 1.0, 1.0, 0.0, 0.0, 0.0, 0.0);
+	transform_set_angle(tr, sin(fi), cos(fi));
+	transform_set_scale(tr, pow(10.0, check_random(-3.0, 1.0)));
+
+	/* UTM like world coordinates */
+	pos->x = check_random(1e5, 9e5);
+	pos->y = check_random(0.0, 1e7);
+	transform_set_curr_position(tr, pos);
+	transform_set_ref_point(tr, &ref);
+}
+
+static void check_result(struct check_stats *st, const char *path,
+			 const struct transform_affine *af,
+			 const struct transform *tr, double x, double y,
+			 double xo, double yo)
+{
+	struct point p = { x, y };
+	double bx, by, err;
+
+	p = do_transform(tr, p);
+	bx = CHECK_TOLERANCE * (fabs(af->a * x) + fabs(af->b * y) +
+				fabs(af->tx) + 1.0);
+	by = CHECK_TOLERANCE * (fabs(af->c * x) + fabs(af->d * y) +
+				fabs(af->ty) + 1.0);
+	err = fmax(fabs(xo - p.x) / bx, fabs(yo - p.y) / by);
+
+	st->points++;
+	if (err > st->max_error)
+		st->max_error = err;
+	if (err <= 1.0)
+		return;
+
+	if (st->mismatches++ < CHECK_REPORT_MAX)
+		printf("%s: (%.6f, %.6f) is (%.9f, %.9f), expected "
+		       "(%.9f, %.9f)\n", path, x, y, xo, yo, p.x, p.y);
+}
+
+static void check_batch(struct check_stats *st, const struct transform *tr,
+			const struct point *pos)
+{
+	/* One spare entry to start at an odd, unaligned index */
+	double x[CHECK_POINTS_MAX + 1], y[CHECK_POINTS_MAX + 1];
+	double xo[CHECK_POINTS_MAX + 1], yo[CHECK_POINTS_MAX + 1];
+	double xs[CHECK_POINTS_MAX + 1], ys[CHECK_POINTS_MAX + 1];
+	struct transform_affine af;
+	unsigned int nr = random() % (CHECK_POINTS_MAX + 1);
+	unsigned int off = random() & 1;
+	register unsigned int i;
+
+	/* Mostly around position, some of them far off screen */
+	for (i = 0; i < nr; i++) {
+		double r = (random() & 7) ? 1e4 : 1e6;
+
+		x[off + i] = pos->x + check_random(-r, r);
+		y[off + i] = pos->y + check_random(-r, r);
+	}
+
+	transform_affine_init(&af, tr);
+	transform_batch(&af, x + off, y + off, xo + off, yo + off, nr);
+	transform_batch_scalar(&af, x + off, y + off, xs + off, ys + off, nr);
+
+	for (i = off; i < off + nr; i++) {
+		check_result(st, "batch", &af, tr, x[i], y[i], xo[i], yo[i]);
+		check_result(st, "scalar", &af, tr, x[i], y[i], xs[i], ys[i]);
+	}
+
+	/* In place, output arrays same as input ones */
+	memcpy(xs, x, sizeof(x));
+	memcpy(ys, y, sizeof(y));
+	transform_batch(&af, xs + off, ys + off, xs + off, ys + off, nr);
+	for (i = off; i < off + nr; i++)
+		check_result(st, "in place", &af, tr, x[i], y[i],
+			     xs[i], ys[i]);
+}
+
+int main(int argc, char **argv)
+{
+	struct check_stats st = { 0, 0, 0.0 };
+	int transforms = CHECK_TRANSFORMS_DEFAULT;
+	unsigned int seed = 1;
+	struct transform tr;
+	struct point pos;
+	int opt, i;
+
+	while ((opt = getopt(argc, argv, "n:s:")) != -1) {
+		switch (opt) {
+		case 'n':
+			transforms = atoi(optarg);
+			break;
+		case 's':
+			seed = strtoul(optarg, NULL, 0);
+			break;
+		default:
+			goto usage;
+		}
+	}
+	if (transforms <= 0)
+		goto usage;
+
+	srandom(seed);
+	for (i = 0; i < transforms; i++) {
+		check_random_transform(&tr, &pos);
+		check_batch(&st, &tr, &pos);
+	}
+
+	printf("%s with%s SSE2: %lu points of %d transforms, "
+	       "%lu mismatches, max error %.3g of tolerance\n",
+	       st.mismatches ? "FAIL" : "PASS",
+#ifdef __SSE2__
+	       "",
+#else
+	       "out",
+#endif
+	       st.points, transforms, st.mismatches, st.max_error);
+	return st.mismatches ? EXIT_FAILURE : EXIT_SUCCESS;
+
+ usage:
+	fprintf(stderr, "usage: %s [-n transforms] [-s seed]\n", argv[0]);
+	return EXIT_FAILURE;
+}
@@ -0,0 +1,80 @@
+#include <stdlib.h>
+
+#include "chrome.h"
+#include "svgalib-private.h"
+#include "debug.h"
+
+struct gl_chrome {
+	GraphicsContext *gc;
+	int x, y;			/* screen position of cached box */
+	int width, height;
+	int color;			/* frame color chrome was drawn with */
+	unsigned int valid : 1;
+};
+
+static struct gl_chrome *gl_chrome_create(int w, int h)
+{
+	struct gl_chrome *ch = calloc(1, sizeof(struct gl_chrome));
+	if (ch == NULL) {
+		SYSERR("Failed to allocate chrome structure.");
+		return NULL;
+	}
+
+	ch->gc = svgalib_layer_create(w, h);
+	if (ch->gc == NULL) {
+		DEBUG("Failed to create chrome layer %dx%d", w, h);
+		free(ch);
+		return NULL;
+	}
+	ch->width = w;
+	ch->height = h;
+	return ch;
+}
+
+void gl_chrome_destroy(struct gl_chrome *ch)
+{
+	if (ch == NULL)
+		return;
+
+	svgalib_virtual_context_destroy(ch->gc);
+	free(ch);
+}
+
+void gl_chrome_invalidate(struct gl_chrome *ch)
+{
+	if (ch)
+		ch->valid = 0;
+}
+
+void gl_chrome_restore(struct gl_chrome **chp, struct gl_frame *frm,
+		       int x, int y, int w, int h, gl_chrome_draw_t draw)
+{
+	struct gl_chrome *ch = *chp;
+
+	if (w <= 0 || h <= 0)
+		return;
+
+	if (ch && (ch->width != w || ch->height != h)) {
+		gl_chrome_destroy(ch);
+		ch = *chp = NULL;
+	}
+	if (ch == NULL) {
+		ch = *chp = gl_chrome_create(w, h);
+		if (ch == NULL) {
+			draw(frm, 0, 0);
+			return;
+		}
+	}
+
+	if (!ch->valid || frm->dirty || ch->color != frm->color ||
+	    ch->x != x || ch->y != y) {
+		svgalib_layer_begin(ch->gc);
+		draw(frm, -x, -y);
+		svgalib_layer_end();
+		ch->x = x;
+		ch->y = y;
+		ch->color = frm->color;
+		ch->valid = 1;
+	}
+	svgalib_copy_layer(ch->gc, 0, 0, w, h, x, y);
+}
@@ -0,0 +1,30 @@
+#ifndef GL_CHROME_H_INCLUDED
+#define GL_CHROME_H_INCLUDED
+
+#include "frame.h"
+
+/**
+ * Cached bitmap of the invariant parts of a widget (borders, captions,
+ * background discs), restored with a single blit before its value is drawn.
+ */
+struct gl_chrome;
+
+/* Draw chrome of frame with screen coordinates shifted by (dx, dy) */
+typedef void (*gl_chrome_draw_t)(struct gl_frame *frm, int dx, int dy);
+
+/**
+ * Restore screen box (x, y, w, h) of frame from chrome cached in @chp,
+ * rendering it through @draw first when missing, invalidated, of another
+ * box, or frame is dirty or changed its color. Chrome is drawn straight to
+ * the screen when no layer could be allocated.
+ */
+extern void gl_chrome_restore(struct gl_chrome **chp, struct gl_frame *frm,
+			      int x, int y, int w, int h,
+			      gl_chrome_draw_t draw);
+
+/* Render chrome again on next restore, @ch may be NULL */
+extern void gl_chrome_invalidate(struct gl_chrome *ch);
+
+extern void gl_chrome_destroy(struct gl_chrome *ch);
+
+#endif	/* GL_CHROME_H_INCLUDED */
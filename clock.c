@@ -1,4 +1,5 @@
 #include <stdlib.h>
+#include <string.h>
 
 #include "clock.h"
 #include "svgalib-private.h"
@@ -14,12 +15,25 @@ static void gl_clock_adjust_positions(struct gl_clock *clk,
 	clk->radius = (r >> 1) - 2;
 }
 
+/* Dial on frame background, box around it is restored on each update */
+static void gl_clock_draw_chrome(struct gl_frame *frm, int dx, int dy)
+{
+	struct gl_clock *clk = GL_CLOCK(frm);
+	int r = clk->radius;
+
+	svgalib_draw_box_colored(clk->xb - r + dx, clk->yb - r + dy,
+				 (r << 1) + 1, (r << 1) + 1, frm->color);
+	svgalib_draw_circle_filled(clk->xb + dx, clk->yb + dy,
+				   r, clk->bg_color);
+}
+
 static void gl_clock_draw(struct gl_frame *frm)
 {
 	struct gl_clock *clk = GL_CLOCK(frm);
+	int r = clk->radius;
 
-	svgalib_draw_circle_filled(clk->xb, clk->yb,
-				   clk->radius, clk->bg_color);
+	gl_chrome_restore(&clk->chrome, frm, clk->xb - r, clk->yb - r,
+			  (r << 1) + 1, (r << 1) + 1, gl_clock_draw_chrome);
 	svgalib_display_text(clk->xb - 24, clk->yb - 8, clk->text, FONT_10x18,
 			     clk->bg_color, svgalib_get_color(31, 31, 31));
 }
@@ -27,15 +41,17 @@ static void gl_clock_draw(struct gl_frame *frm)
 static void gl_clock_destroy(struct gl_frame *frm)
 {
 	struct gl_clock *clk = GL_CLOCK(frm);
-	if (clk)
+	if (clk) {
+		gl_chrome_destroy(clk->chrome);
 		free(clk);
+	}
 	clk = NULL;
 }
 
 int gl_clock_create(struct gl_frame **out,
                 int x, int y, int w, int h, int color)
 {
-	struct gl_clock *clk = malloc(sizeof(struct gl_clock));
+	struct gl_clock *clk = calloc(1, sizeof(struct gl_clock));
 	if (clk == NULL) {
 		SYSERR("Failed to allocate clock structure.");
 		return -1;
@@ -44,6 +60,7 @@ int gl_clock_create(struct gl_frame **out,
 	gl_frame_init(&clk->frame, x, y, w, h, color);
 	clk->frame.draw = gl_clock_draw;
 	clk->frame.destroy = gl_clock_destroy;
+	gl_frame_memoize(&clk->frame);
 
 	gl_clock_adjust_positions(clk, &clk->frame);
 	clk->bg_color = svgalib_get_color(0, 0, 0);
@@ -55,7 +72,9 @@ int gl_clock_create(struct gl_frame **out,
 void gl_clock_set_text(struct gl_clock *clk, const char *text, int size)
 {
 	if (size > 6)
-		strcpy(clk->text, "---");
-	else
-		strcpy(clk->text, text);
+		text = "---";
+	if (strcmp(clk->text, text) == 0)
+		return;
+	strcpy(clk->text, text);
+	gl_frame_changed(&clk->frame);
 }
@@ -2,12 +2,14 @@
 #define GL_CLOCK_H_INCLUDED
 
 #include "frame.h"
+#include "chrome.h"
 
 struct gl_clock {
 	struct gl_frame frame;
 	int xb, yb;
 	int radius;
 	int bg_color;
+	struct gl_chrome *chrome;
 	char text[8];
 };
 
@@ -21,6 +23,10 @@ extern int gl_clock_create(struct gl_frame **out,
 
 static inline void gl_clock_set_bgcolor(struct gl_clock *clk, int color)
 {
+	if (clk->bg_color != color) {
+		gl_chrome_invalidate(clk->chrome);
+		gl_frame_changed(&clk->frame);
+	}
 	clk->bg_color = color;
 }
 
@@ -17,65 +17,37 @@ static void adjust_center(struct gl_compass *comp, struct gl_frame *frm)
 static void gl_compass_destroy(struct gl_frame *frm)
 {
 	struct gl_compass *comp = GL_COMPASS(frm);
-	if (comp)
+	if (comp) {
+		gl_chrome_destroy(comp->chrome);
 		free(comp);
+	}
 	comp = NULL;
 }
 
-static void draw_arrow(int width, int pgn[], int size, int color)
+/* Background disc, the needle is drawn over it on each update */
+static void gl_compass_draw_chrome(struct gl_frame *frm, int dx, int dy)
 {
-	register int i;
-	int ix = 0, xx = 0, xy = 0;
-	int in = 0, nx = width, ny = width;
-	int dx = 0, dy = 0;
-
-	for (i = 1; i < size; i += 2) {
-		if (pgn[i] > xy) {
-			xy = pgn[i];
-			xx = pgn[i - 1];
-			ix = i;
-		}
-
-		if (pgn[i] < ny) {
-			ny = pgn[i];
-			nx = pgn[i - 1];
-			in = i;
-		}
-	}
-
-	for (i = 1; i < size; i += 2) {
-		if (i != ix && i != in) {
-			dy = pgn[i];
-			dx = pgn[i - 1];
-		}
-	}
+	struct gl_compass *comp = GL_COMPASS(frm);
+	int r = comp->radius;
 
-	/* upper half of compass polygon */
-	for (i = ny; i < dy; ++i)
-		svgalib_draw_line(nx * (xy - i) / (xy - ny) + xx * (i - ny) / (xy - ny),
-				  i,
-				  (nx * (dy - i) / (dy - ny) + dx * (i - ny) / (dy - ny)),
-				  i,
-				  color);
-
-	/* lower half of compass polygon */
-	for (i = dy; i < xy; ++i)
-		svgalib_draw_line(nx * (xy - i) / (xy - ny) + xx * (i - ny) / (xy - ny),
-				  i,
-				  (dx * (xy - i) / (xy - dy) + xx * (i - dy) / (xy - dy)),
-				  i,
-				  color);
+	svgalib_draw_box_colored(comp->center_x - r + dx,
+				 comp->center_y - r + dy,
+				 (r << 1) + 1, (r << 1) + 1, frm->color);
+	svgalib_draw_circle_filled(comp->center_x + dx, comp->center_y + dy,
+				   r, comp->bg_color);
 }
 
 static void gl_compass_draw(struct gl_frame *frm)
 {
 	struct gl_compass *comp = GL_COMPASS(frm);
+	int r = comp->radius;
 	int color;
 	int xc, yc;
 	int pgn[6];
 
-	svgalib_draw_circle_filled(comp->center_x, comp->center_y,
-				   comp->radius, comp->bg_color);
+	gl_chrome_restore(&comp->chrome, frm,
+			  comp->center_x - r, comp->center_y - r,
+			  (r << 1) + 1, (r << 1) + 1, gl_compass_draw_chrome);
 
 	/**
 	 * Interior angle at upper and lower vertex of compass..
@@ -100,19 +72,19 @@ static void gl_compass_draw(struct gl_frame *frm)
 	color = svgalib_get_color(15, 8, 0);
 	pgn[2] = comp->center_x + yc;
 	pgn[3] = comp->center_y - xc;
-	draw_arrow(2 * comp->radius, pgn, 6, color);
+	svgalib_fill_polygon(pgn, 3, color);
 
 	/* bottom half of compass pointer */
 	color = svgalib_get_color(0, 0, 15);
 	pgn[2] = comp->center_x - yc;
 	pgn[3] = comp->center_y + xc;
-	draw_arrow(2 * comp->radius, pgn, 6, color);
+	svgalib_fill_polygon(pgn, 3, color);
 }
 
 int gl_compass_create(struct gl_frame **out,
                     int x, int y, int w, int h, int color)
 {
-	struct gl_compass *comp = malloc(sizeof(struct gl_compass));
+	struct gl_compass *comp = calloc(1, sizeof(struct gl_compass));
 	if (comp == NULL) {
 		SYSERR("Failed to allocate compass structure.");
 		return -1;
@@ -2,12 +2,14 @@
 #define GL_COMPASS_H_INCLUDED
 
 #include "frame.h"
+#include "chrome.h"
 
 struct gl_compass {
 	struct gl_frame frame;
 	int center_x, center_y;
 	int radius;
 	int bg_color;
+	struct gl_chrome *chrome;
 	double sinfi, cosfi;
 };
 
@@ -25,6 +27,8 @@ static inline void gl_compass_set_orientation(struct gl_compass *comp,
 
 static inline void gl_compass_set_bgcolor(struct gl_compass *comp, int color)
 {
+	if (comp->bg_color != color)
+		gl_chrome_invalidate(comp->chrome);
 	comp->bg_color = color;
 }
 
@@ -1,5 +1,8 @@
 #include "config.h"
 #include "debug.h"
+#include "render.h"
+#include "gps-setup.h"
+#include "gps-port.h"
 #include "lib/confuse.h"
 
 run_mode_t run_mode = 0;
@@ -36,9 +39,30 @@ static run_mode_t get_run_mode(int val)
 	return mode;
 }
 
+/* Command list replaces built-in one only when given */
+static void get_gps_commands(cfg_t *cfg)
+{
+	int i, nr = cfg_size(cfg, "GPS_COMMANDS");
+
+	if (nr == 0)
+		return;
+
+	if (nr > GPS_SETUP_CMD_MAX) {
+		WARN("Too many GPS commands %d, using first %d",
+		     nr, GPS_SETUP_CMD_MAX);
+		nr = GPS_SETUP_CMD_MAX;
+	}
+	for (i = 0; i < nr; i++) {
+		snprintf(gps_setup_commands[i], GPS_SETUP_CMD_LEN, "%s",
+			 cfg_getnstr(cfg, "GPS_COMMANDS", i));
+	}
+	gps_setup_nr_commands = nr;
+}
+
 int read_config_file(const char *cfg_file)
 {
 	int retval = -1;
+	int i;
 	cfg_opt_t opts[] = {
 		CFG_INT("APP_RUN_MODE", 0, CFGF_NONE),
 		CFG_FLOAT("SURVEY_HEIGHT_AGL", 263, CFGF_NONE),
@@ -50,6 +74,13 @@ int read_config_file(const char *cfg_file)
 		CFG_BOOL("LOG_DISABLED", cfg_true, CFGF_NONE),
 		CFG_STR("LOG_DIRECTORY", "/mnt/dataflash/log/", CFGF_NONE),
 		CFG_BOOL("MAG_DISABLED", cfg_true, CFGF_NONE),
+		CFG_INT("RENDER_FRAME_RATE", 10, CFGF_NONE),
+		CFG_INT("RENDER_LATENCY_BUDGET", 150, CFGF_NONE),
+		CFG_STR("GPS_PORT", "/dev/ttyS0", CFGF_NONE),
+		CFG_INT("GPS_BAUDRATE", 9600, CFGF_NONE),
+		CFG_STR_LIST("GPS_COMMANDS", NULL, CFGF_NONE),
+		CFG_INT("GPS_COMMAND_TIMEOUT", 1000, CFGF_NONE),
+		CFG_INT("GPS_COMMAND_RETRIES", 3, CFGF_NONE),
 		CFG_END()
 	};
 	cfg_t *cfg = cfg_init(opts, CFGF_NONE);
@@ -66,6 +97,14 @@ int read_config_file(const char *cfg_file)
 		turn_radius = cfg_getint(cfg, "TURN_RADIUS");
 		log_disable = cfg_getbool(cfg, "LOG_DISABLED");
 		mag_disable = cfg_getbool(cfg, "MAG_DISABLED");
+		render_frame_rate = cfg_getint(cfg, "RENDER_FRAME_RATE");
+		render_latency_budget = cfg_getint(cfg, "RENDER_LATENCY_BUDGET");
+		snprintf(gps_port_name, GPS_PORT_NAME_LEN, "%s",
+			 cfg_getstr(cfg, "GPS_PORT"));
+		gps_port_baudrate = cfg_getint(cfg, "GPS_BAUDRATE");
+		gps_setup_timeout = cfg_getint(cfg, "GPS_COMMAND_TIMEOUT");
+		gps_setup_retries = cfg_getint(cfg, "GPS_COMMAND_RETRIES");
+		get_gps_commands(cfg);
 		snprintf(map_directory, 256, "%s", cfg_getstr(cfg, "MAP_DIRECTORY"));
 		snprintf(log_directory, 256, "%s", cfg_getstr(cfg, "LOG_DIRECTORY"));
 		retval = 0;
@@ -84,6 +123,13 @@ int read_config_file(const char *cfg_file)
 	INFO("LOG disabled: %d", log_disable);
 	INFO("LOG Directory: %s", log_directory);
 	INFO("MAG disabled: %d", mag_disable);
+	INFO("Render frame rate: %d", render_frame_rate);
+	INFO("Render latency budget: %d ms", render_latency_budget);
+	INFO("GPS port: %s at %d baud", gps_port_name, gps_port_baudrate);
+	INFO("GPS command timeout: %d ms, retries: %d",
+	     gps_setup_timeout, gps_setup_retries);
+	for (i = 0; i < gps_setup_nr_commands; i++)
+		INFO("GPS command %d: %s", i + 1, gps_setup_commands[i]);
 
 	return retval;
 }
@@ -1,4 +1,5 @@
 #include <stdlib.h>
+#include <string.h>
 
 #include "data-box.h"
 #include "svgalib-private.h"
@@ -8,11 +9,38 @@
 static void data_box_destroy(struct gl_frame *frm)
 {
 	struct data_box *dbp = DATA_BOX(frm);
-	if (dbp)
+	if (dbp) {
+		gl_chrome_destroy(dbp->chrome);
 		free(dbp);
+	}
 	dbp = NULL;
 }
 
+/* Bevelled box the value is printed in, with caption when split across */
+static void data_box_draw_chrome(struct gl_frame *frm, int dx, int dy)
+{
+	struct data_box *dbp = DATA_BOX(frm);
+	int y;
+
+	switch (dbp->split) {
+	case SPLIT_VERTICAL:
+		y = frm->height * dbp->split_ratio;
+		svgalib_draw_frame(frm->xb + dx, frm->yb + y + dy, frm->width,
+				   frm->height - y, frm->color);
+		break;
+
+	case SPLIT_HORIZONTAL:
+		svgalib_draw_frame(frm->xb + dx, frm->yb + dy, frm->width,
+				   frm->height, frm->color);
+		svgalib_display_text(frm->xb + 5 + dx, frm->yb + 5 + dy,
+				     dbp->caption, FONT_7x14, frm->color,
+				     svgalib_get_color(0, 31, 0));
+		break;
+	default:
+		break;
+	}
+}
+
 static void data_box_show(struct gl_frame *frm)
 {
 	struct data_box *dbp = DATA_BOX(frm);
@@ -21,12 +49,15 @@ static void data_box_show(struct gl_frame *frm)
 	switch (dbp->split) {
 	case SPLIT_VERTICAL:
 		y = frm->height * dbp->split_ratio;
-		svgalib_display_text(frm->xb + 5, frm->yb + 10,
-				     dbp->caption, FONT_7x14, 0,
-				     svgalib_get_color(20, 20, 20));
+		/* Caption above the box is never overdrawn by the value */
+		if (frm->dirty)
+			svgalib_display_text(frm->xb + 5, frm->yb + 10,
+					     dbp->caption, FONT_7x14, 0,
+					     svgalib_get_color(20, 20, 20));
 
-		svgalib_draw_frame(frm->xb, frm->yb + y, frm->width,
-				   frm->height - y, frm->color);
+		gl_chrome_restore(&dbp->chrome, frm, frm->xb, frm->yb + y,
+				  frm->width + 1, frm->height - y + 1,
+				  data_box_draw_chrome);
 		svgalib_display_text(frm->xb + 10, frm->yb + y + 3,
 				     dbp->text, FONT_SUN12x22,
 				     frm->color, dbp->text_color);
@@ -34,12 +65,9 @@ static void data_box_show(struct gl_frame *frm)
 
 	case SPLIT_HORIZONTAL:
 		x = frm->width * dbp->split_ratio;
-		svgalib_draw_frame(frm->xb, frm->yb, frm->width,
-				   frm->height, frm->color);
-		svgalib_display_text(frm->xb + 5, frm->yb + 5,
-				     dbp->caption, FONT_7x14, frm->color,
-				     svgalib_get_color(0, 31, 0));
-
+		gl_chrome_restore(&dbp->chrome, frm, frm->xb, frm->yb,
+				  frm->width + 1, frm->height + 1,
+				  data_box_draw_chrome);
 		svgalib_display_text(frm->xb + x + 10, frm->yb + 5,
 				     dbp->text, FONT_SUN12x22,
 				     frm->color, dbp->text_color);
@@ -64,6 +92,7 @@ int data_box_create(struct gl_frame **out,
 	gl_frame_init(&dbp->frame, x, y, w, h, color);
 	dbp->frame.draw = data_box_show;
 	dbp->frame.destroy = data_box_destroy;
+	gl_frame_memoize(&dbp->frame);
 
 	*out = GL_FRAME(dbp);
 	return 0;
@@ -72,12 +101,16 @@ int data_box_create(struct gl_frame **out,
 void data_box_set_text(struct data_box *dbp, const char *text, int size)
 {
 	if (size > 9)
-		strcpy(dbp->text, "----");
-	else
-		strcpy(dbp->text, text);
+		text = "----";
+	if (strcmp(dbp->text, text) == 0)
+		return;
+	strcpy(dbp->text, text);
+	gl_frame_changed(&dbp->frame);
 }
 
 void data_box_set_caption(struct data_box *dbp, const char *caption)
 {
 	snprintf(dbp->caption, 16, "%-15s", caption);
+	gl_chrome_invalidate(dbp->chrome);
+	gl_frame_changed(&dbp->frame);
 }
@@ -2,6 +2,7 @@
 #define DATA_BOX_H_INCLUDED
 
 #include "frame.h"
+#include "chrome.h"
 
 typedef enum box_split_t {
 	SPLIT_NONE,
@@ -16,6 +17,7 @@ struct data_box {
 	char caption[16];
 	char text[10];
 	int text_color;
+	struct gl_chrome *chrome;
 };
 
 #define DATA_BOX(frame)    ((struct data_box *)frame)
@@ -31,6 +33,8 @@ extern void data_box_set_caption(struct data_box *dbp,
 
 static inline void data_box_set_text_color(struct data_box *dbp, int color)
 {
+	if (dbp->text_color != color)
+		gl_frame_changed(&dbp->frame);
 	dbp->text_color = color;
 }
 
@@ -39,6 +43,8 @@ static inline void data_box_set_split(struct data_box *dbp,
 {
 	dbp->split = type;
 	dbp->split_ratio = ratio;
+	gl_chrome_invalidate(dbp->chrome);
+	gl_frame_changed(&dbp->frame);
 }
 
 #endif	/* DATA_BOX_H_INCLUDED */
@@ -1,4 +1,5 @@
 #include <stdlib.h>
+#include <string.h>
 
 #include "frame.h"
 #include "svgalib-private.h"
@@ -6,6 +7,7 @@
 
 void gl_frame_init(struct gl_frame *frm, int x, int y, int w, int h, int color)
 {
+	frm->name = NULL;
 	frm->xb = x;
 	frm->yb = y;
 	frm->width = w;
@@ -13,6 +15,16 @@ void gl_frame_init(struct gl_frame *frm, int x, int y, int w, int h, int color)
 	frm->color = color;
 	frm->callback_data = NULL;
 	frm->callback = NULL;
+	frm->rc = RC_NONE;
+	frm->border = GL_FRAME_BORDER_ONCE;
+	frm->visible = 1;
+	frm->dirty = 1;
+	frm->pending = 0;
+	frm->memoized = 0;
+	frm->changed = 0;
+	frm->stale = 1;
+	memset(&frm->timing, 0, sizeof(struct gl_frame_timing));
+	INIT_LIST_HEAD(&frm->list);
 }
 
 void gl_frame_destroy(struct gl_frame *frm)
@@ -26,19 +38,116 @@ void gl_frame_add_callback(struct gl_frame *frm, rc_t rc,
 {
 	frm->callback_data = data;
 	frm->callback = callback;
-	frm->rc = rc;
+	frm->rc |= rc;
+}
+
+static void gl_frame_run_callback(struct gl_frame *frm)
+{
+	unsigned long t = timing_now();
+
+	frm->callback(frm, frm->callback_data);
+	timing_hist_add(&frm->timing.callback, timing_now() - t);
 }
 
 void gl_frame_draw(struct gl_frame *frm, unsigned int no_border)
 {
+	unsigned long t;
+
 	if (frm == NULL)
 		return;
 
-	if (frm->callback)
-		frm->callback(frm, frm->callback_data);
+	/* Same content is already on screen */
+	if (frm->memoized && !frm->dirty && !frm->pending && !frm->changed)
+		return;
+
+	/* Border lines are drawn inclusive of right and bottom edges */
+	svgalib_damage_box(frm->xb, frm->yb, frm->width + 1, frm->height + 1);
 
-	if (!no_border)
+	t = timing_now();
+	if (!no_border) {
 		svgalib_draw_frame(frm->xb, frm->yb, frm->width,
 				   frm->height, frm->color);
+		timing_hist_add(&frm->timing.border, timing_now() - t);
+		t = timing_now();
+	}
 	frm->draw(frm);
+	timing_hist_add(&frm->timing.draw, timing_now() - t);
+	frm->dirty = 0;
+	frm->pending = 0;
+	frm->changed = 0;
+}
+
+void gl_frame_register(struct list_head *head, struct gl_frame *frm)
+{
+	if (frm != NULL)
+		list_add_tail(&frm->list, head);
+}
+
+/**
+ * Run callbacks of visible frames subscribed to @rc and mark them for
+ * the next gl_frame_render(). Several updates between two renders are
+ * coalesced into a single redraw of each frame. Memoized frames stay
+ * clean until their setters report a change. Hidden frames are skipped
+ * and refreshed by gl_frame_render() once shown, so callbacks must only
+ * set what the frame displays.
+ */
+void gl_frame_update(struct list_head *head, rc_t rc)
+{
+	struct gl_frame *frm = NULL;
+
+	if (rc == RC_NONE)
+		return;
+
+	list_for_each_entry(frm, head, list) {
+		if (!frm->visible || !(frm->rc & rc))
+			continue;
+
+		if (frm->callback)
+			gl_frame_run_callback(frm);
+		frm->stale = 0;
+		if (!frm->memoized || frm->changed)
+			frm->pending = 1;
+	}
+}
+
+/**
+ * Redraw visible frames of the list in registration order. Invalidated
+ * frames are redrawn in full, others only when marked by an update.
+ * Frames drawn first or shown again take their callback data first,
+ * as updates passed them by while hidden.
+ */
+void gl_frame_render(struct list_head *head)
+{
+	struct gl_frame *frm = NULL;
+
+	list_for_each_entry(frm, head, list) {
+		if (!frm->visible)
+			continue;
+
+		if (frm->stale) {
+			if (frm->callback)
+				gl_frame_run_callback(frm);
+			frm->stale = 0;
+		}
+
+		if (frm->dirty)
+			gl_frame_draw(frm, frm->border == GL_FRAME_BORDER_NONE);
+		else if (frm->pending)
+			gl_frame_draw(frm, frm->border != GL_FRAME_BORDER_ALWAYS);
+	}
+}
+
+/* Update and redraw at once */
+void gl_frame_dispatch(struct list_head *head, rc_t rc)
+{
+	gl_frame_update(head, rc);
+	gl_frame_render(head);
+}
+
+void gl_frame_invalidate_all(struct list_head *head)
+{
+	struct gl_frame *frm = NULL;
+
+	list_for_each_entry(frm, head, list)
+		gl_frame_invalidate(frm);
 }
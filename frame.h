@@ -3,12 +3,28 @@
 
 #include "list.h"
 #include "internals.h"
+#include "timing.h"
 
 struct gl_frame;
 
 typedef void (*gl_frame_callback_t)(struct gl_frame *, const void *);
 
+/* When the frame border is drawn by the dispatcher */
+typedef enum gl_frame_border_t {
+	GL_FRAME_BORDER_NONE,	/* never, frame paints its whole area */
+	GL_FRAME_BORDER_ONCE,	/* only on full redraw of invalidated frame */
+	GL_FRAME_BORDER_ALWAYS,	/* on every redraw, clears frame area */
+} gl_frame_border_t;
+
+/* Where time of a frame goes, see gl_frame_draw() */
+struct gl_frame_timing {
+	struct timing_hist callback;
+	struct timing_hist border;
+	struct timing_hist draw;
+};
+
 struct gl_frame {
+	const char *name;
 	int xb, yb;
 	int width, height;
 	int color;
@@ -16,8 +32,16 @@ struct gl_frame {
 	const void *callback_data;
 	struct list_head list;
 	rc_t rc;
+	gl_frame_border_t border;
+	unsigned int visible : 1;
+	unsigned int dirty : 1;
+	unsigned int pending : 1;	/* updated since last render */
+	unsigned int memoized : 1;	/* redrawn only on reported change */
+	unsigned int changed : 1;	/* content changed since last draw */
+	unsigned int stale : 1;		/* callback not run since shown */
 	void (*draw)(struct gl_frame *frm);
 	void (*destroy)(struct gl_frame *frm);
+	struct gl_frame_timing timing;
 };
 
 #define GL_FRAME(frm)   ((struct gl_frame *)frm)
@@ -33,9 +57,69 @@ extern void gl_frame_draw(struct gl_frame *frm, unsigned int no_border);
 
 extern void gl_frame_destroy(struct gl_frame *frm);
 
+extern void gl_frame_register(struct list_head *head, struct gl_frame *frm);
+
+extern void gl_frame_update(struct list_head *head, rc_t rc);
+
+extern void gl_frame_render(struct list_head *head);
+
+extern void gl_frame_dispatch(struct list_head *head, rc_t rc);
+
+extern void gl_frame_invalidate_all(struct list_head *head);
+
+/* Name shown by diagnostics, never freed */
+static inline void gl_frame_set_name(struct gl_frame *frm, const char *name)
+{
+	frm->name = name;
+}
+
+/**
+ * Frame is only redrawn by updates when its setters report a change of
+ * displayed content with gl_frame_changed(), see gl_frame_update().
+ */
+static inline void gl_frame_memoize(struct gl_frame *frm)
+{
+	frm->memoized = 1;
+}
+
+static inline void gl_frame_changed(struct gl_frame *frm)
+{
+	frm->changed = 1;
+}
+
 static inline void gl_frame_set_color(struct gl_frame *frm, int color)
 {
+	if (frm->color != color)
+		gl_frame_changed(frm);
 	frm->color = color;
 }
 
+static inline void gl_frame_set_border(struct gl_frame *frm,
+				       gl_frame_border_t border)
+{
+	frm->border = border;
+}
+
+/* Redraw frame on updates matching @rc even without callback */
+static inline void gl_frame_subscribe(struct gl_frame *frm, rc_t rc)
+{
+	frm->rc |= rc;
+}
+
+/* Force full redraw of frame, including border, on next dispatch */
+static inline void gl_frame_invalidate(struct gl_frame *frm)
+{
+	frm->dirty = 1;
+}
+
+static inline void gl_frame_set_visible(struct gl_frame *frm,
+					unsigned int visible)
+{
+	if (visible && !frm->visible)
+		frm->dirty = frm->stale = 1;
+	if (!visible)
+		frm->pending = 0;
+	frm->visible = visible ? 1 : 0;
+}
+
 #endif	/* GL_FRAME_H_INCLUDED */
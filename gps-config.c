@@ -1,4 +1,6 @@
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "main-context.h"
 #include "debug.h"
@@ -8,6 +10,12 @@
 
 #define FOOTER_TEXT	stringify(Press <Enter> to Proceed...)
 
+/* First console line below the header, lines are 16 pixels apart */
+#define CONSOLE_TOP		40
+#define CONSOLE_LINE_SHIFT	4
+
+#define HEADER_LEN		64
+
 struct gps_context_entry {
 	char txt[NMEA_STRING_LEN + 1];
 	int color;
@@ -15,59 +23,115 @@ struct gps_context_entry {
 
 struct gps_context {
 	struct gl_frame frame;
-	struct gps_context_entry **entries;
-	const char *header;
+	struct gps_context_entry *entries;	/* ring of nr_entry lines */
+	char header[HEADER_LEN];	/* copied, callers may pass stack text */
 	int hdr_color;
 	int nr_entry;
-	int curr_index;
+	int head;			/* oldest line of the ring */
+	int count;			/* lines in the ring */
+	int shown;			/* lines on screen after last draw */
+	int nr_new;			/* lines added since last draw */
+	unsigned int hdr_changed : 1;
 };
 
+/* Line @i of the console, counted from the oldest one */
+static inline struct gps_context_entry *
+gps_context_line(const struct gps_context *ctx, int i)
+{
+	return &ctx->entries[(ctx->head + i) % ctx->nr_entry];
+}
+
+static void gps_context_draw_line(struct gps_context *ctx, int i)
+{
+	const struct gl_frame *frm = &ctx->frame;
+	const struct gps_context_entry *entry = gps_context_line(ctx, i);
+
+	svgalib_display_text(frm->xb + 8,
+			     frm->yb + CONSOLE_TOP + (i << CONSOLE_LINE_SHIFT),
+			     entry->txt, FONT_ACORN8x8,
+			     frm->color, entry->color);
+	INFO("%s", entry->txt);
+}
+
+static void gps_context_draw_header(struct gps_context *ctx)
+{
+	const struct gl_frame *frm = &ctx->frame;
+
+	svgalib_display_text_wrapped(frm->xb + (frm->width >> 1),
+				     frm->yb + 10, ctx->header,
+				     FONT_SUN8x16, frm->color, ctx->hdr_color);
+	INFO("%s", ctx->header);
+}
+
+/**
+ * Console scrolls by moving lines still shown up within the screen,
+ * only lines added since last draw are rendered.
+ */
+static void gps_context_scroll(struct gps_context *ctx)
+{
+	const struct gl_frame *frm = &ctx->frame;
+	int x = frm->xb + 8, y = frm->yb + CONSOLE_TOP;
+	int w = frm->width - 10;
+	int first = ctx->count - ctx->nr_new;
+	int scroll = ctx->shown - first;
+	register int i;
+
+	if (first > 0 && scroll > 0)
+		svgalib_copy_box(x, y + (scroll << CONSOLE_LINE_SHIFT), w,
+				 first << CONSOLE_LINE_SHIFT, x, y);
+
+	for (i = first; i < ctx->count; i++) {
+		svgalib_draw_box_colored(x, y + (i << CONSOLE_LINE_SHIFT), w,
+					 1 << CONSOLE_LINE_SHIFT, frm->color);
+		gps_context_draw_line(ctx, i);
+	}
+}
+
 static void gps_context_draw(struct gl_frame *frm)
 {
 	struct gps_context *ctx = (struct gps_context *)frm;
 	register int i;
-	int x = frm->xb + (frm->width >> 1);
 
-	/* Header */
-	svgalib_display_text_wrapped(x, frm->yb + 10, ctx->header,
-				     FONT_SUN8x16, frm->color, ctx->hdr_color);
+	if (!frm->dirty) {
+		if (ctx->hdr_changed) {
+			int h = svgalib_text_height(FONT_SUN8x16);
 
-	INFO("%s", ctx->header);
+			/* Header is centered on its line */
+			svgalib_draw_box_colored(frm->xb + 2,
+						 frm->yb + 10 - (h >> 1),
+						 frm->width - 3, h, frm->color);
+			gps_context_draw_header(ctx);
+		}
+		gps_context_scroll(ctx);
+		goto exit;
+	}
 
-	/* Footer */
-	svgalib_display_text_wrapped(x, frm->yb + frm->height - 20,
+	/* Full redraw over area cleared by frame border */
+	gps_context_draw_header(ctx);
+
+	svgalib_display_text_wrapped(frm->xb + (frm->width >> 1),
+				     frm->yb + frm->height - 20,
 				     FOOTER_TEXT,
 				     FONT_SUN8x16, frm->color,
 				     svgalib_get_color(20, 20, 20));
 
-	/* Since index is incremented after add up and normally
-	 * display is called after each entry, so equality
-	 * condition is prohibited here..!!
-	 */
-	for (i = 0; i < ctx->curr_index; ++i) {
-		struct gps_context_entry *entry = ctx->entries[i];
-		svgalib_display_text(frm->xb + 8, frm->yb + (i << 4) + 40,
-				     entry->txt, FONT_ACORN8x8,
-				     frm->color, entry->color);
-		INFO("%s", entry->txt);
-	}
+	for (i = 0; i < ctx->count; ++i)
+		gps_context_draw_line(ctx, i);
 
 	INFO("%s\n", FOOTER_TEXT);
+ exit:
+	ctx->shown = ctx->count;
+	ctx->nr_new = 0;
+	ctx->hdr_changed = 0;
 }
 
 static void gps_context_destroy(struct gl_frame *frm)
 {
 	struct gps_context *ctx = (struct gps_context *)frm;
-	register int i;
 
 	if (ctx == NULL)
 		return;
 
-	for (i = 0; i < ctx->nr_entry; i++) {
-		struct gps_context_entry *entry = ctx->entries[i];
-		if (entry)
-			free(entry);
-	}
 	free(ctx->entries);
 	free(ctx);
 	ctx = NULL;
@@ -76,7 +140,6 @@ static void gps_context_destroy(struct gl_frame *frm)
 int gps_context_create(struct gl_frame **out,
 		       int x, int y, int w, int h, int color)
 {
-	register int i;
 	struct gps_context *ctx = NULL;
 
 	if (out == NULL)
@@ -93,35 +156,24 @@ int gps_context_create(struct gl_frame **out,
 	ctx->frame.draw = gps_context_draw;
 	ctx->frame.destroy = gps_context_destroy;
 
-	ctx->curr_index = 0;
-	ctx->header = "Configuring GPS...";
+	snprintf(ctx->header, HEADER_LEN, "%s", "Configuring GPS...");
 	ctx->hdr_color = svgalib_get_color(15, 15, 0);
-	ctx->nr_entry = ((h - 80) >> 4);
-	ctx->entries = calloc(ctx->nr_entry,
-			      sizeof(struct gps_context_entry *));
-	if (ctx->entries == NULL) {
-		SYSERR("Failed to allocate for gps context entry array");
+	ctx->nr_entry = ((h - 80) >> CONSOLE_LINE_SHIFT);
+	if (ctx->nr_entry <= 0) {
+		DEBUG("GPS context too small: %dx%d", w, h);
 		goto exit_free;
 	}
 
-	for (i = 0; i < ctx->nr_entry; i++) {
-		ctx->entries[i] = calloc(1, sizeof(struct gps_context_entry));
-		if (ctx->entries[i] == NULL) {
-			SYSERR("Failed to allocate for gps entry");
-			goto exit_free_entry;
-		}
-		ctx->entries[i]->color = svgalib_get_color(0, 0, 0);
+	ctx->entries = calloc(ctx->nr_entry,
+			      sizeof(struct gps_context_entry));
+	if (ctx->entries == NULL) {
+		SYSERR("Failed to allocate for gps context entries");
+		goto exit_free;
 	}
 
 	*out = GL_FRAME(ctx);
 	return 0;
 
- exit_free_entry:
-	for (i = 0; i < ctx->nr_entry; i++) {
-		struct gps_context_entry *entry = ctx->entries[i];
-		if (entry)
-			free(entry);
-	}
  exit_free:
 	free(ctx);
  exit:
@@ -132,33 +184,37 @@ void gps_context_change_header(struct gl_frame *frm,
 			       const char *header, int color)
 {
 	struct gps_context *ctx = (struct gps_context *)frm;
-	ctx->header = header;
+	if (strncmp(ctx->header, header, HEADER_LEN - 1) == 0 &&
+	    ctx->hdr_color == color)
+		return;
+	snprintf(ctx->header, HEADER_LEN, "%s", header);
 	ctx->hdr_color = color;
+	ctx->hdr_changed = 1;
 }
 
 void gps_context_add_entry(struct gl_frame *frm, const char *txt, int color)
 {
 	struct gps_context *ctx = (struct gps_context *)frm;
-	int index = ctx->curr_index;
-	register int i;
+	struct gps_context_entry *entry = NULL;
 	int nr_chars = (frm->width - 8) >> 3;
 
-	/* append new text at the bottom */
-	if (index >= ctx->nr_entry) {
-		index = ctx->nr_entry - 1;
-		for (i = 1; i <= index; i++)
-			memmove(ctx->entries[i - 1], ctx->entries[i],
-				sizeof(struct gps_context_entry));
+	/* Append new text at the bottom, oldest line is dropped once full */
+	if (ctx->count < ctx->nr_entry) {
+		entry = gps_context_line(ctx, ctx->count++);
+	} else {
+		entry = &ctx->entries[ctx->head];
+		ctx->head = (ctx->head + 1) % ctx->nr_entry;
 	}
+	if (ctx->nr_new < ctx->nr_entry)
+		ctx->nr_new++;
 
-	strncpy(ctx->entries[index]->txt, txt, NMEA_STRING_LEN);
-	ctx->entries[index]->color = color;
+	strncpy(entry->txt, txt, NMEA_STRING_LEN);
+	entry->color = color;
 
 	if (nr_chars > NMEA_STRING_LEN)
 		nr_chars = NMEA_STRING_LEN - 1;
 
 	/* Truncate string otherwise disvplay goes out of screen. */
-	ctx->entries[index]->txt[nr_chars] = '\0';
-	ctx->entries[index]->txt[nr_chars - 1] = '~';
-	ctx->curr_index = ++index;
+	entry->txt[nr_chars] = '\0';
+	entry->txt[nr_chars - 1] = '~';
 }
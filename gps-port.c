@@ -0,0 +1,151 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "gps-port.h"
+#include "gps.h"
+#include "serial.h"
+#include "nmea-ring.h"
+#include "nmea-parse.h"
+#include "novatel.h"
+#include "debug.h"
+
+char gps_port_name[GPS_PORT_NAME_LEN] = "/dev/ttyS0";
+int gps_port_baudrate = 9600;
+
+/* Receiver port, its receive buffer and parser states */
+struct gps_port {
+	serial_port_t *port;
+	int descriptor;
+	struct nmea_ring ring;
+	struct nmea_parser parser;
+	struct novatel_decoder decoder;
+};
+
+static struct gps_port in_port = { .port = NULL, .descriptor = -1 };
+
+int gps_port_start(void)
+{
+	serial_port_t *port = NULL;
+
+	if (serial_open(&port, gps_port_name) != 0) {
+		DEBUG("Failed to open GPS port: %s", gps_port_name);
+		goto exit;
+	}
+
+	if (serial_configure(port, gps_port_baudrate, 8, STOPBITS_ONE,
+			     PARITY_NONE, FLOWCONTROL_NONE, 0) != 0) {
+		DEBUG("Failed to configure GPS port: %s", gps_port_name);
+		goto exit_close;
+	}
+
+	nmea_ring_init(&in_port.ring);
+	nmea_ring_set_framer(&in_port.ring, NOVATEL_SYNC0, novatel_frame_len);
+	nmea_parser_init(&in_port.parser);
+	novatel_decoder_init(&in_port.decoder);
+	in_port.port = port;
+	in_port.descriptor = serial_port_descriptor(port);
+	return 0;
+
+ exit_close:
+	serial_close(port);
+ exit:
+	return -1;
+}
+
+void gps_port_stop(void)
+{
+	const struct nmea_stats *st = &in_port.parser.stats;
+	const struct novatel_stats *nt = &in_port.decoder.stats;
+
+	if (in_port.port == NULL)
+		return;
+
+	INFO("GPS sentences %lu, bad frame %lu, bad checksum %lu, "
+	     "overruns %lu", st->sentences, st->bad_frame,
+	     st->bad_checksum, in_port.ring.overruns);
+	INFO("GPS binary frames %lu, bad CRC %lu, unknown %lu",
+	     nt->frames, nt->bad_crc, nt->unknown);
+	serial_close(in_port.port);
+	in_port.port = NULL;
+	in_port.descriptor = -1;
+}
+
+int gps_port_descriptor(void)
+{
+	return in_port.descriptor;
+}
+
+int gps_port_write(const void *buf, size_t size)
+{
+	if (in_port.port == NULL) {
+		DEBUG("GPS port not open.");
+		return -1;
+	}
+	return serial_write(in_port.port, buf, size, NULL);
+}
+
+/*
+ * Frames are cut out of the lines, but bytes of one cut short, e.g. at
+ * start, may still lead a line. Skip to its last sentence, log or reply
+ * start, the latter including a port name prefix as in [COM1]<OK.
+ */
+static const char *gps_port_line_start(const char *s, size_t len)
+{
+	const char *p = s + len;
+
+	while (p > s) {
+		p--;
+		if (*p == '$' || *p == '#')
+			return p;
+		if (*p != '<')
+			continue;
+		if (p > s && p[-1] == ']') {
+			const char *q = p - 1;
+
+			while (q > s && *q != '[')
+				q--;
+			if (*q == '[')
+				return q;
+		}
+		return p;
+	}
+	return s;
+}
+
+int gps_port_acquire(struct gps_data *gps, gps_port_line_t fn,
+		     void *userdata)
+{
+	struct gps_port *gp = &in_port;
+	struct nmea_view v;
+	int updated = 0;
+
+	if (gp->port == NULL)
+		return -1;
+
+	if (nmea_ring_fill(&gp->ring, gp->descriptor) < 0)
+		return -1;
+
+	while (nmea_ring_next(&gp->ring, &v)) {
+		const char *s;
+
+		if (v.frame) {
+			if (novatel_decode(&gp->decoder, gps, v.s, v.len) &
+			    NOVATEL_POS_UPDATE)
+				updated = 1;
+			continue;
+		}
+
+		s = gps_port_line_start(v.s, v.len);
+
+		v.len -= s - v.s;
+		v.s = s;
+		if (*v.s != '$') {
+			if (fn)
+				fn(v.s, userdata);
+			continue;
+		}
+		if (nmea_parse(&gp->parser, gps, v.s, v.len) == NMEA_GGA)
+			updated = 1;
+	}
+	return updated;
+}
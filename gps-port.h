@@ -0,0 +1,35 @@
+#ifndef GPS_PORT_H_INCLUDED
+#define GPS_PORT_H_INCLUDED
+
+#include <stddef.h>
+
+#define GPS_PORT_NAME_LEN	64
+
+struct gps_data;
+
+/* Tunables read from configuration file, see config.c */
+extern char gps_port_name[GPS_PORT_NAME_LEN];
+extern int gps_port_baudrate;
+
+/* Line from receiver that is no NMEA sentence, e.g. a command reply */
+typedef void (*gps_port_line_t)(const char *line, void *userdata);
+
+extern int gps_port_start(void);
+
+extern void gps_port_stop(void);
+
+/* Descriptor to wait on for input, -1 when port is not open */
+extern int gps_port_descriptor(void);
+
+extern int gps_port_write(const void *buf, size_t size);
+
+/**
+ * Read what is pending on the port into its nmea_ring. NovAtel binary
+ * frames it cuts out are decoded, of the lines left complete sentences
+ * are parsed into @gps and other lines go to @fn.
+ * Returns 1 when GGA got updated, 0 when not and -1 on port error.
+ */
+extern int gps_port_acquire(struct gps_data *gps, gps_port_line_t fn,
+			    void *userdata);
+
+#endif	/* GPS_PORT_H_INCLUDED */
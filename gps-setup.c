@@ -0,0 +1,170 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "gps-setup.h"
+#include "gps-port.h"
+#include "timing.h"
+#include "debug.h"
+
+/* Commands written ahead of their replies */
+#define GPS_SETUP_WINDOW	8
+
+char gps_setup_commands[GPS_SETUP_CMD_MAX][GPS_SETUP_CMD_LEN] = {
+	"UNLOGALL THISPORT",
+	"SBASCONTROL DISABLE",
+	"ASSIGNOMNI USER 1539932500 1200",
+	"RTKSOURCE OMNISTAR",
+	"PSRDIFFSOURCE OMNISTAR",
+	"LOG BESTPOSB ONTIME 0.2",
+	"LOG BESTVELB ONTIME 0.5",
+	"LOG TIMEB ONTIME 10",
+};
+int gps_setup_nr_commands = 8;
+int gps_setup_timeout = 1000;
+int gps_setup_retries = 3;
+
+void gps_setup_init(struct gps_setup *gs,
+		    gps_setup_report_t report, void *userdata)
+{
+	memset(gs, 0, sizeof(struct gps_setup));
+	gs->report = report;
+	gs->userdata = userdata;
+}
+
+/* 1 for <OK, -1 for <ERROR, 0 for any other line */
+static int gps_setup_reply(const char *line)
+{
+	/* Replies may be prefixed by port name, e.g. [COM1]<OK */
+	if (*line == '[') {
+		line = strchr(line, ']');
+		if (line == NULL)
+			return 0;
+		line++;
+	}
+
+	if (strncmp(line, "<OK", 3) == 0)
+		return 1;
+	if (strncmp(line, "<ERROR", 6) == 0)
+		return -1;
+	return 0;
+}
+
+static void gps_setup_report(struct gps_setup *gs, int i,
+			     gps_setup_event_t ev)
+{
+	if (gs->report)
+		gs->report(gps_setup_commands[i], ev, gs->userdata);
+}
+
+static void gps_setup_send(struct gps_setup *gs, int i)
+{
+	char buff[GPS_SETUP_CMD_LEN + 2];
+	int len;
+
+	len = snprintf(buff, sizeof(buff), "%s\r\n", gps_setup_commands[i]);
+	gps_port_write(buff, len);
+	gps_setup_report(gs, i, GPS_SETUP_SENT);
+}
+
+/* Replies counted so far are known to be the right ones, report them */
+static void gps_setup_confirm(struct gps_setup *gs)
+{
+	for (; gs->confirmed < gs->acked; gs->confirmed++) {
+		if (!(gs->rejected & (1U << gs->confirmed)))
+			continue;
+		WARN("GPS command rejected: %s",
+		     gps_setup_commands[gs->confirmed]);
+		gps_setup_report(gs, gs->confirmed, GPS_SETUP_REJECTED);
+		gs->failed++;
+	}
+}
+
+/* Ignore input until the receiver stays quiet for a timeout */
+static void gps_setup_drain(struct gps_setup *gs, unsigned long now)
+{
+	gs->state = GPS_SETUP_DRAIN;
+	gs->sent = gs->acked = gs->confirmed;
+	gs->rejected &= (1U << gs->confirmed) - 1;
+	gs->deadline = now + gps_setup_timeout;
+}
+
+static void gps_setup_answer(struct gps_setup *gs, int reply,
+			     unsigned long now)
+{
+	if (reply < 0)
+		gs->rejected |= 1U << gs->acked;
+	gs->acked++;
+	gs->retries = 0;
+	gs->deadline = now + gps_setup_timeout;
+
+	/*
+	 * Replies carry no command, so a lost one shifts all later ones.
+	 * Counting is trusted only once every written command is answered.
+	 */
+	if (gs->acked == gs->sent)
+		gps_setup_confirm(gs);
+}
+
+static void gps_setup_expire(struct gps_setup *gs, unsigned long now)
+{
+	int i = gs->confirmed;
+
+	if (gs->state == GPS_SETUP_PIPELINE) {
+		/* Some reply got lost, find out which one by one */
+		DEBUG("GPS replies missing, writing commands one by one");
+	} else if (gs->retries < gps_setup_retries) {
+		DEBUG("GPS command timed out: %s", gps_setup_commands[i]);
+		gs->retries++;
+	} else {
+		WARN("GPS command not answered: %s", gps_setup_commands[i]);
+		gps_setup_report(gs, i, GPS_SETUP_TIMEOUT);
+		gs->failed++;
+		gs->retries = 0;
+		gs->acked = gs->confirmed = i + 1;
+	}
+
+	/* A late reply must not be taken for the one of a command resent */
+	gps_setup_drain(gs, now);
+}
+
+int gps_setup_update(struct gps_setup *gs, const char *line)
+{
+	unsigned long now = timing_now_ms();
+	int nr = gps_setup_nr_commands;
+	int reply = line ? gps_setup_reply(line) : 0;
+	int window;
+
+	if (gs->done)
+		return 0;
+
+	if (gs->state == GPS_SETUP_DRAIN) {
+		if (reply)
+			gs->deadline = now + gps_setup_timeout;
+		else if (timing_after_eq(now, gs->deadline))
+			gs->state = GPS_SETUP_STEP;
+	} else if (reply && gs->acked < gs->sent) {
+		gps_setup_answer(gs, reply, now);
+	} else if (gs->acked < gs->sent &&
+		   timing_after_eq(now, gs->deadline)) {
+		gps_setup_expire(gs, now);
+	}
+
+	if (gs->state == GPS_SETUP_DRAIN)
+		return 0;
+
+	window = gs->state == GPS_SETUP_STEP ? 1 : GPS_SETUP_WINDOW;
+	while (gs->sent < nr && gs->sent - gs->acked < window) {
+		if (gs->sent == gs->acked)
+			gs->deadline = now + gps_setup_timeout;
+		gps_setup_send(gs, gs->sent);
+		gs->sent++;
+	}
+
+	if (gs->confirmed >= nr) {
+		INFO("GPS configured, %d of %d commands failed",
+		     gs->failed, nr);
+		gs->done = 1;
+		return 1;
+	}
+	return 0;
+}
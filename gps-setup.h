@@ -0,0 +1,67 @@
+#ifndef GPS_SETUP_H_INCLUDED
+#define GPS_SETUP_H_INCLUDED
+
+#define GPS_SETUP_CMD_MAX	16
+#define GPS_SETUP_CMD_LEN	80
+
+/* Tunables read from configuration file, see config.c */
+extern char gps_setup_commands[GPS_SETUP_CMD_MAX][GPS_SETUP_CMD_LEN];
+extern int gps_setup_nr_commands;
+extern int gps_setup_timeout;
+extern int gps_setup_retries;
+
+typedef enum {
+	GPS_SETUP_SENT,		/* command written, or again after timeout */
+	GPS_SETUP_REJECTED,	/* receiver replied <ERROR */
+	GPS_SETUP_TIMEOUT,	/* no reply after all retries */
+} gps_setup_event_t;
+
+typedef void (*gps_setup_report_t)(const char *cmd, gps_setup_event_t ev,
+				   void *userdata);
+
+typedef enum {
+	GPS_SETUP_PIPELINE,	/* written ahead up to a window */
+	GPS_SETUP_DRAIN,	/* reply missed, waiting for quiet input */
+	GPS_SETUP_STEP,		/* one command at a time */
+} gps_setup_state_t;
+
+/**
+ * Receiver configuration in flight. Commands are written ahead up to
+ * a window and matched in order with <OK or <ERROR replies. Replies
+ * don't name their command, so results are taken only once all
+ * written commands got answered. A missing reply makes the rest be
+ * written again one at a time, after the input went quiet, and every
+ * later timeout waits for quiet input before writing again as well.
+ */
+struct gps_setup {
+	gps_setup_state_t state;
+	int sent;		/* commands written */
+	int acked;		/* replies counted */
+	int confirmed;		/* commands with a result known */
+	unsigned int rejected;	/* bit per command replied <ERROR */
+	int retries;		/* of oldest outstanding command */
+	unsigned long deadline;	/* reply or quiet input due, see
+				   timing_now_ms() */
+	int failed;		/* commands rejected or given up */
+	unsigned int done : 1;
+	gps_setup_report_t report;
+	void *userdata;
+};
+
+extern void gps_setup_init(struct gps_setup *gs,
+			   gps_setup_report_t report, void *userdata);
+
+/**
+ * Match received @line as reply, then write or rewrite due commands.
+ * Called with NULL @line from a periodic tick as well, so that commands
+ * time out without any input. Returns non zero once, when the last
+ * command got answered or given up.
+ */
+extern int gps_setup_update(struct gps_setup *gs, const char *line);
+
+static inline int gps_setup_failed(const struct gps_setup *gs)
+{
+	return gs->failed;
+}
+
+#endif	/* GPS_SETUP_H_INCLUDED */
@@ -2,7 +2,7 @@
 
 #define ICON_DATA_MAX	(ICON_WIDTH * ICON_HEIGHT)
 
-static int icon_aircraft_data[ICON_DATA_MAX] = {
+static const unsigned char icon_aircraft_data[ICON_DATA_MAX] = {
 	0, 0, 0, 0, 0, 0, 3, 3, 3, 3, 3, 3, 3, 3, 0, 0, 0, 0, 0, 0,
 	0, 0, 0, 0, 0, 0, 0, 0, 0, 3, 3, 0, 0, 0, 0, 0, 0, 0, 0, 0,
 	0, 0, 0, 0, 0, 0, 0, 0, 3, 4, 4, 3, 0, 0, 0, 0, 0, 0, 0, 0,
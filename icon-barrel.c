@@ -2,7 +2,7 @@
 
 #define ICON_DATA_MAX	(ICON_WIDTH * ICON_HEIGHT)
 
-static int icon_barrel_data[ICON_DATA_MAX] = {
+static const unsigned char icon_barrel_data[ICON_DATA_MAX] = {
 	0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0,
 	0, 0, 0, 1, 1, 3, 3, 3, 3, 3, 3, 3, 3, 3, 1, 1, 0, 0, 0, 0,
 	0, 0, 1, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 1, 0, 0, 0,
@@ -2,7 +2,7 @@
 
 #define ICON_DATA_MAX	(ICON_WIDTH * ICON_HEIGHT)
 
-static int icon_camp_data[ICON_DATA_MAX] = {
+static const unsigned char icon_camp_data[ICON_DATA_MAX] = {
 	0, 0, 0, 0, 0, 0, 0, 0, 0, 5, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
 	0, 0, 0, 0, 0, 0, 0, 0, 0, 5, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
 	0, 0, 0, 0, 0, 0, 0, 0, 5, 6, 5, 0, 0, 0, 0, 0, 0, 0, 0, 0,
@@ -2,7 +2,7 @@
 
 #define ICON_DATA_MAX	(ICON_WIDTH * ICON_HEIGHT)
 
-static int icon_flag_data[ICON_DATA_MAX] = {
+static const unsigned char icon_flag_data[ICON_DATA_MAX] = {
 	0, 3, 3, 3, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
 	0, 3, 3, 3, 3, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
 	0, 3, 3, 3, 3, 3, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
@@ -2,7 +2,7 @@
 
 #define ICON_DATA_MAX	(ICON_WIDTH * ICON_HEIGHT)
 
-static int icon_powerline_data[ICON_DATA_MAX] = {
+static const unsigned char icon_powerline_data[ICON_DATA_MAX] = {
 	0, 0, 0, 0, 0, 0, 0, 0, 0, 7, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
 	0, 0, 0, 0, 0, 0, 0, 0, 0, 7, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
 	0, 0, 0, 0, 0, 0, 0, 7, 7, 2, 7, 7, 0, 0, 0, 0, 0, 0, 0, 0,    
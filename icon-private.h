@@ -12,7 +12,7 @@ struct icon {
 	icon_t	name;
 	int	width;
 	int	height;
-	void *	data;
+	const unsigned char *data;	/* palette indexes, row major */
 };
 
 extern struct icon	icon_aircraft,
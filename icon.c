@@ -5,6 +5,39 @@
 #include "internals.h"
 #include "geometry.h"
 
+#define ICONS_NR	(ICON_HOME + 1)
+
+/* Horizontal run of pixels of one color, both ends inclusive */
+struct icon_span {
+	unsigned char row;
+	unsigned char xb, xe;
+	svgalib_pixel_t color;
+};
+
+/* Icon compiled into opaque spans, transparent pixels are dropped */
+struct icon_sprite {
+	int nr;
+	struct icon_span spans[ICON_SIZE];
+};
+
+static struct icon_sprite icon_sprites[ICONS_NR];
+
+/* Palette of icon data, entries resolving to color 0 are transparent */
+static const struct {
+	int r, g, b;
+} icon_palette[] = {
+	{ 0, 0, 0 },		/* black */
+	{ 15, 8, 0 },		/* brown */
+	{ 15, 0, 0 },		/* red */
+	{ 31, 31, 0 },		/* yellow */
+	{ 0, 0, 31 },		/* blue */
+	{ 0, 0, 0 },		/* green */
+	{ 0, 31, 0 },		/* light green */
+	{ 31, 0, 0 },		/* light red */
+	{ 31, 31, 31 },		/* white */
+	{ 10, 21, 21 },		/* cyan */
+};
+
 static const struct icon *icon_lookup(icon_t name)
 {
 	switch (name) {
@@ -28,92 +61,89 @@ static const struct icon *icon_lookup(icon_t name)
 	return NULL;
 }
 
-void icons_initialize(void)
+static int icon_color(unsigned char index)
 {
-	register int i, k;
-	int color_black = svgalib_get_color(0, 0, 0);
-	int color_brown = svgalib_get_color(15, 8, 0);
-	int color_red = svgalib_get_color(15, 0, 0);
-	int color_yellow = svgalib_get_color(31, 31, 0);
-	int color_blue = svgalib_get_color(0, 0, 31);
-	int color_green = svgalib_get_color(0, 0, 0);
-	int color_light_green = svgalib_get_color(0, 31, 0);
-	int color_light_red = svgalib_get_color(31, 0, 0);
-	int color_white = svgalib_get_color(31, 31, 31);
-	int color_cyan = svgalib_get_color(10, 21, 21);
-	int *icon_data[] = {
-		icon_helitop.data,
-		icon_helifront.data,
-		icon_barrel.data,
-		icon_camp.data,
-		icon_home.data,
-		icon_aircraft.data,
-		icon_flag.data,
-		icon_powerline.data
-	};
-
-	for (i = 0; i < ARRAY_SIZE(icon_data); i++) {
-		for (k = 0; k < ICON_SIZE; k++) {
-			switch (icon_data[i][k]) {
-			default:
-			case 0:
-				icon_data[i][k] = color_black;
-				break;
-			case 1:
-				icon_data[i][k] = color_brown;
-				break;
-			case 2:
-				icon_data[i][k] = color_red;
-				break;
-			case 3:
-				icon_data[i][k] = color_yellow;
-				break;
-			case 4:
-				icon_data[i][k] = color_blue;
-				break;
-			case 5:
-				icon_data[i][k] = color_green;
-				break;
-			case 6:
-				icon_data[i][k] = color_light_green;
-				break;
-			case 7:
-				icon_data[i][k] = color_light_red;
-				break;
-			case 8:
-				icon_data[i][k] = color_white;
-				break;
-			case 9:
-				icon_data[i][k] = color_cyan;
-				break;
-			}
+	if (index >= ARRAY_SIZE(icon_palette))
+		index = 0;
+	return svgalib_get_color(icon_palette[index].r,
+				 icon_palette[index].g,
+				 icon_palette[index].b);
+}
+
+static void icon_compile(const struct icon *icp, struct icon_sprite *spr)
+{
+	register int row, col;
+
+	spr->nr = 0;
+	for (row = 0; row < ICON_HEIGHT; row++) {
+		const unsigned char *data = icp->data + row * ICON_WIDTH;
+
+		for (col = 0; col < ICON_WIDTH; col++) {
+			struct icon_span *span = &spr->spans[spr->nr];
+			int color = icon_color(data[col]);
+
+			if (!color)
+				continue;
+
+			span->row = row;
+			span->xb = col;
+			span->color = color;
+			while (col + 1 < ICON_WIDTH &&
+			       icon_color(data[col + 1]) == color)
+				col++;
+			span->xe = col;
+			spr->nr++;
 		}
 	}
 }
 
+void icons_initialize(void)
+{
+	register int i;
+
+	for (i = 0; i < ICONS_NR; i++) {
+		const struct icon *icp = icon_lookup(i);
+
+		if (icp)
+			icon_compile(icp, &icon_sprites[i]);
+	}
+}
+
 void icon_plot(const struct boundary *b, const struct point *pos, icon_t name)
 {
-	register int i, k;
-	struct point p;
-	int color;
-	const struct icon *icp = NULL;
-	const int *data;
-
-	icp = icon_lookup(name);
-	if (icp == NULL)
+	const struct icon_span *span = NULL;
+	const struct icon_sprite *spr = NULL;
+	int x = pos->x - (ICON_WIDTH >> 1);
+	int y = pos->y - (ICON_HEIGHT >> 1);
+	int i, clip;
+
+	if (name < 0 || name >= ICONS_NR)
 		return;
+	spr = &icon_sprites[name];
 
-	data = (const int *)icp->data;
+	/* Whole icon outside of boundary */
+	if (x > b->east || x + ICON_WIDTH - 1 < b->west ||
+	    y > b->south || y + ICON_HEIGHT - 1 < b->north)
+		return;
+
+	clip = (x < b->west || x + ICON_WIDTH - 1 > b->east ||
+		y < b->north || y + ICON_HEIGHT - 1 > b->south);
 
-	for (i = 0; i < ICON_WIDTH; i++) {
-		p.x = i + pos->x - 10;
+	for (i = 0, span = spr->spans; i < spr->nr; i++, span++) {
+		int yp = y + span->row;
+		int xb = x + span->xb;
+		int xe = x + span->xe;
 
-		for (k = 0; k < ICON_HEIGHT; k++) {
-			p.y = k + pos->y - 10;
-			color = data[i + ICON_HEIGHT * k];
-			if (!is_point_inside_boundary(b, &p) || !color)
+		if (clip) {
+			if (yp < b->north || yp > b->south)
+				continue;
+			if (xb < b->west)
+				xb = b->west;
+			if (xe > b->east)
+				xe = b->east;
+			if (xb > xe)
 				continue;
-			svgalib_set_pixel(p.x, p.y, color);
 		}
+		svgalib_draw_hline(xb, yp, xe, span->color);
 	}
 }
@@ -39,6 +39,7 @@ int gl_label_create(struct gl_frame **out,
 	gl_frame_init(&label->frame, x, y, w, h, color);
 	label->frame.draw = gl_label_show;
 	label->frame.destroy = gl_label_destroy;
+	gl_frame_memoize(&label->frame);
 
 	*out = GL_FRAME(label);
 	return 0;
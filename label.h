@@ -1,6 +1,8 @@
 #ifndef GL_LABEL_H_INCLUDED
 #define GL_LABEL_H_INCLUDED
 
+#include <string.h>
+
 #include "frame.h"
 #include "font/font.h"
 
@@ -17,23 +19,33 @@ struct gl_label {
 extern int gl_label_create(struct gl_frame **out,
 			   int x, int y, int w, int h, int color);
 
+/* Text is not copied, a changed string has to come in another buffer */
 static inline void gl_label_set_text(struct gl_label *label, const char *text)
 {
+	if (label->text != text &&
+	    (label->text == NULL || text == NULL || strcmp(label->text, text)))
+		gl_frame_changed(&label->frame);
 	label->text = text;
 }
 
 static inline void gl_label_set_color(struct gl_label *label, int color)
 {
+	if (label->color != color)
+		gl_frame_changed(&label->frame);
 	label->color = color;
 }
 
 static inline void gl_label_set_font(struct gl_label *label, font_t font)
 {
+	if (label->font != font)
+		gl_frame_changed(&label->frame);
 	label->font = font;
 }
 
 static inline void gl_label_set_border_width(struct gl_label *label, int border)
 {
+	if (label->border != border)
+		gl_frame_changed(&label->frame);
 	label->border = border;
 }
 
@@ -2,6 +2,7 @@
 #include <string.h>
 #include <ctype.h>
 #include <time.h>
+#include <math.h>
 
 #include "main-context.h"
 #include "svgalib.h"
@@ -14,14 +15,12 @@
 #include "flight.h"
 #include "keyboard.h"
 #include "simulant.h"
+#include "gps-setup.h"
 
 
-typedef enum main_frame_view_t {
-	VIEW_MAG_CONTEXT,
-	VIEW_GPS_CONTEXT,
-	VIEW_FILE_CONTEXT,
-	VIEW_MAP_CONTEXT
-} main_frame_view_t;
+/* Top left corner of timing overlay */
+#define DIAGNOSTICS_X	8
+#define DIAGNOSTICS_Y	8
 
 struct graphics_context {
 	GraphicsContext *context;
@@ -45,93 +44,109 @@ struct graphics_context {
 	struct gl_frame *gps_context;
 	struct gl_frame *file_list;
 	struct gl_frame *profile_frame;
+	struct list_head frames;
+	const struct gps_data *gps;	/* fed to console and profile */
+	const struct mag_data *mag;
 	main_frame_view_t main_view;
 	unsigned int mag_disable;
+	unsigned int diagnostics;
+	struct timing_hist render_timing;
+	struct timing_hist show_timing;
 };
 
-static const char *cmd_list[] = {
-	"UNLOGALL THISPORT",
-	"SBASCONTROL DISABLE",
-	"ASSIGNOMNI USER 1539932500 1200",
-	"RTKSOURCE OMNISTAR",
-	"PSRDIFFSOURCE OMNISTAR",
-	"LOG GPGGA ONTIME 0.2",
-	NULL
-};
+static void gps_setup_callback(const char *cmd, gps_setup_event_t ev,
+			       void *userdata)
+{
+	struct gl_frame *frm = (struct gl_frame *)userdata;
+	char buff[128] = "";
+
+	switch (ev) {
+	case GPS_SETUP_SENT:
+		gps_context_add_entry(frm, cmd, svgalib_get_color(15, 15, 0));
+		break;
+	case GPS_SETUP_REJECTED:
+		snprintf(buff, 128, "Rejected: %s", cmd);
+		gps_context_add_entry(frm, buff, svgalib_get_color(31, 0, 0));
+		break;
+	case GPS_SETUP_TIMEOUT:
+		snprintf(buff, 128, "No reply: %s", cmd);
+		gps_context_add_entry(frm, buff, svgalib_get_color(31, 0, 0));
+		break;
+	}
+}
 
-static void gps_context_callback(struct gl_frame *frm, const void *data)
+void graphics_gps_setup_init(struct graphics_context *gc,
+			     struct gps_setup *gs)
 {
-	static const char **pcmd = cmd_list;
-	const struct gps_data *gps = (const struct gps_data *)data;
+	gps_setup_init(gs, gps_setup_callback, gc->gps_context);
+}
 
-	gps_context_add_entry(frm, gps->nmea_string,
-			      svgalib_get_color(0, 20, 0));
-	if (*pcmd != NULL) {
-		char buff[128] = "";
+void graphics_gps_setup_done(struct graphics_context *gc,
+			     const struct gps_setup *gs)
+{
+	char buff[64] = "";
 
-		snprintf(buff, 128, "%s\r\n", *pcmd);
-		gps_device_write(buff, strlen(buff));
-		gps_context_add_entry(frm, *pcmd, svgalib_get_color(15, 15, 0));
-		if (*++pcmd == NULL)
-		gps_context_change_header(frm, "GPS Configured :-) ",
+	if (gps_setup_failed(gs) == 0) {
+		gps_context_change_header(gc->gps_context,
+					  "GPS Configured :-) ",
 					  svgalib_get_color(0, 31, 0));
+	} else {
+		snprintf(buff, 64, "GPS Config: %d failed :-( ",
+			 gps_setup_failed(gs));
+		gps_context_change_header(gc->gps_context, buff,
+					  svgalib_get_color(31, 0, 0));
 	}
 }
 
-static int scale_bar_color_callback_AGL_altitude(int curr, int mid,
+static int scale_bar_color_callback_AGL_altitude(int value, int highlight,
 						 const void *data)
 {
-	int scaled = (mid - curr) / 5 + *(const double *)data;
 	int color = svgalib_get_color(5, 5, 5);
 
-	if ((scaled > survey_height_AGL && curr > mid) ||
-	    (scaled <= survey_height_AGL && curr < mid))
+	if (highlight)
 		color = svgalib_get_color(0, 20, 0);
 
-	if (abs(scaled - survey_height_AGL) <= 10)
+	if (fabs(value - survey_height_AGL) <= 10)
 		color = svgalib_get_color(0, 31, 0);
 
-	if (scaled >= 0 && scaled <= warning_height_AGL)
+	if (value >= 0 && value <= warning_height_AGL)
 		color = svgalib_get_color(31, 0, 0);
 
-	if (scaled % 10 == 0)
+	if (value % 10 == 0)
 		color = svgalib_get_color(10, 10, 10);
 
 	return color;
 }
 
-static int scale_bar_color_callback_MSL_altitude(int curr, int mid,
+static int scale_bar_color_callback_MSL_altitude(int value, int highlight,
 						 const void *data)
 {
-	int scaled = (mid - curr) / 5 + *(const double *)data;
 	int color = svgalib_get_color(5, 5, 5);
 
-	if ((scaled > HAC_height_MSL && curr > mid) ||
-	    (scaled <= HAC_height_MSL && curr < mid))
+	if (highlight)
 		color = svgalib_get_color(0, 20, 0);
 
-	if (abs(scaled - HAC_height_MSL) <= 10)
+	if (fabs(value - HAC_height_MSL) <= 10)
 		color = svgalib_get_color(0, 31, 0);
 
-	if (scaled % 10 == 0)
+	if (value % 10 == 0)
 		color = svgalib_get_color(10, 10, 10);
 
 	return color;
 }
 
-static int scale_bar_color_callback_tracking(int curr, int mid,
+static int scale_bar_color_callback_tracking(int value, int highlight,
 					     const void *data)
 {
-	int scaled = (curr - mid) / 5 - (*(const double *)data) + 360;
 	int color = svgalib_get_color(5, 5, 5);
 
-	if ((scaled > 360 && curr < mid) || (scaled <= 360 && curr > mid))
+	if (highlight)
 		color = svgalib_get_color(0, 20, 0);
 
-	if (abs(scaled - 360) <= 10)
+	if (abs(value - 360) <= 10)
 		color = svgalib_get_color(0, 31, 0);
 
-	if (scaled % 10 == 0)
+	if (value % 10 == 0)
 		color = svgalib_get_color(10, 10, 10);
 
 	return color;
@@ -152,6 +167,7 @@ static void scale_bar_tracking_callback(struct gl_frame *frm, const void *data)
 
 	sprintf(buff, "%-+.0lf", tracking);
 	gl_scale_bar_set_text(sbar, buff, strlen(buff));
+	gl_scale_bar_set_value(sbar, 360 - cp->tracking);
 	INFO("Tracking: %s", buff);
 }
 
@@ -165,29 +181,23 @@ static void scale_bar_altitude_callback(struct gl_frame *frm, const void *data)
 	gl_scale_bar_set_text(sbar, buff, strlen(buff));
 	INFO("Altitude: %s", buff);
 
+	gl_scale_bar_set_value(sbar, flt->altitude);
+
 	if (flt->at_AGL_height) {
 		gl_scale_bar_set_pointer_color(sbar,
 					       svgalib_get_color(0, 10, 0));
 		gl_scale_bar_set_color_callback(sbar,
-			scale_bar_color_callback_AGL_altitude, &flt->altitude);
-
+			scale_bar_color_callback_AGL_altitude, NULL);
+		gl_scale_bar_set_reference(sbar, survey_height_AGL);
 	} else {
 		gl_scale_bar_set_pointer_color(sbar,
 					       svgalib_get_color(5, 15, 15));
 		gl_scale_bar_set_color_callback(sbar,
-			scale_bar_color_callback_MSL_altitude, &flt->altitude);
+			scale_bar_color_callback_MSL_altitude, NULL);
+		gl_scale_bar_set_reference(sbar, HAC_height_MSL);
 	}
 }
 
-static void profile_view_callback(struct gl_frame *frm, const void *data)
-{
-	const struct mag_data *mag = (const struct mag_data *)data;
-	struct gl_profile_view *pv = (struct gl_profile_view *)frm;
-
-	/* Convert into unit into picoTesla for clarity */
-	gl_profile_view_add_sample(pv, 0, mag->field_value * 1000);
-}
-
 static void compass_callback(struct gl_frame *frm, const void *data)
 {
 	const struct flight_data *flt = (const struct flight_data *)data;
@@ -384,6 +394,35 @@ static void data_box_next_target_callback(struct gl_frame *frm,
 	data_box_set_text(dbox, buff, strlen(buff));
 }
 
+static void graphics_register(struct graphics_context *gc,
+			      struct gl_frame *frm, const char *name)
+{
+	if (frm == NULL)
+		return;
+	gl_frame_set_name(frm, name);
+	gl_frame_register(&gc->frames, frm);
+}
+
+void graphics_set_view(struct graphics_context *gc, main_frame_view_t view)
+{
+	gc->main_view = view;
+	gl_frame_set_visible(gc->gps_context, view == VIEW_GPS_CONTEXT);
+	gl_frame_set_visible(gc->file_list, view == VIEW_FILE_CONTEXT);
+	gl_frame_set_visible(gc->profile_frame, view == VIEW_MAG_CONTEXT);
+	gl_frame_set_visible(gc->map_area, view == VIEW_MAP_CONTEXT);
+}
+
+/* GPS position boxes share screen space with MAG boxes */
+static void graphics_set_mag_disable(struct graphics_context *gc,
+				     unsigned int disable)
+{
+	gc->mag_disable = disable;
+	gl_frame_set_visible(gc->data_box_gpslat, disable);
+	gl_frame_set_visible(gc->data_box_gpslon, disable);
+	gl_frame_set_visible(gc->data_box_mag, !disable);
+	gl_frame_set_visible(gc->data_box_space, !disable);
+}
+
 int graphics_context_init(struct graphics_context **out,
 			  const struct course *cp,
 			  const struct flight_data *flt,
@@ -404,6 +443,11 @@ int graphics_context_init(struct graphics_context **out,
 		DEBUG("svgalib_virtual_context_create() failed.");
 		goto exit_free;
 	}
+	gc->diagnostics = 0;
+	gc->gps = gps;
+	gc->mag = mag;
+	timing_hist_reset(&gc->render_timing);
+	timing_hist_reset(&gc->show_timing);
 
 	sbar_width = CTX_HEIGHT >> 3;
 	footer_height = sbar_width >> 1;
@@ -432,7 +476,9 @@ int graphics_context_init(struct graphics_context **out,
 				    txtcolor);
 	gl_scale_bar_set_color_callback(GL_SCALE_BAR(gc->scale_bar_altitude),
 					scale_bar_color_callback_AGL_altitude,
-					&flt->altitude);
+					NULL);
+	gl_scale_bar_set_reference(GL_SCALE_BAR(gc->scale_bar_altitude),
+				   survey_height_AGL);
 	gl_frame_add_callback(gc->scale_bar_altitude, RC_FLIGHT_UPDATE,
 			      scale_bar_altitude_callback, flt);
 
@@ -447,7 +493,9 @@ int graphics_context_init(struct graphics_context **out,
 				    txtcolor);
 	gl_scale_bar_set_color_callback(GL_SCALE_BAR(gc->scale_bar_tracking),
 					scale_bar_color_callback_tracking,
-					&cp->tracking);
+					NULL);
+	gl_scale_bar_set_reference(GL_SCALE_BAR(gc->scale_bar_tracking), 360);
+	gl_scale_bar_set_value(GL_SCALE_BAR(gc->scale_bar_tracking), 360);
 	gl_frame_add_callback(gc->scale_bar_tracking, RC_COURSE_UPDATE,
 			      scale_bar_tracking_callback, cp);
 
@@ -466,14 +514,16 @@ int graphics_context_init(struct graphics_context **out,
 			   barcolor,
 			   cp,
 			   flt);
+	gl_frame_set_border(gc->map_area, GL_FRAME_BORDER_ALWAYS);
+	gl_frame_subscribe(gc->map_area, RC_FLIGHT_UPDATE | RC_COURSE_UPDATE |
+			   RC_TARGET_UPDATE | RC_MAP_UPDATE);
 
 	gps_context_create(&gc->gps_context,
 			   sbar_width, sbar_width,
 			   CTX_WIDTH - (sbar_width + x),
 			   CTX_HEIGHT - (sbar_width + footer_height),
 			   barcolor);
-	gl_frame_add_callback(gc->gps_context, RC_GPS_UPDATE,
-			      gps_context_callback, gps);
+	gl_frame_subscribe(gc->gps_context, RC_GPS_UPDATE);
 
 	file_chooser_create(&gc->file_list,
 			    sbar_width,
@@ -481,6 +531,8 @@ int graphics_context_init(struct graphics_context **out,
 			    CTX_WIDTH - (sbar_width + x),
 			    CTX_HEIGHT - (sbar_width + footer_height),
 			    barcolor);
+	gl_frame_set_border(gc->file_list, GL_FRAME_BORDER_ALWAYS);
+	gl_frame_subscribe(gc->file_list, RC_MAP_UPDATE);
 
 	/* Mag profile view */
 	gl_profile_view_create(&gc->profile_frame, sbar_width, sbar_width,
@@ -490,8 +542,7 @@ int graphics_context_init(struct graphics_context **out,
 			       1, CTX_WIDTH - (sbar_width + x),
 			       svgalib_get_color(31, 31, 0),
 			       svgalib_get_color(5, 5, 5));
-	gl_frame_add_callback(gc->profile_frame, RC_MAG_UPDATE,
-			      profile_view_callback, mag);
+	gl_frame_subscribe(gc->profile_frame, RC_MAG_UPDATE);
 	/* Profile color */
 	gl_profile_view_set_color((struct gl_profile_view *)gc->profile_frame, 0,
 				  svgalib_get_color(31, 31, 0));
@@ -521,6 +572,7 @@ int graphics_context_init(struct graphics_context **out,
 	/* Heading data box */
 	data_box_create(&gc->data_box_heading,
 			CTX_WIDTH - x, x, x, y, frmcolor);
+	gl_frame_set_border(gc->data_box_heading, GL_FRAME_BORDER_NONE);
 	data_box_set_split(DATA_BOX(gc->data_box_heading), SPLIT_VERTICAL, 0.5);
 	data_box_set_text_color(DATA_BOX(gc->data_box_heading), txtcolor);
 	data_box_set_caption(DATA_BOX(gc->data_box_heading), "Heading:");
@@ -530,6 +582,7 @@ int graphics_context_init(struct graphics_context **out,
 	/* GS data box */
 	data_box_create(&gc->data_box_GS,
 			CTX_WIDTH - x, x + 1 * y, x, y, frmcolor);
+	gl_frame_set_border(gc->data_box_GS, GL_FRAME_BORDER_NONE);
 	data_box_set_split(DATA_BOX(gc->data_box_GS), SPLIT_VERTICAL, 0.5);
 	data_box_set_text_color(DATA_BOX(gc->data_box_GS), txtcolor);
 	data_box_set_caption(DATA_BOX(gc->data_box_GS), "GS[km/h]:");
@@ -539,6 +592,7 @@ int graphics_context_init(struct graphics_context **out,
 	/* DTG data box */
 	data_box_create(&gc->data_box_DTG, CTX_WIDTH - x,
 			x + 2 * y, x, y, frmcolor);
+	gl_frame_set_border(gc->data_box_DTG, GL_FRAME_BORDER_NONE);
 	data_box_set_split(DATA_BOX(gc->data_box_DTG), SPLIT_VERTICAL, 0.5);
 	data_box_set_text_color(DATA_BOX(gc->data_box_DTG), txtcolor);
 	data_box_set_caption(DATA_BOX(gc->data_box_DTG), "DTG[km]:");
@@ -548,6 +602,7 @@ int graphics_context_init(struct graphics_context **out,
 	/* GPS fix data box */
 	data_box_create(&gc->data_box_gpsfix, CTX_WIDTH - x,
 			x + 3 * y, x, y, frmcolor);
+	gl_frame_set_border(gc->data_box_gpsfix, GL_FRAME_BORDER_NONE);
 	data_box_set_split(DATA_BOX(gc->data_box_gpsfix), SPLIT_VERTICAL, 0.5);
 	data_box_set_text_color(DATA_BOX(gc->data_box_gpsfix), txtcolor);
 	data_box_set_caption(DATA_BOX(gc->data_box_gpsfix), "GPS Fix/Sat:");
@@ -557,6 +612,7 @@ int graphics_context_init(struct graphics_context **out,
 	/* GPS alt data box */
 	data_box_create(&gc->data_box_gpsalt, CTX_WIDTH - x,
 			x + 4 * y, x, y, frmcolor);
+	gl_frame_set_border(gc->data_box_gpsalt, GL_FRAME_BORDER_NONE);
 	data_box_set_split(DATA_BOX(gc->data_box_gpsalt), SPLIT_VERTICAL, 0.5);
 	data_box_set_text_color(DATA_BOX(gc->data_box_gpsalt), txtcolor);
 	data_box_set_caption(DATA_BOX(gc->data_box_gpsalt), "GPS Altitude:");
@@ -566,6 +622,7 @@ int graphics_context_init(struct graphics_context **out,
 	/* GPS lat data box */
 	data_box_create(&gc->data_box_gpslat, CTX_WIDTH - x,
 			x + 5 * y, x, y, frmcolor);
+	gl_frame_set_border(gc->data_box_gpslat, GL_FRAME_BORDER_NONE);
 	data_box_set_split(DATA_BOX(gc->data_box_gpslat), SPLIT_VERTICAL, 0.5);
 	data_box_set_text_color(DATA_BOX(gc->data_box_gpslat), txtcolor);
 	data_box_set_caption(DATA_BOX(gc->data_box_gpslat), "GPS Latitude:");
@@ -575,6 +632,7 @@ int graphics_context_init(struct graphics_context **out,
 	/* Mag data box */
 	data_box_create(&gc->data_box_mag, CTX_WIDTH - x,
 			x + 5 * y, x, y, frmcolor);
+	gl_frame_set_border(gc->data_box_mag, GL_FRAME_BORDER_NONE);
 	data_box_set_split(DATA_BOX(gc->data_box_mag), SPLIT_VERTICAL, 0.5);
 	data_box_set_text_color(DATA_BOX(gc->data_box_mag), txtcolor);
 
@@ -586,6 +644,7 @@ int graphics_context_init(struct graphics_context **out,
 	/* GPS Lon data box */
 	data_box_create(&gc->data_box_gpslon,
 	                CTX_WIDTH - x, x + 6 * y, x, y, frmcolor);
+	gl_frame_set_border(gc->data_box_gpslon, GL_FRAME_BORDER_NONE);
 	data_box_set_split(DATA_BOX(gc->data_box_gpslon), SPLIT_VERTICAL, 0.5);
 	data_box_set_text_color(DATA_BOX(gc->data_box_gpslon), txtcolor);
 
@@ -596,6 +655,7 @@ int graphics_context_init(struct graphics_context **out,
 	/* space data box */
 	data_box_create(&gc->data_box_space,
 			CTX_WIDTH - x, x + 6 * y, x, y, frmcolor);
+	gl_frame_set_border(gc->data_box_space, GL_FRAME_BORDER_NONE);
 	data_box_set_split(DATA_BOX(gc->data_box_space), SPLIT_VERTICAL, 0.5);
 	data_box_set_text_color(DATA_BOX(gc->data_box_space), txtcolor);
 	data_box_set_caption(DATA_BOX(gc->data_box_space), "Disk Space:");
@@ -608,35 +668,39 @@ int graphics_context_init(struct graphics_context **out,
 	gl_label_set_color(GL_LABEL(gc->label_datum), txtcolor);
 	gl_label_set_font(GL_LABEL(gc->label_datum), FONT_SUN12x22);
 	gl_label_set_border_width(GL_LABEL(gc->label_datum), 5);
+	gl_frame_set_border(gc->label_datum, GL_FRAME_BORDER_ALWAYS);
 	gl_frame_add_callback(gc->label_datum, RC_FLIGHT_UPDATE,
 			      label_datum_callback, flt);
 
-	gc->mag_disable = 0;
-	gc->main_view = VIEW_GPS_CONTEXT;
-
-	/* Initial draw */
+	/* Frames are redrawn in the order of registration */
+	INIT_LIST_HEAD(&gc->frames);
+	graphics_register(gc, gc->data_box_mag, "mag");
+	graphics_register(gc, gc->data_box_space, "disk space");
+	graphics_register(gc, gc->data_box_gpslat, "latitude");
+	graphics_register(gc, gc->data_box_gpslon, "longitude");
+	graphics_register(gc, gc->data_box_gpsfix, "gps fix");
+	graphics_register(gc, gc->data_box_gpsalt, "gps altitude");
+	graphics_register(gc, gc->data_box_DTG, "DTG");
+	graphics_register(gc, gc->data_box_heading, "heading");
+	graphics_register(gc, gc->data_box_GS, "ground speed");
+	graphics_register(gc, gc->data_box_curr_target, "curr target");
+	graphics_register(gc, gc->data_box_next_target, "next target");
+	graphics_register(gc, gc->label_datum, "datum");
+	graphics_register(gc, gc->clock, "clock");
+	graphics_register(gc, gc->compass, "compass");
+	graphics_register(gc, gc->scale_bar_altitude, "altitude bar");
+	graphics_register(gc, gc->scale_bar_tracking, "tracking bar");
+	graphics_register(gc, gc->gps_context, "gps console");
+	graphics_register(gc, gc->file_list, "file list");
+	graphics_register(gc, gc->profile_frame, "mag profile");
+	graphics_register(gc, gc->map_area, "map");
+
+	graphics_set_mag_disable(gc, 0);
+	graphics_set_view(gc, VIEW_GPS_CONTEXT);
+
+	/* Initial draw, every frame is still invalidated */
 	svgalib_set_context(gc->context);
-
-	if (gc->mag_disable) {
-		gl_frame_draw(gc->data_box_gpslat, 1);
-		gl_frame_draw(gc->data_box_gpslon, 1);
-	} else {
-		gl_frame_draw(gc->data_box_mag, 1);
-		gl_frame_draw(gc->data_box_space, 1);
-	}
-	gl_frame_draw(gc->data_box_gpsfix, 1);
-	gl_frame_draw(gc->data_box_gpsalt, 1);
-	gl_frame_draw(gc->data_box_DTG, 1);
-	gl_frame_draw(gc->data_box_heading, 1);
-	gl_frame_draw(gc->data_box_GS, 1);
-	gl_frame_draw(gc->data_box_curr_target, 0);
-	gl_frame_draw(gc->data_box_next_target, 0);
-	gl_frame_draw(gc->label_datum, 0);
-	gl_frame_draw(gc->clock, 0);
-	gl_frame_draw(gc->compass, 0);
-	gl_frame_draw(gc->scale_bar_altitude, 0);
-	gl_frame_draw(gc->scale_bar_tracking, 0);
-	gl_frame_draw(gc->gps_context, 0);
+	gl_frame_dispatch(&gc->frames, RC_NONE);
 	svgalib_show_context(gc->context);
 
 	*out = gc;
@@ -648,91 +712,119 @@ int graphics_context_init(struct graphics_context **out,
 	return -1;
 }
 
+/* Feed updates to frames, drawing is left to graphics_render() */
 void graphics_update(struct graphics_context *gc, rc_t rc)
 {
-	if (rc & RC_GPS_UPDATE) {
-		if (gc->mag_disable) {
-			gl_frame_draw(gc->data_box_gpslat, 1);
-			gl_frame_draw(gc->data_box_gpslon, 1);
-		}
-		gl_frame_draw(gc->data_box_gpsfix, 1);
-		gl_frame_draw(gc->data_box_gpsalt, 1);
-		gl_frame_draw(gc->clock, 1);
-	}
+	/*
+	 * Console and profile keep history, so each update is added here
+	 * once, shown or not, rather than by a callback that is run again
+	 * when the frame gets shown.
+	 */
+	if (rc & RC_GPS_UPDATE)
+		gps_context_add_entry(gc->gps_context, gc->gps->nmea_string,
+				      svgalib_get_color(0, 20, 0));
 
-	if (rc & RC_MAG_UPDATE) {
-		if (!gc->mag_disable) {
-			gl_frame_draw(gc->data_box_mag, 1);
-			gl_frame_draw(gc->data_box_space, 1);
-		}
-	}
+	/* Convert into unit into picoTesla for clarity */
+	if (rc & RC_MAG_UPDATE)
+		gl_profile_view_add_sample(
+			(struct gl_profile_view *)gc->profile_frame, 0,
+			gc->mag->field_value * 1000);
 
-	if (rc & RC_FLIGHT_UPDATE) {
-		gl_frame_draw(gc->label_datum, 0);
-		gl_frame_draw(gc->scale_bar_altitude, 1);
-		gl_frame_draw(gc->compass, 1);
-		gl_frame_draw(gc->data_box_heading, 1);
-		gl_frame_draw(gc->data_box_GS, 1);
-	}
+	gl_frame_update(&gc->frames, rc);
+}
 
-	if (rc & RC_TARGET_UPDATE) {
-		gl_frame_draw(gc->data_box_curr_target, 1);
-		gl_frame_draw(gc->data_box_next_target, 1);
-	}
+static void diagnostics_line(int y, const char *name,
+			     const struct gl_frame_timing *t)
+{
+	char buff[80] = "";
+
+	snprintf(buff, 80, "%-13s%8.2f%8.2f%8.2f%8.2f%8.2f%8.2f", name,
+		 timing_hist_percentile(&t->callback, 99) / 1000.0,
+		 timing_hist_max(&t->callback) / 1000.0,
+		 timing_hist_percentile(&t->border, 99) / 1000.0,
+		 timing_hist_max(&t->border) / 1000.0,
+		 timing_hist_percentile(&t->draw, 99) / 1000.0,
+		 timing_hist_max(&t->draw) / 1000.0);
+	svgalib_display_text(DIAGNOSTICS_X + 4, y, buff, FONT_VGA8x8,
+			     svgalib_get_color(0, 0, 0),
+			     svgalib_get_color(31, 63, 31));
+}
 
-	if (rc & RC_COURSE_UPDATE) {
-		gl_frame_draw(gc->scale_bar_tracking, 1);
-		gl_frame_draw(gc->data_box_DTG, 1);
+/* Overlay p99 and worst case timings (ms) of every widget */
+static void graphics_draw_diagnostics(struct graphics_context *gc)
+{
+	struct gl_frame *frm = NULL;
+	struct gl_frame_timing t;
+	int nr = 0, y = DIAGNOSTICS_Y + 4;
+	int w = 61 * 8 + 8;
+
+	list_for_each_entry(frm, &gc->frames, list)
+		nr++;
+
+	svgalib_draw_box_colored(DIAGNOSTICS_X, DIAGNOSTICS_Y, w,
+				 (nr + 3) * 10 + 8,
+				 svgalib_get_color(0, 0, 0));
+	svgalib_damage_box(DIAGNOSTICS_X, DIAGNOSTICS_Y, w, (nr + 3) * 10 + 8);
+
+	svgalib_display_text(DIAGNOSTICS_X + 4, y,
+			     "widget         cb p99  cb max  bd p99  bd max"
+			     "  dr p99  dr max", FONT_VGA8x8,
+			     svgalib_get_color(0, 0, 0),
+			     svgalib_get_color(31, 63, 0));
+	y += 10;
+
+	list_for_each_entry(frm, &gc->frames, list) {
+		diagnostics_line(y, frm->name ? frm->name : "?", &frm->timing);
+		y += 10;
 	}
 
-	switch (gc->main_view) {
-	case VIEW_GPS_CONTEXT:
-		if (rc & RC_GPS_UPDATE)
-			gl_frame_draw(gc->gps_context, 0);
-		break;
-	case VIEW_FILE_CONTEXT:
-		if (rc & RC_MAP_UPDATE)
-			gl_frame_draw(gc->file_list, 0);
-		break;
-	case VIEW_MAG_CONTEXT:
-		gl_frame_draw(gc->profile_frame, 0);
-		break;
-	case VIEW_MAP_CONTEXT:
-		gl_frame_draw(gc->map_area, 0);
-		break;
-	}
+	/* Whole render and screen copy in the draw columns */
+	memset(&t, 0, sizeof(struct gl_frame_timing));
+	t.draw = gc->render_timing;
+	diagnostics_line(y, "render", &t);
+	y += 10;
+	t.draw = gc->show_timing;
+	diagnostics_line(y, "show", &t);
+}
+
+void graphics_render(struct graphics_context *gc)
+{
+	unsigned long t = timing_now();
 
+	gl_frame_render(&gc->frames);
+	if (gc->diagnostics)
+		graphics_draw_diagnostics(gc);
+	timing_hist_add(&gc->render_timing, timing_now() - t);
+
+	t = timing_now();
 	svgalib_show_context(gc->context);
+	timing_hist_add(&gc->show_timing, timing_now() - t);
 }
 
 void graphics_context_destroy(struct graphics_context *gc)
 {
-	gl_frame_destroy(gc->scale_bar_tracking);
-	gl_frame_destroy(gc->scale_bar_altitude);
-	gl_frame_destroy(gc->compass);
-	gl_frame_destroy(gc->clock);
-	gl_frame_destroy(gc->map_area);
-	gl_frame_destroy(gc->gps_context);
-	gl_frame_destroy(gc->file_list);
-	gl_frame_destroy(gc->label_datum);
-	gl_frame_destroy(gc->data_box_curr_target);
-	gl_frame_destroy(gc->data_box_next_target);
-	gl_frame_destroy(gc->data_box_heading);
-	gl_frame_destroy(gc->data_box_GS);
-	gl_frame_destroy(gc->data_box_DTG);
-	gl_frame_destroy(gc->data_box_gpsfix);
-	gl_frame_destroy(gc->data_box_gpsalt);
-	gl_frame_destroy(gc->data_box_gpslat);
-	gl_frame_destroy(gc->data_box_gpslon);
-	gl_frame_destroy(gc->data_box_mag);
-	gl_frame_destroy(gc->data_box_space);
-	gl_frame_destroy(gc->profile_frame);
+	struct gl_frame *frm = NULL, *tmp = NULL;
+
+	list_for_each_entry_safe(frm, tmp, &gc->frames, list) {
+		list_del(&frm->list);
+		gl_frame_destroy(frm);
+	}
 
 	svgalib_virtual_context_destroy(gc->context);
 	free(gc);
 	gc = NULL;
 }
 
+rc_t graphics_load_course(struct graphics_context *gc, struct course *cp,
+			  struct flight_data *flt, const char *file)
+{
+	course_map_load(cp, file);
+	flight_position_default(cp, &flt->position);
+	map_context_invalidate(gc->map_area);
+	graphics_set_view(gc, VIEW_MAP_CONTEXT);
+	return RC_MAP_UPDATE | RC_COURSE_UPDATE | RC_TARGET_UPDATE;
+}
+
 rc_t graphics_controls(struct graphics_context *gc, struct course *cp,
 		       struct flight_data *flt, int key)
 {
@@ -744,17 +836,14 @@ rc_t graphics_controls(struct graphics_context *gc, struct course *cp,
 		break;
 	case KEY_ENTER:
 		if (gc->main_view == VIEW_GPS_CONTEXT) {
-			gc->main_view = VIEW_FILE_CONTEXT;
+			graphics_set_view(gc, VIEW_FILE_CONTEXT);
 			rc |= RC_MAP_UPDATE;
 		} else if (gc->main_view == VIEW_FILE_CONTEXT) {
 			char pgn_file[256] = "";
 			if (!file_chooser_get_file(gc->file_list,
 						   pgn_file, 256)) {
-				course_map_load(cp, pgn_file);
-				flight_position_default(cp, &flt->position);
-				gc->main_view = VIEW_MAP_CONTEXT;
-				rc |= (RC_MAP_UPDATE |
-				       RC_COURSE_UPDATE | RC_TARGET_UPDATE);
+				rc |= graphics_load_course(gc, cp, flt,
+							   pgn_file);
 			} else {
 				rc |= RC_QUIT;
 			}
@@ -762,8 +851,9 @@ rc_t graphics_controls(struct graphics_context *gc, struct course *cp,
 		break;
 	case KEY_ESC:
 		if (gc->main_view == VIEW_MAP_CONTEXT) {
-			gc->main_view = VIEW_FILE_CONTEXT;
+			graphics_set_view(gc, VIEW_FILE_CONTEXT);
 			course_map_unload(cp);
+			map_context_invalidate(gc->map_area);
 			rc |= (RC_MAP_UPDATE |
 			       RC_COURSE_UPDATE | RC_TARGET_UPDATE);
 		}
@@ -788,6 +878,7 @@ rc_t graphics_controls(struct graphics_context *gc, struct course *cp,
 			struct gl_profile_view *pv =
 				(struct gl_profile_view *)gc->profile_frame;
 			gl_profile_view_scale_decrement(pv);
+			gl_frame_invalidate(gc->profile_frame);
 		}
 		break;
 	case 'S':
@@ -798,6 +889,7 @@ rc_t graphics_controls(struct graphics_context *gc, struct course *cp,
 			struct gl_profile_view *pv =
 				(struct gl_profile_view *)gc->profile_frame;
 			gl_profile_view_scale_reset(pv);
+			gl_frame_invalidate(gc->profile_frame);
 		}
 		break;
 	case 'A':
@@ -808,18 +900,25 @@ rc_t graphics_controls(struct graphics_context *gc, struct course *cp,
 			struct gl_profile_view *pv =
 				(struct gl_profile_view *)gc->profile_frame;
 			gl_profile_view_scale_increment(pv);
+			gl_frame_invalidate(gc->profile_frame);
 		}
 		break;
 	case 'R':
-		gc->mag_disable = ((gc->mag_disable) ? 0 : 1);
+		graphics_set_mag_disable(gc, !gc->mag_disable);
 		rc |= RC_MAG_UPDATE | RC_GPS_UPDATE;
 		break;
+	case '#':
+		/* Hidden timing overlay, frames below are restored on exit */
+		gc->diagnostics = !gc->diagnostics;
+		if (!gc->diagnostics)
+			gl_frame_invalidate_all(&gc->frames);
+		break;
 	case 'V':
 		if (gc->main_view == VIEW_MAG_CONTEXT) {
-			gc->main_view = VIEW_FILE_CONTEXT;
+			graphics_set_view(gc, VIEW_FILE_CONTEXT);
 			rc |= RC_MAP_UPDATE;
 		} else {
-			gc->main_view = VIEW_MAG_CONTEXT;
+			graphics_set_view(gc, VIEW_MAG_CONTEXT);
 			rc |= RC_MAG_UPDATE;
 		}
 		break;
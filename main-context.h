@@ -8,9 +8,17 @@ struct course;
 struct flight_data;
 struct gps_data;
 struct mag_data;
+struct gps_setup;
 
 struct gl_frame;
 
+typedef enum main_frame_view_t {
+	VIEW_MAG_CONTEXT,
+	VIEW_GPS_CONTEXT,
+	VIEW_FILE_CONTEXT,
+	VIEW_MAP_CONTEXT
+} main_frame_view_t;
+
 extern int file_chooser_create(struct gl_frame **out,
 			       int x, int y, int w, int h, int color);
 
@@ -24,6 +32,7 @@ extern int gps_context_create(struct gl_frame **out,
 extern void gps_context_add_entry(struct gl_frame *frm,
 				  const char *txt, int color);
 
+/* @header is copied, truncated to 63 characters */
 extern void gps_context_change_header(struct gl_frame *frm,
 				      const char *header, int color);
 
@@ -35,8 +44,25 @@ extern int graphics_context_init(struct graphics_context **out,
 
 extern void graphics_update(struct graphics_context *gc, rc_t rc);
 
+extern void graphics_render(struct graphics_context *gc);
+
 extern void graphics_context_destroy(struct graphics_context *gc);
 
+extern void graphics_set_view(struct graphics_context *gc,
+			      main_frame_view_t view);
+
+/* Load course map and switch to map view, returns updates to dispatch */
+extern rc_t graphics_load_course(struct graphics_context *gc,
+				 struct course *cp,
+				 struct flight_data *flt, const char *file);
+
+/* Receiver setup progress reported on GPS console */
+extern void graphics_gps_setup_init(struct graphics_context *gc,
+				    struct gps_setup *gs);
+
+extern void graphics_gps_setup_done(struct graphics_context *gc,
+				    const struct gps_setup *gs);
+
 extern rc_t graphics_controls(struct graphics_context *gc,
 			      struct course *cp,
 			      struct flight_data *flt,
@@ -3,7 +3,7 @@
 
 #include "ui.h"
 #include "ral.h"
-#include "gps.h"
+#include "gps-port.h"
 #include "mag.h"
 #include "log.h"
 #include "doch.h"
@@ -25,7 +25,7 @@ int main(int argc, char **argv)
 	trackbar_start();
 
 	if (run_mode == RUN_REAL_TIME) {
-		gps_start();
+		gps_port_start();
 		ral_start();
 		mag_start();
 	} else if (run_mode == RUN_SIM_DATA) {
@@ -42,7 +42,7 @@ int main(int argc, char **argv)
 	trackbar_stop();
 	if (run_mode == RUN_REAL_TIME) {
 		ral_stop();
-		gps_stop();
+		gps_port_stop();
 		mag_stop();
 	} else if (run_mode == RUN_SIM_DATA) {
 		sim_data_stop();
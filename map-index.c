@@ -0,0 +1,256 @@
+#include <stdlib.h>
+#include <math.h>
+
+#include "map-index.h"
+#include "debug.h"
+
+/* Average number of entries aimed for per grid cell */
+#define MAP_INDEX_CELL_ENTRIES	4
+
+/* Upper limit of grid cells along each axis */
+#define MAP_INDEX_DIM_MAX	64
+
+struct map_index_entry {
+	course_t type;
+	const void *data;
+	struct map_rect box;
+	unsigned int stamp;
+};
+
+struct map_index {
+	const struct course *cp;
+	struct map_index_entry *entries;
+	unsigned int nr;
+	struct map_rect box;
+	double cell_w, cell_h;
+	int cols, rows;
+	unsigned int *cell_start;	/* cols * rows + 1 offsets */
+	unsigned int *cell_items;	/* entry indexes */
+	unsigned int stamp;		/* current query */
+};
+
+struct map_index_walk {
+	struct map_index *idx;
+	course_t type;
+};
+
+static void __count_entry(const struct course *cp,
+			  const void *data, void *userdata)
+{
+	unsigned int *nr = (unsigned int *)userdata;
+	(*nr)++;
+}
+
+static void __add_entry(const struct course *cp,
+			const void *data, void *userdata)
+{
+	struct map_index_walk *walk = (struct map_index_walk *)userdata;
+	struct map_index_entry *e = &walk->idx->entries[walk->idx->nr++];
+
+	e->type = walk->type;
+	e->data = data;
+	e->stamp = 0;
+
+	if (walk->type == COURSE_WAY_POINT) {
+		const struct way_point *wp = (const struct way_point *)data;
+		e->box.min = wp->pos;
+		e->box.max = wp->pos;
+	} else {
+		const struct line *l = &((const struct flt_path *)data)->line;
+		e->box.min.x = fmin(l->bpos.x, l->epos.x);
+		e->box.min.y = fmin(l->bpos.y, l->epos.y);
+		e->box.max.x = fmax(l->bpos.x, l->epos.x);
+		e->box.max.y = fmax(l->bpos.y, l->epos.y);
+	}
+}
+
+static inline int cell_col(const struct map_index *idx, double x)
+{
+	int c = floor((x - idx->box.min.x) / idx->cell_w);
+	return c < 0 ? 0 : (c >= idx->cols ? idx->cols - 1 : c);
+}
+
+static inline int cell_row(const struct map_index *idx, double y)
+{
+	int r = floor((y - idx->box.min.y) / idx->cell_h);
+	return r < 0 ? 0 : (r >= idx->rows ? idx->rows - 1 : r);
+}
+
+static inline int rect_intersects(const struct map_rect *a,
+				  const struct map_rect *b)
+{
+	return (a->min.x <= b->max.x && a->max.x >= b->min.x &&
+		a->min.y <= b->max.y && a->max.y >= b->min.y);
+}
+
+/* Call @fn for every cell covered by box of entry @i */
+static void for_each_cell(struct map_index *idx, unsigned int i,
+			  void (*fn)(struct map_index *, int, unsigned int))
+{
+	const struct map_rect *box = &idx->entries[i].box;
+	int c, r;
+	int c0 = cell_col(idx, box->min.x), c1 = cell_col(idx, box->max.x);
+	int r0 = cell_row(idx, box->min.y), r1 = cell_row(idx, box->max.y);
+
+	for (r = r0; r <= r1; r++)
+		for (c = c0; c <= c1; c++)
+			fn(idx, r * idx->cols + c, i);
+}
+
+static void __count_cell(struct map_index *idx, int cell, unsigned int i)
+{
+	idx->cell_start[cell + 1]++;
+}
+
+static void __fill_cell(struct map_index *idx, int cell, unsigned int i)
+{
+	/* cell_start is used as fill cursor, shifted back afterwards */
+	idx->cell_items[idx->cell_start[cell]++] = i;
+}
+
+static int map_index_build_grid(struct map_index *idx)
+{
+	unsigned int i, cells, dim;
+
+	idx->box = idx->entries[0].box;
+	for (i = 1; i < idx->nr; i++) {
+		const struct map_rect *b = &idx->entries[i].box;
+		idx->box.min.x = fmin(idx->box.min.x, b->min.x);
+		idx->box.min.y = fmin(idx->box.min.y, b->min.y);
+		idx->box.max.x = fmax(idx->box.max.x, b->max.x);
+		idx->box.max.y = fmax(idx->box.max.y, b->max.y);
+	}
+
+	dim = ceil(sqrt((double)idx->nr / MAP_INDEX_CELL_ENTRIES));
+	if (dim < 1)
+		dim = 1;
+	if (dim > MAP_INDEX_DIM_MAX)
+		dim = MAP_INDEX_DIM_MAX;
+	idx->cols = idx->rows = dim;
+	idx->cell_w = fmax(idx->box.max.x - idx->box.min.x, 1.0) / dim;
+	idx->cell_h = fmax(idx->box.max.y - idx->box.min.y, 1.0) / dim;
+
+	cells = idx->cols * idx->rows;
+	idx->cell_start = calloc(cells + 1, sizeof(unsigned int));
+	if (idx->cell_start == NULL) {
+		SYSERR("Failed to allocate map index cells.");
+		return -1;
+	}
+
+	for (i = 0; i < idx->nr; i++)
+		for_each_cell(idx, i, __count_cell);
+	for (i = 0; i < cells; i++)
+		idx->cell_start[i + 1] += idx->cell_start[i];
+
+	idx->cell_items = malloc((idx->cell_start[cells] + 1) *
+				 sizeof(unsigned int));
+	if (idx->cell_items == NULL) {
+		SYSERR("Failed to allocate map index items.");
+		return -1;
+	}
+
+	for (i = 0; i < idx->nr; i++)
+		for_each_cell(idx, i, __fill_cell);
+	for (i = cells; i > 0; i--)
+		idx->cell_start[i] = idx->cell_start[i - 1];
+	idx->cell_start[0] = 0;
+	return 0;
+}
+
+struct map_index *map_index_create(const struct course *cp)
+{
+	static const course_t types[] = {
+		COURSE_FLT_LINE, COURSE_TIE_LINE, COURSE_WAY_POINT,
+	};
+	struct map_index_walk walk;
+	struct map_index *idx = NULL;
+	unsigned int i, nr = 0;
+
+	idx = calloc(1, sizeof(struct map_index));
+	if (idx == NULL) {
+		SYSERR("Failed to allocate map index.");
+		return NULL;
+	}
+	idx->cp = cp;
+
+	for (i = 0; i < ARRAY_SIZE(types); i++)
+		course_for_each(cp, types[i], __count_entry, &nr);
+	if (nr == 0)
+		return idx;
+
+	idx->entries = malloc(nr * sizeof(struct map_index_entry));
+	if (idx->entries == NULL) {
+		SYSERR("Failed to allocate map index entries.");
+		goto exit_free;
+	}
+
+	walk.idx = idx;
+	for (i = 0; i < ARRAY_SIZE(types); i++) {
+		walk.type = types[i];
+		course_for_each(cp, types[i], __add_entry, &walk);
+	}
+
+	if (map_index_build_grid(idx) < 0)
+		goto exit_free;
+
+	DEBUG("Map index of %u entries in %dx%d cells",
+	      idx->nr, idx->cols, idx->rows);
+	return idx;
+
+ exit_free:
+	map_index_destroy(idx);
+	return NULL;
+}
+
+void map_index_destroy(struct map_index *idx)
+{
+	if (idx == NULL)
+		return;
+
+	free(idx->cell_items);
+	free(idx->cell_start);
+	free(idx->entries);
+	free(idx);
+}
+
+void map_index_query(struct map_index *idx, const struct map_rect *r,
+		     course_t type,
+		     void (*fn)(const struct course *, const void *, void *),
+		     void *userdata)
+{
+	int c, row, c0, c1, r0, r1;
+	unsigned int k;
+
+	if (idx->nr == 0 || !rect_intersects(r, &idx->box))
+		return;
+
+	/* Entries spanning several cells are reported once per query */
+	if (++idx->stamp == 0) {
+		for (k = 0; k < idx->nr; k++)
+			idx->entries[k].stamp = 0;
+		idx->stamp = 1;
+	}
+
+	c0 = cell_col(idx, r->min.x);
+	c1 = cell_col(idx, r->max.x);
+	r0 = cell_row(idx, r->min.y);
+	r1 = cell_row(idx, r->max.y);
+
+	for (row = r0; row <= r1; row++) {
+		for (c = c0; c <= c1; c++) {
+			int cell = row * idx->cols + c;
+
+			for (k = idx->cell_start[cell];
+			     k < idx->cell_start[cell + 1]; k++) {
+				struct map_index_entry *e =
+					&idx->entries[idx->cell_items[k]];
+
+				if (e->type != type || e->stamp == idx->stamp)
+					continue;
+				e->stamp = idx->stamp;
+				if (rect_intersects(r, &e->box))
+					fn(idx->cp, e->data, userdata);
+			}
+		}
+	}
+}
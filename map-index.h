@@ -0,0 +1,29 @@
+#ifndef MAP_INDEX_H_INCLUDED
+#define MAP_INDEX_H_INCLUDED
+
+#include "internals.h"
+#include "course.h"
+
+/* Axis aligned rectangle in world coordinates */
+struct map_rect {
+	struct point min, max;
+};
+
+struct map_index;
+
+/* Uniform grid over flight lines, tie lines and way points of course */
+extern struct map_index *map_index_create(const struct course *cp);
+
+extern void map_index_destroy(struct map_index *idx);
+
+/**
+ * Call @fn, as course_for_each() does, once for every entry of @type
+ * whose bounding box intersects @r.
+ */
+extern void map_index_query(struct map_index *idx, const struct map_rect *r,
+			    course_t type,
+			    void (*fn)(const struct course *, const void *,
+				       void *),
+			    void *userdata);
+
+#endif	/* MAP_INDEX_H_INCLUDED */
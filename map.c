@@ -2,6 +2,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <math.h>
 
 #include "map.h"
 #include "svgalib.h"
@@ -13,8 +14,31 @@
 #include "keyboard.h"
 #include "internals.h"
 #include "geometry.h"
-
-#define NR_TRAILS	10000
+#include "trail.h"
+#include "map-index.h"
+#include "transform-batch.h"
+
+/* Layer extends beyond map area by this fraction (as shift) on each side */
+#define MAP_LAYER_MARGIN_SHIFT		2
+
+/* Sine of rotation (about 1 degree) after which layer is re-rendered */
+#define MAP_LAYER_ROTATION_LIMIT	0.0175
+
+/* Relative scale change after which layer is re-rendered */
+#define MAP_LAYER_SCALE_LIMIT		0.01
+
+/* Static course geometry pre-rendered at some scale and heading */
+struct map_layer {
+	GraphicsContext *gc;
+	int width, height;
+	int origin_x, origin_y;		/* screen position of layer origin */
+	struct point anchor;		/* world position ... */
+	struct point anchor_pos;	/* ... and its screen position */
+	double scale, sinfi, cosfi;
+	unsigned long signature;
+	const void *curr, *next;
+	unsigned int valid : 1;
+};
 
 struct map_context {
 	struct gl_frame frame;
@@ -22,8 +46,10 @@ struct map_context {
 	const struct flight_data *flt;
 	struct transform transform;
 	struct point ref_point;
-	struct point trails[NR_TRAILS];
-	unsigned int trails_nr;
+	struct map_layer layer;
+	struct map_index *index;
+	unsigned int index_stale : 1;
+	struct trail *trail;
 	unsigned int autozoom : 1;
 };
 
@@ -67,146 +93,339 @@ static void auto_zoom(struct map_context *ctx, const struct course *cp)
 			transform_get_scale(&ctx->transform) * 0.95 + zdist);
 }
 
-static void __plot_line(const struct map_context *ctx,
-			const struct line *l, int color)
+/* Where map geometry is plotted, screen or static course layer */
+struct map_view {
+	struct transform transform;
+	struct boundary boundary;
+	int bgcolor;
+	struct map_index *index;	/* NULL to walk whole course */
+	struct map_rect area;		/* world rectangle covering boundary */
+	struct transform_affine affine;
+	struct svgalib_clip clip;	/* boundary for the line primitives */
+};
+
+/* Lines gathered before being transformed in one batch */
+#define MAP_BATCH_NR	64
+
+/* Width of course lines, in pixels */
+#define MAP_LINE_WIDTH	3
+
+/* Screen coordinates beyond which lines are cut before fixed point */
+#define MAP_FIX_RANGE	((double)(1 << 20))
+#define MAP_FIX_ONE	(1 << SVGALIB_SUBPIXEL_SHIFT)
+
+/* Userdata of course_for_each() walks */
+struct map_walk {
+	const struct map_view *view;
+	struct point first;
+	struct point prev;		/* screen position of last corner */
+	unsigned int nr;
+	const struct flt_path *batch[MAP_BATCH_NR];
+	unsigned int batch_nr;
+	int pts[2 * MAP_BATCH_NR];	/* corner polyline, fixed point */
+	unsigned int pts_nr;
+};
+
+/* World rectangle covering view boundary, from inverse transform */
+static void map_view_area(struct map_view *view)
 {
-	struct line l_temp, l_clip;
-	const struct gl_frame *frm = &ctx->frame;
-	struct boundary boundary = {
-		.north	= frm->yb + 2,
-		.west	= frm->xb + 2,
-		.south	= frm->yb + frm->height - 2,
-		.east	= frm->xb + frm->width - 2,
+	const struct boundary *b = &view->boundary;
+	struct svgalib_clip clip = { b->west, b->north, b->east, b->south };
+	struct point corners[4] = {
+		{ b->west, b->north }, { b->east, b->north },
+		{ b->west, b->south }, { b->east, b->south },
 	};
+	register int i;
+
+	view->clip = clip;
+	transform_affine_init(&view->affine, &view->transform);
+
+	for (i = 0; i < 4; i++) {
+		struct point w;
+
+		if (transform_affine_invert(&view->affine, corners[i].x,
+					    corners[i].y, &w) < 0) {
+			view->index = NULL;
+			return;
+		}
+		if (i == 0) {
+			view->area.min = w;
+			view->area.max = w;
+			continue;
+		}
+		view->area.min.x = fmin(view->area.min.x, w.x);
+		view->area.min.y = fmin(view->area.min.y, w.y);
+		view->area.max.x = fmax(view->area.max.x, w.x);
+		view->area.max.y = fmax(view->area.max.y, w.y);
+	}
+}
+
+static void map_view_screen(const struct map_context *ctx,
+			    struct map_view *view)
+{
+	const struct gl_frame *frm = &ctx->frame;
+
+	view->transform = ctx->transform;
+	view->boundary.north = frm->yb + 2;
+	view->boundary.west = frm->xb + 2;
+	view->boundary.south = frm->yb + frm->height - 2;
+	view->boundary.east = frm->xb + frm->width - 2;
+	view->bgcolor = frm->color;
+	view->index = ctx->index;
+	map_view_area(view);
+}
+
+static inline int map_fix_inside(const struct point *p)
+{
+	return fabs(p->x) < MAP_FIX_RANGE && fabs(p->y) < MAP_FIX_RANGE;
+}
 
-	l_temp.bpos = do_transform(&ctx->transform, l->bpos);
-	l_temp.epos = do_transform(&ctx->transform, l->epos);
+/**
+ * Fixed point end points of screen segment for the line primitives.
+ * Parts far enough off screen to overflow are cut off first.
+ */
+static int map_fix_segment(struct point b, struct point e, int seg[4])
+{
+	double t0 = 0.0, t1 = 1.0;
+	double p[2] = { b.x, b.y }, d[2] = { e.x - b.x, e.y - b.y };
+	register int i;
+
+	if (!map_fix_inside(&b) || !map_fix_inside(&e)) {
+		for (i = 0; i < 2; i++) {
+			double ta, tb;
+
+			if (d[i] == 0.0) {
+				if (fabs(p[i]) >= MAP_FIX_RANGE)
+					return -1;
+				continue;
+			}
+			ta = (-MAP_FIX_RANGE - p[i]) / d[i];
+			tb = (MAP_FIX_RANGE - p[i]) / d[i];
+			t0 = fmax(t0, fmin(ta, tb));
+			t1 = fmin(t1, fmax(ta, tb));
+		}
+		if (t0 > t1)
+			return -1;
+	}
 
-	if (!line_clip(&boundary, &l_temp, &l_clip))
-		svgalib_draw_thick_line(l_clip.bpos.x, l_clip.bpos.y,
-					l_clip.epos.x, l_clip.epos.y, color);
+	seg[0] = lrint((p[0] + t0 * d[0]) * MAP_FIX_ONE);
+	seg[1] = lrint((p[1] + t0 * d[1]) * MAP_FIX_ONE);
+	seg[2] = lrint((p[0] + t1 * d[0]) * MAP_FIX_ONE);
+	seg[3] = lrint((p[1] + t1 * d[1]) * MAP_FIX_ONE);
+	return 0;
 }
 
-static void plot_curr_line(const struct map_context *ctx,
+static inline int map_segment(const struct map_view *view,
+			      const struct line *l, int seg[4])
+{
+	return map_fix_segment(do_transform(&view->transform, l->bpos),
+			       do_transform(&view->transform, l->epos), seg);
+}
+
+static void __plot_line(const struct map_view *view,
+			const struct line *l, int color)
+{
+	int seg[4];
+
+	if (map_segment(view, l, seg) == 0)
+		svgalib_draw_segments(seg, 1, &view->clip,
+				      MAP_LINE_WIDTH, color);
+}
+
+static void plot_curr_line(const struct map_view *view,
 			   const struct line *l, int color)
 {
 	struct line l_temp;
 	struct point v = make_vector(&l->bpos, &l->epos);
+	int seg[8], nr = 0;
+
 	v = get_unit_vector(&v);
 
 	/* extend unit vector of line to 500m for line entry */
 	v.x *= 500.0;
 	v.y *= 500.0;
 
-	__plot_line(ctx, l, color);
+	__plot_line(view, l, color);
 
 	/* extend begin point of line */
-	color = svgalib_get_color(10, 10, 10);
 	l_temp.bpos = l->bpos;
 	l_temp.epos.x = l->bpos.x + v.x;
 	l_temp.epos.y = l->bpos.y + v.y;
-	__plot_line(ctx, &l_temp, color);
+	if (map_segment(view, &l_temp, &seg[4 * nr]) == 0)
+		nr++;
 
 	/* extend end point of line */
 	l_temp.bpos = l->epos;
 	l_temp.epos.x = l->epos.x - v.x;
 	l_temp.epos.y = l->epos.y - v.y;
-	__plot_line(ctx, &l_temp, color);
+	if (map_segment(view, &l_temp, &seg[4 * nr]) == 0)
+		nr++;
+
+	svgalib_draw_segments(seg, nr, &view->clip, MAP_LINE_WIDTH,
+			      svgalib_get_color(10, 10, 10));
 }
 
-static void __plot_corner_point(const struct course *cp,
-				const void *data, void *userdata)
+/* Draw gathered corner points, last one starts the next polyline */
+static void plot_corner_batch(struct map_walk *walk)
 {
-	struct map_context *ctx = (struct map_context *)userdata;
-	int color = svgalib_get_color(10, 10, 10);	/* light grey color */
-	static struct line l;
-	static int init = 1;
-	const struct corner_point *curr = (const struct corner_point *)data;
+	unsigned int n = walk->pts_nr;
+
+	if (n > 1)
+		svgalib_draw_polyline(walk->pts, n, &walk->view->clip,
+				      MAP_LINE_WIDTH,
+				      svgalib_get_color(10, 10, 10));
+	if (n > 0) {
+		walk->pts[0] = walk->pts[2 * (n - 1)];
+		walk->pts[1] = walk->pts[2 * (n - 1) + 1];
+		walk->pts_nr = 1;
+	}
+}
+
+static void plot_corner_add(struct map_walk *walk, struct point pos)
+{
+	struct point p = do_transform(&walk->view->transform, pos);
+	int seg[4];
 
-	if (init) {
-		l.bpos = curr->pos;
-		l.epos = curr->pos;
-		init = 0;
+	if (walk->nr && map_fix_inside(&walk->prev) && map_fix_inside(&p)) {
+		if (walk->pts_nr == MAP_BATCH_NR)
+			plot_corner_batch(walk);
 	} else {
-		l.epos = curr->pos;
-		__plot_line(ctx, &l, color);
-		l.bpos = l.epos;
+		/* Segments from or to far off points are cut on their own */
+		plot_corner_batch(walk);
+		walk->pts_nr = 0;
+		if (walk->nr && map_fix_segment(walk->prev, p, seg) == 0)
+			svgalib_draw_segments(seg, 1, &walk->view->clip,
+					      MAP_LINE_WIDTH,
+					      svgalib_get_color(10, 10, 10));
+		if (!map_fix_inside(&p))
+			goto exit;
 	}
+	walk->pts[2 * walk->pts_nr] = lrint(p.x * MAP_FIX_ONE);
+	walk->pts[2 * walk->pts_nr + 1] = lrint(p.y * MAP_FIX_ONE);
+	walk->pts_nr++;
+ exit:
+	walk->prev = p;
+	walk->nr++;
 }
 
-static inline void plot_corner_points(struct map_context *ctx,
-				      const struct course *cp)
+static void __plot_corner_point(const struct course *cp,
+				const void *data, void *userdata)
 {
-	course_for_each(cp, COURSE_CORNER_POINT, __plot_corner_point, ctx);
+	struct map_walk *walk = (struct map_walk *)userdata;
+	const struct corner_point *curr = (const struct corner_point *)data;
+
+	if (walk->nr == 0)
+		walk->first = curr->pos;
+	plot_corner_add(walk, curr->pos);
 }
 
-static void __plot_flightline(const struct course *cp,
-			      const void *data, void *userdata)
+/* Block outline through corner points, drawn as polylines */
+static void plot_corner_points(const struct map_view *view,
+			       const struct course *cp)
 {
-	struct map_context *ctx = (struct map_context *)userdata;
-	const struct flt_path *flt = (const struct flt_path *)data;
+	struct map_walk walk = {
+		.view = view,
+		.nr = 0,
+		.pts_nr = 0,
+	};
 
-	if (course_curr_type(cp) == COURSE_FLT_LINE &&
-	    course_curr_entry(cp) == flt) {
-		plot_curr_line(ctx, &flt->line, svgalib_get_color(31, 31, 31));
-	} else {
-		int color = svgalib_get_color(0, 31, 0);
-		if (flt->status)
-			color = svgalib_get_color(20, 0, 0);
-		if (course_next_type(cp) == COURSE_FLT_LINE &&
-		    course_next_entry(cp) == flt)
-			color = svgalib_get_color(0, 0, 31);
+	course_for_each(cp, COURSE_CORNER_POINT, __plot_corner_point, &walk);
 
-		__plot_line(ctx, &flt->line, color);
-	}
+	/* close block outline */
+	if (walk.nr > 2)
+		plot_corner_add(&walk, walk.first);
+	plot_corner_batch(&walk);
 }
 
-static void __plot_tieline(const struct course *cp,
-			   const void *data, void *userdata)
+static inline int is_highlighted(const struct course *cp, const void *entry)
 {
-	struct map_context *ctx = (struct map_context *)userdata;
-	const struct flt_path *tie = (const struct flt_path *)data;
+	return (course_curr_entry(cp) == entry ||
+		course_next_entry(cp) == entry);
+}
 
-	if (course_curr_type(cp) == COURSE_TIE_LINE &&
-	    course_curr_entry(cp) == tie) {
-		plot_curr_line(ctx, &tie->line, svgalib_get_color(31, 31, 31));
-	} else {
+static void plot_path_batch(struct map_walk *walk)
+{
+	const struct map_view *view = walk->view;
+	double x[2 * MAP_BATCH_NR], y[2 * MAP_BATCH_NR];
+	int seg[4 * MAP_BATCH_NR];
+	int nr = 0, run_color = 0;
+	register unsigned int i;
+
+	for (i = 0; i < walk->batch_nr; i++) {
+		const struct line *l = &walk->batch[i]->line;
+
+		x[2 * i] = l->bpos.x;
+		y[2 * i] = l->bpos.y;
+		x[2 * i + 1] = l->epos.x;
+		y[2 * i + 1] = l->epos.y;
+	}
+
+	transform_batch(&view->affine, x, y, x, y, 2 * walk->batch_nr);
+
+	/* Runs of lines in the same color are drawn in one call */
+	for (i = 0; i < walk->batch_nr; i++) {
+		struct point b = { x[2 * i], y[2 * i] };
+		struct point e = { x[2 * i + 1], y[2 * i + 1] };
 		int color = svgalib_get_color(0, 31, 0);
-		if (tie->status)
-		color = svgalib_get_color(20, 0, 0);
-		if (course_next_type(cp) == COURSE_TIE_LINE &&
-		course_next_entry(cp) == tie)
-		color = svgalib_get_color(0, 0, 31);
 
-		__plot_line(ctx, &tie->line, color);
+		if (walk->batch[i]->status)
+			color = svgalib_get_color(20, 0, 0);
+
+		if (nr && color != run_color) {
+			svgalib_draw_segments(seg, nr, &view->clip,
+					      MAP_LINE_WIDTH, run_color);
+			nr = 0;
+		}
+		run_color = color;
+		if (map_fix_segment(b, e, &seg[4 * nr]) == 0)
+			nr++;
 	}
+	if (nr)
+		svgalib_draw_segments(seg, nr, &view->clip, MAP_LINE_WIDTH,
+				      run_color);
+	walk->batch_nr = 0;
 }
 
-static inline void plot_flight_lines(struct map_context *ctx,
-				     const struct course *cp)
+/* Flight and tie lines, current and next ones are plotted as highlights */
+static void __plot_path(const struct course *cp,
+			const void *data, void *userdata)
 {
-	course_for_each(cp, COURSE_FLT_LINE, __plot_flightline, ctx);
+	struct map_walk *walk = (struct map_walk *)userdata;
+	const struct flt_path *path = (const struct flt_path *)data;
+
+	if (is_highlighted(cp, path))
+		return;
+
+	walk->batch[walk->batch_nr++] = path;
+	if (walk->batch_nr == MAP_BATCH_NR)
+		plot_path_batch(walk);
 }
 
-static inline void plot_tie_lines(struct map_context *ctx,
-				  const struct course *cp)
+static void plot_paths(const struct map_view *view,
+		       const struct course *cp, course_t type)
 {
-	course_for_each(cp, COURSE_TIE_LINE, __plot_tieline, ctx);
+	struct map_walk walk = {
+		.view = view,
+		.batch_nr = 0,
+	};
+
+	if (view->index)
+		map_index_query(view->index, &view->area, type,
+				__plot_path, &walk);
+	else
+		course_for_each(cp, type, __plot_path, &walk);
+
+	if (walk.batch_nr)
+		plot_path_batch(&walk);
 }
 
-static void __plot_waypoint(const struct map_context *ctx,
+static void __plot_waypoint(const struct map_view *view,
 			    const struct way_point *wp, int color)
 {
 	char tmp[10] = "";
 	icon_t icon;
-	const struct gl_frame *frm = &ctx->frame;
-	struct boundary boundary = {
-		.north	= frm->yb + 2,
-		.west	= frm->xb + 2,
-		.south	= frm->yb + frm->height - 2,
-		.east	= frm->xb + frm->width - 2,
-	};
-	struct point pos = do_transform(&ctx->transform, wp->pos);
+	struct boundary boundary = view->boundary;
+	struct point pos = do_transform(&view->transform, wp->pos);
 
 	switch (wp->type) {
 	default:
@@ -246,10 +465,10 @@ static void __plot_waypoint(const struct map_context *ctx,
 			svgalib_draw_circle(pos.x, pos.y, 12, color);
 			svgalib_display_text_wrapped(pos.x, pos.y + 8,
 						     tmp, FONT_SUN8x16,
-						     frm->color, color);
+						     view->bgcolor, color);
 		} else {
 			svgalib_display_text_wrapped(pos.x, pos.y + 8, tmp,
-						     FONT_ACORN8x8, frm->color,
+						     FONT_ACORN8x8, view->bgcolor,
 						     svgalib_get_color(0, 31, 0));
 		}
 	}
@@ -258,66 +477,362 @@ static void __plot_waypoint(const struct map_context *ctx,
 static void plot_waypoint(const struct course *cp,
 			  const void *data, void *userdata)
 {
-	struct map_context *ctx = (struct map_context *)userdata;
+	struct map_walk *walk = (struct map_walk *)userdata;
 	const struct way_point *wp = (const struct way_point *)data;
+
+	if (!is_highlighted(cp, wp))
+		__plot_waypoint(walk->view, wp, 0);
+}
+
+static inline void plot_way_points(const struct map_view *view,
+				   const struct course *cp)
+{
+	struct map_walk walk = {
+		.view = view,
+	};
+
+	if (view->index)
+		map_index_query(view->index, &view->area, COURSE_WAY_POINT,
+				plot_waypoint, &walk);
+	else
+		course_for_each(cp, COURSE_WAY_POINT, plot_waypoint, &walk);
+}
+
+/* Course geometry that only changes with line status */
+static void plot_static_course(const struct map_view *view,
+			       const struct course *cp)
+{
+	plot_corner_points(view, cp);
+	plot_paths(view, cp, COURSE_FLT_LINE);
+	plot_paths(view, cp, COURSE_TIE_LINE);
+	plot_way_points(view, cp);
+}
+
+static void plot_highlight(const struct map_view *view, course_t type,
+			   const void *entry, int curr)
+{
+	int color = curr ? svgalib_get_color(31, 31, 31) :
+			   svgalib_get_color(0, 0, 31);
+
+	switch (type) {
+	case COURSE_FLT_LINE:
+	case COURSE_TIE_LINE:
+		if (curr)
+			plot_curr_line(view,
+				       &((const struct flt_path *)entry)->line,
+				       color);
+		else
+			__plot_line(view,
+				    &((const struct flt_path *)entry)->line,
+				    color);
+		break;
+	case COURSE_WAY_POINT:
+		__plot_waypoint(view, (const struct way_point *)entry, color);
+		break;
+	default:
+		break;
+	}
+}
+
+/* Current and next course entries, composited over static course */
+static void plot_highlights(const struct map_view *view,
+			    const struct course *cp)
+{
+	if (course_curr_entry(cp))
+		plot_highlight(view, course_curr_type(cp),
+			       course_curr_entry(cp), 1);
+	if (course_next_entry(cp))
+		plot_highlight(view, course_next_type(cp),
+			       course_next_entry(cp), 0);
+}
+
+static void __status_signature(const struct course *cp,
+			       const void *data, void *userdata)
+{
+	const struct flt_path *path = (const struct flt_path *)data;
+	unsigned long *signature = (unsigned long *)userdata;
+
+	*signature = *signature * 31 + path->status + 1;
+}
+
+static unsigned long course_status_signature(const struct course *cp)
+{
+	unsigned long signature = 0;
+
+	course_for_each(cp, COURSE_FLT_LINE, __status_signature, &signature);
+	course_for_each(cp, COURSE_TIE_LINE, __status_signature, &signature);
+	return signature;
+}
+
+static void map_layer_render(struct map_context *ctx)
+{
+	struct map_layer *layer = &ctx->layer;
+	const struct gl_frame *frm = &ctx->frame;
+	const struct course *cp = ctx->course_ptr;
+	const struct flight_data *flt = ctx->flt;
+	struct map_view view;
+	struct point ref;
+
+	layer->origin_x = frm->xb - (frm->width >> MAP_LAYER_MARGIN_SHIFT);
+	layer->origin_y = frm->yb - (frm->height >> MAP_LAYER_MARGIN_SHIFT);
+
+	/* Same transform, shifted into layer coordinates */
+	view.transform = ctx->transform;
+	ref.x = ctx->ref_point.x - layer->origin_x;
+	ref.y = ctx->ref_point.y - layer->origin_y;
+	transform_set_ref_point(&view.transform, &ref);
+	view.boundary.north = 2;
+	view.boundary.west = 2;
+	view.boundary.south = layer->height - 3;
+	view.boundary.east = layer->width - 3;
+	view.bgcolor = frm->color;
+	view.index = ctx->index;
+	map_view_area(&view);
+
+	svgalib_layer_begin(layer->gc);
+	svgalib_draw_box_colored(0, 0, layer->width, layer->height,
+				 frm->color);
+	plot_static_course(&view, cp);
+	svgalib_layer_end();
+
+	layer->anchor = flt->position;
+	layer->anchor_pos = do_transform(&ctx->transform, flt->position);
+	layer->scale = transform_get_scale(&ctx->transform);
+	layer->sinfi = flt->sinfi;
+	layer->cosfi = flt->cosfi;
+	layer->curr = course_curr_entry(cp);
+	layer->next = course_next_entry(cp);
+	layer->valid = 1;
+	DEBUG("Static course layer rendered");
+}
+
+/* Whether layer content still matches rotation, scale and line status */
+static int map_layer_is_current(const struct map_context *ctx,
+				unsigned long signature)
+{
+	const struct map_layer *layer = &ctx->layer;
+	const struct course *cp = ctx->course_ptr;
+	const struct flight_data *flt = ctx->flt;
+	double scale = transform_get_scale(&ctx->transform);
+
+	if (!layer->valid || layer->signature != signature ||
+	    layer->curr != course_curr_entry(cp) ||
+	    layer->next != course_next_entry(cp))
+		return 0;
+
+	/* sine of rotation between layer and current heading */
+	if (fabs(flt->sinfi * layer->cosfi - flt->cosfi * layer->sinfi) >
+	    MAP_LAYER_ROTATION_LIMIT)
+		return 0;
+
+	if (fabs(scale - layer->scale) > MAP_LAYER_SCALE_LIMIT * layer->scale)
+		return 0;
+
+	return 1;
+}
+
+/**
+ * Copy static course layer into map area, re-rendering it when stale or
+ * when translation since last render exceeds layer margin.
+ *
+ * @return: 0 on success, -1 when no layer could be allocated.
+ */
+static int map_layer_update(struct map_context *ctx)
+{
+	struct map_layer *layer = &ctx->layer;
+	const struct gl_frame *frm = &ctx->frame;
+	unsigned long signature = course_status_signature(ctx->course_ptr);
+	struct boundary b;
+	struct point pos;
+	int x, y, w, h;
+
+	if (layer->gc == NULL) {
+		layer->width = frm->width +
+			       2 * (frm->width >> MAP_LAYER_MARGIN_SHIFT);
+		layer->height = frm->height +
+				2 * (frm->height >> MAP_LAYER_MARGIN_SHIFT);
+		layer->gc = svgalib_layer_create(layer->width, layer->height);
+		if (layer->gc == NULL)
+			return -1;
+		layer->valid = 0;
+	}
+
+	b.north = frm->yb + 2;
+	b.west = frm->xb + 2;
+	b.south = frm->yb + frm->height - 2;
+	b.east = frm->xb + frm->width - 2;
+	w = b.east - b.west + 1;
+	h = b.south - b.north + 1;
+
+	if (!map_layer_is_current(ctx, signature)) {
+		layer->signature = signature;
+		map_layer_render(ctx);
+	}
+
+	/* Layer is only translated since render */
+	pos = do_transform(&ctx->transform, layer->anchor);
+	x = b.west - layer->origin_x - lround(pos.x - layer->anchor_pos.x);
+	y = b.north - layer->origin_y - lround(pos.y - layer->anchor_pos.y);
+	if (x < 0 || y < 0 || x + w > layer->width || y + h > layer->height) {
+		map_layer_render(ctx);
+		x = b.west - layer->origin_x;
+		y = b.north - layer->origin_y;
+	}
+
+	svgalib_copy_layer(layer->gc, x, y, w, h, b.west, b.north);
+	return 0;
+}
+
+void map_context_invalidate(struct gl_frame *frm)
+{
+	struct map_context *ctx = (struct map_context *)frm;
+
+	if (ctx) {
+		ctx->layer.valid = 0;
+		ctx->index_stale = 1;
+	}
+}
+
+struct trail_plot {
+	struct transform_affine affine;
+	struct boundary boundary;
+	struct svgalib_clip clip;
 	int color;
+};
 
-	if (course_next_type(cp) == COURSE_WAY_POINT &&
-		course_next_entry(cp) == wp) {
-		color = svgalib_get_color(0, 0, 31);
-	} else if (course_curr_type(cp) == COURSE_WAY_POINT &&
-		course_curr_entry(cp) == wp) {
-		color = svgalib_get_color(31, 31, 31);
-	} else {
-		color = svgalib_get_color(0, 0, 0);
+/* Trail points transformed per batch */
+#define TRAIL_BATCH_NR	64
+
+/* Width of trail lines, in pixels */
+#define TRAIL_LINE_WIDTH	3
+
+/* Userdata of polyline through one run of trail points */
+struct trail_walk {
+	const struct trail_plot *tp;
+	struct point prev;		/* screen position of last point */
+	unsigned int nr;
+	int pts[2 * (TRAIL_BATCH_NR + 1)];	/* fixed point */
+	unsigned int pts_nr;
+};
+
+/* Draw gathered points, last one starts the next polyline */
+static void plot_trail_batch(struct trail_walk *walk)
+{
+	unsigned int n = walk->pts_nr;
+
+	if (n > 1)
+		svgalib_draw_polyline(walk->pts, n, &walk->tp->clip,
+				      TRAIL_LINE_WIDTH, walk->tp->color);
+	if (n > 0) {
+		walk->pts[0] = walk->pts[2 * (n - 1)];
+		walk->pts[1] = walk->pts[2 * (n - 1) + 1];
+		walk->pts_nr = 1;
 	}
-	__plot_waypoint(ctx, wp, color);
 }
 
-static inline void plot_way_points(struct map_context *ctx,
-				   const struct course *cp)
+static void plot_trail_add(struct trail_walk *walk, struct point p)
 {
-	course_for_each(cp, COURSE_WAY_POINT, plot_waypoint, ctx);
+	int seg[4];
+
+	if (!walk->nr || !map_fix_inside(&walk->prev) ||
+	    !map_fix_inside(&p)) {
+		/* Segments from or to far off points are cut on their own */
+		plot_trail_batch(walk);
+		walk->pts_nr = 0;
+		if (walk->nr && map_fix_segment(walk->prev, p, seg) == 0)
+			svgalib_draw_segments(seg, 1, &walk->tp->clip,
+					      TRAIL_LINE_WIDTH,
+					      walk->tp->color);
+		if (!map_fix_inside(&p))
+			goto exit;
+	}
+	walk->pts[2 * walk->pts_nr] = lrint(p.x * MAP_FIX_ONE);
+	walk->pts[2 * walk->pts_nr + 1] = lrint(p.y * MAP_FIX_ONE);
+	walk->pts_nr++;
+ exit:
+	walk->prev = p;
+	walk->nr++;
 }
 
-static void __plot_trails(const struct boundary *b,
-			  const struct point *pos, int color)
+/* Polyline through run of trail points, clipped to the map */
+static void __plot_trail_points(const double *xw, const double *yw,
+				unsigned int nr, void *userdata)
 {
-	if (is_point_inside_boundary(b, pos)) {
-		svgalib_set_pixel(pos->x, pos->y, color);
-		svgalib_set_pixel(pos->x + 1, pos->y, color);
-		svgalib_set_pixel(pos->x - 1, pos->y, color);
-		svgalib_set_pixel(pos->x, pos->y + 1, color);
-		svgalib_set_pixel(pos->x, pos->y - 1, color);
+	struct trail_walk walk = {
+		.tp = (const struct trail_plot *)userdata,
+		.nr = 0,
+		.pts_nr = 0,
+	};
+	double x[TRAIL_BATCH_NR], y[TRAIL_BATCH_NR];
+	register unsigned int i;
+
+	while (nr) {
+		unsigned int n = nr > TRAIL_BATCH_NR ? TRAIL_BATCH_NR : nr;
+
+		transform_batch(&walk.tp->affine, xw, yw, x, y, n);
+
+		for (i = 0; i < n; i++) {
+			struct point p = { x[i], y[i] };
+
+			plot_trail_add(&walk, p);
+		}
+		plot_trail_batch(&walk);
+		xw += n;
+		yw += n;
+		nr -= n;
 	}
 }
 
+/* World distance from @pos beyond which nothing is inside @b */
+static double view_radius(const struct transform *tr,
+			  const struct boundary *b, const struct point *pos)
+{
+	struct point c = do_transform(tr, *pos);
+	struct point u = { pos->x + 1.0, pos->y };
+	double ppm, r = 0.0;
+
+	/* Transform only rotates and scales, pixels per world unit */
+	u = do_transform(tr, u);
+	ppm = hypot(u.x - c.x, u.y - c.y);
+	if (ppm <= 0.0)
+		return 0.0;
+
+	r = fmax(r, hypot(b->west - c.x, b->north - c.y));
+	r = fmax(r, hypot(b->east - c.x, b->north - c.y));
+	r = fmax(r, hypot(b->west - c.x, b->south - c.y));
+	r = fmax(r, hypot(b->east - c.x, b->south - c.y));
+	return (r + 2.0) / ppm;
+}
+
 static void plot_aircraft_trails(struct map_context *ctx,
 				 const struct point *pos)
 {
-	register unsigned int i;
 	const struct gl_frame *frm = &ctx->frame;
-	struct boundary boundary = {
-		.north	= frm->yb + 2,
-		.west	= frm->xb + 2,
-		.south	= frm->yb + frm->height - 2,
-		.east	= frm->xb + frm->width - 2,
+	struct trail_plot tp = {
+		.boundary = {
+			.north	= frm->yb + 2,
+			.west	= frm->xb + 2,
+			.south	= frm->yb + frm->height - 2,
+			.east	= frm->xb + frm->width - 2,
+		},
+		.color = svgalib_get_color(31, 0, 0),
+	};
+	struct svgalib_clip clip = {
+		tp.boundary.west, tp.boundary.north,
+		tp.boundary.east, tp.boundary.south,
 	};
 
-	/* Aircraft positional history is saved in buffer to generate trails */
-	ctx->trails[ctx->trails_nr].x = pos->x;
-	ctx->trails[ctx->trails_nr].y = pos->y;
-	ctx->trails_nr = (ctx->trails_nr >= NR_TRAILS - 1) ? 0 : ctx->trails_nr + 1;
+	tp.clip = clip;
 
-	/* plot of trailing points */
-	for (i = NR_TRAILS - 1; i > 0; i--) {
-		struct point p = ctx->trails[(ctx->trails_nr + i) % NR_TRAILS];
-		if (p.x == 0.0 && p.y == 0.0)
-			break;
+	/* Aircraft positional history is decimated into trail store */
+	if (pos->x != 0.0 || pos->y != 0.0)
+		trail_add(ctx->trail, pos);
 
-		p = do_transform(&ctx->transform, p);
-		__plot_trails(&boundary, &p, svgalib_get_color(31, 0, 0));
-	}
+	/* plot of trailing points within view */
+	transform_affine_init(&tp.affine, &ctx->transform);
+	trail_for_each_near(ctx->trail, pos,
+			    view_radius(&ctx->transform, &tp.boundary, pos),
+			    __plot_trail_points, &tp);
 }
 
 static void show_cross_track_error(const struct map_context *ctx,
@@ -396,8 +911,13 @@ static void map_context_adjust(struct map_context *ctx, struct gl_frame *frm)
 static void map_context_destroy(struct gl_frame *frm)
 {
 	struct map_context *ctx = (struct map_context *)frm;
-	if (ctx)
+	if (ctx) {
+		trail_destroy(ctx->trail);
+		map_index_destroy(ctx->index);
+		if (ctx->layer.gc)
+			svgalib_virtual_context_destroy(ctx->layer.gc);
 		free(ctx);
+	}
 	ctx = NULL;
 }
 
@@ -406,16 +926,27 @@ static void map_context_draw(struct gl_frame *frm)
 	struct map_context *ctx = (struct map_context *)frm;
 	const struct course *cp = ctx->course_ptr;
 	const struct flight_data *flt = ctx->flt;
+	struct map_view view;
 
 	transform_set_angle(&ctx->transform, flt->sinfi, flt->cosfi);
 	transform_set_curr_position(&ctx->transform, &flt->position);
 	if (ctx->autozoom)
 		auto_zoom(ctx, cp);
 
-	plot_corner_points(ctx, cp);
-	plot_flight_lines(ctx, cp);
-	plot_tie_lines(ctx, cp);
-	plot_way_points(ctx, cp);
+	/* Index is rebuilt once course is (re)loaded */
+	if (ctx->index_stale) {
+		map_index_destroy(ctx->index);
+		ctx->index = map_index_create(cp);
+		ctx->index_stale = 0;
+	}
+
+	map_view_screen(ctx, &view);
+
+	/* Plot static course directly when no layer is available */
+	if (map_layer_update(ctx) < 0)
+		plot_static_course(&view, cp);
+
+	plot_highlights(&view, cp);
 	plot_dest_point(ctx, cp->dest_point);
 
 	/* aircraft movement clutters screen while panning */
@@ -430,7 +961,7 @@ int map_context_create(struct gl_frame **out, int x, int y, int w, int h,
 		       int color, const struct course *cp,
 		       const struct flight_data *flt)
 {
-	struct map_context *ctx = malloc(sizeof(struct map_context));
+	struct map_context *ctx = calloc(1, sizeof(struct map_context));
 	if (ctx == NULL) {
 		ERROR("Out of memory.");
 		return -1;
@@ -440,11 +971,16 @@ int map_context_create(struct gl_frame **out, int x, int y, int w, int h,
 	ctx->frame.draw = map_context_draw;
 	ctx->frame.destroy = map_context_destroy;
 
+	ctx->trail = trail_create();
+	if (ctx->trail == NULL) {
+		free(ctx);
+		return -1;
+	}
+
 	transform_init(&ctx->transform, 0.0, 1.0, 1.0, 0.0, 0.0, 0.0, 0.0);
-	memset(ctx->trails, 0, sizeof(struct point));
 	memset(&ctx->ref_point, 0, sizeof(struct point));
-	ctx->trails_nr = 0;
 	ctx->autozoom = 1;
+	ctx->index_stale = 1;
 	ctx->course_ptr = cp;
 	ctx->flt = flt;
 	map_context_adjust(ctx, &ctx->frame);
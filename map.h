@@ -18,6 +18,9 @@ extern int map_context_create(struct gl_frame **out, int x, int y,
 
 extern void map_context_adjust_scale(struct gl_frame *frm, map_scale_t scale);
 
+/* Re-render static course layer on next draw, e.g. after map load */
+extern void map_context_invalidate(struct gl_frame *frm);
+
 extern void icons_create(void);
 
 #endif	/* MAP_H_INCLUDED */
@@ -0,0 +1,327 @@
+#include <string.h>
+#include <stddef.h>
+
+#include "nmea-parse.h"
+#include "nmea.h"
+#include "internals.h"
+#include "debug.h"
+
+/* Digits kept exactly in the mantissa of a double */
+#define NMEA_DIGITS_MAX		15
+
+typedef enum {
+	NMEA_FLD_DOUBLE,
+	NMEA_FLD_INT,
+	NMEA_FLD_CHAR,
+	NMEA_FLD_PRN,		/* integer, empty field clears it */
+} nmea_field_t;
+
+struct nmea_field {
+	unsigned char index;	/* position in sentence, address is 0 */
+	unsigned char type;
+	unsigned short offset;	/* in the sentence structure */
+};
+
+struct nmea_type {
+	char name[4];
+	nmea_sentence_t sentence;
+	unsigned short offset;	/* of sentence structure in parser */
+	unsigned short size;
+	const struct nmea_field *fields;
+	int nr_fields;
+};
+
+#define FLD(i, t, s, m)		{ i, NMEA_FLD_##t, offsetof(s, m) }
+
+static const struct nmea_field gga_fields[] = {
+	FLD(1, DOUBLE, struct gga, utc_time),
+	FLD(2, DOUBLE, struct gga, latitude),
+	FLD(3, CHAR, struct gga, latitude_hemisphere),
+	FLD(4, DOUBLE, struct gga, longitude),
+	FLD(5, CHAR, struct gga, longitude_hemisphere),
+	FLD(6, INT, struct gga, fix),
+	FLD(7, INT, struct gga, nsat),
+	FLD(9, DOUBLE, struct gga, altitude),
+	FLD(10, CHAR, struct gga, alt_unit),
+};
+
+static const struct nmea_field rmc_fields[] = {
+	FLD(1, DOUBLE, struct nmea_rmc, utc_time),
+	FLD(2, CHAR, struct nmea_rmc, status),
+	FLD(3, DOUBLE, struct nmea_rmc, latitude),
+	FLD(4, CHAR, struct nmea_rmc, latitude_hemisphere),
+	FLD(5, DOUBLE, struct nmea_rmc, longitude),
+	FLD(6, CHAR, struct nmea_rmc, longitude_hemisphere),
+	FLD(7, DOUBLE, struct nmea_rmc, speed),
+	FLD(8, DOUBLE, struct nmea_rmc, course),
+	FLD(9, INT, struct nmea_rmc, date),
+	FLD(12, CHAR, struct nmea_rmc, mode),
+};
+
+static const struct nmea_field vtg_fields[] = {
+	FLD(1, DOUBLE, struct nmea_vtg, course),
+	FLD(3, DOUBLE, struct nmea_vtg, course_magnetic),
+	FLD(5, DOUBLE, struct nmea_vtg, speed),
+	FLD(7, DOUBLE, struct nmea_vtg, speed_kmh),
+	FLD(9, CHAR, struct nmea_vtg, mode),
+};
+
+static const struct nmea_field gsa_fields[] = {
+	FLD(1, CHAR, struct nmea_gsa, mode),
+	FLD(2, INT, struct nmea_gsa, fix_type),
+	FLD(3, PRN, struct nmea_gsa, prn[0]),
+	FLD(4, PRN, struct nmea_gsa, prn[1]),
+	FLD(5, PRN, struct nmea_gsa, prn[2]),
+	FLD(6, PRN, struct nmea_gsa, prn[3]),
+	FLD(7, PRN, struct nmea_gsa, prn[4]),
+	FLD(8, PRN, struct nmea_gsa, prn[5]),
+	FLD(9, PRN, struct nmea_gsa, prn[6]),
+	FLD(10, PRN, struct nmea_gsa, prn[7]),
+	FLD(11, PRN, struct nmea_gsa, prn[8]),
+	FLD(12, PRN, struct nmea_gsa, prn[9]),
+	FLD(13, PRN, struct nmea_gsa, prn[10]),
+	FLD(14, PRN, struct nmea_gsa, prn[11]),
+	FLD(15, DOUBLE, struct nmea_gsa, pdop),
+	FLD(16, DOUBLE, struct nmea_gsa, hdop),
+	FLD(17, DOUBLE, struct nmea_gsa, vdop),
+};
+
+static const struct nmea_field gst_fields[] = {
+	FLD(1, DOUBLE, struct nmea_gst, utc_time),
+	FLD(2, DOUBLE, struct nmea_gst, rms),
+	FLD(3, DOUBLE, struct nmea_gst, sd_major),
+	FLD(4, DOUBLE, struct nmea_gst, sd_minor),
+	FLD(5, DOUBLE, struct nmea_gst, orientation),
+	FLD(6, DOUBLE, struct nmea_gst, sd_latitude),
+	FLD(7, DOUBLE, struct nmea_gst, sd_longitude),
+	FLD(8, DOUBLE, struct nmea_gst, sd_altitude),
+};
+
+#define TYPE(n, t, m, f)	{ n, t, offsetof(struct nmea_parser, m), \
+				  sizeof(((struct nmea_parser *)0)->m), \
+				  f, ARRAY_SIZE(f) }
+
+static const struct nmea_type nmea_types[] = {
+	TYPE("GGA", NMEA_GGA, gga, gga_fields),
+	TYPE("RMC", NMEA_RMC, rmc, rmc_fields),
+	TYPE("VTG", NMEA_VTG, vtg, vtg_fields),
+	TYPE("GSA", NMEA_GSA, gsa, gsa_fields),
+	TYPE("GST", NMEA_GST, gst, gst_fields),
+};
+
+/* Scratch copy of a sentence structure, committed when fully parsed */
+union nmea_scratch {
+	struct gga gga;
+	struct nmea_rmc rmc;
+	struct nmea_vtg vtg;
+	struct nmea_gsa gsa;
+	struct nmea_gst gst;
+};
+
+static const double nmea_pow10[NMEA_DIGITS_MAX + 1] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7,
+	1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+};
+
+void nmea_parser_init(struct nmea_parser *p)
+{
+	memset(p, 0, sizeof(struct nmea_parser));
+}
+
+static int nmea_hex(char c)
+{
+	if (c >= '0' && c <= '9')
+		return c - '0';
+	if (c >= 'A' && c <= 'F')
+		return c - 'A' + 10;
+	if (c >= 'a' && c <= 'f')
+		return c - 'a' + 10;
+	return -1;
+}
+
+/*
+ * Decimal number as integer mantissa scaled by a power of ten. Both are
+ * exact in a double, so the single division rounds the same as strtod()
+ * while not depending on locale.
+ */
+static int nmea_get_double(const char *s, const char *end, double *value)
+{
+	unsigned long long m = 0;
+	int seen = 0, digits = 0, frac = -1, neg = 0;
+
+	if (s < end && (*s == '-' || *s == '+'))
+		neg = (*s++ == '-');
+
+	for (; s < end; s++) {
+		if (*s >= '0' && *s <= '9') {
+			seen = 1;
+			/* Leading zeros don't take mantissa precision */
+			if ((m || *s != '0') && ++digits > NMEA_DIGITS_MAX)
+				return -1;
+			if (frac >= 0 && ++frac > NMEA_DIGITS_MAX)
+				return -1;
+			m = m * 10 + (*s - '0');
+		} else if (*s == '.' && frac < 0) {
+			frac = 0;
+		} else {
+			return -1;
+		}
+	}
+	if (!seen)
+		return -1;
+
+	*value = (double)m / nmea_pow10[frac > 0 ? frac : 0];
+	if (neg)
+		*value = -*value;
+	return 0;
+}
+
+static int nmea_get_int(const char *s, const char *end, int *value)
+{
+	int v = 0, neg = 0;
+
+	if (s < end && *s == '-') {
+		neg = 1;
+		s++;
+	}
+	if (s == end || end - s > 9)
+		return -1;
+
+	for (; s < end; s++) {
+		if (*s < '0' || *s > '9')
+			return -1;
+		v = v * 10 + (*s - '0');
+	}
+	*value = neg ? -v : v;
+	return 0;
+}
+
+static int nmea_get_field(const struct nmea_field *fld, void *base,
+			  const char *s, const char *end)
+{
+	char *dst = (char *)base + fld->offset;
+
+	if (s == end) {
+		/* Empty field keeps last value, but for satellite lists */
+		if (fld->type == NMEA_FLD_PRN)
+			*(int *)dst = 0;
+		return 0;
+	}
+
+	switch (fld->type) {
+	case NMEA_FLD_DOUBLE:
+		return nmea_get_double(s, end, (double *)dst);
+	case NMEA_FLD_INT:
+	case NMEA_FLD_PRN:
+		return nmea_get_int(s, end, (int *)dst);
+	case NMEA_FLD_CHAR:
+		if (end - s != 1)
+			return -1;
+		*dst = *s;
+		return 0;
+	}
+	return -1;
+}
+
+/* Parse fields of data part [s, end) into @base */
+static int nmea_get_fields(const struct nmea_type *type, void *base,
+			   const char *s, const char *end)
+{
+	const struct nmea_field *fld = type->fields;
+	const struct nmea_field *last = fld + type->nr_fields;
+	int index = 1;
+
+	while (fld < last) {
+		const char *comma = memchr(s, ',', end - s);
+		const char *fend = comma ? comma : end;
+
+		if (fld->index == index) {
+			if (nmea_get_field(fld, base, s, fend) != 0)
+				return -1;
+			fld++;
+		}
+		if (comma == NULL)
+			break;
+		s = comma + 1;
+		index++;
+	}
+
+	/* Trailing fields omitted by receiver are empty */
+	for (; fld < last; fld++)
+		nmea_get_field(fld, base, end, end);
+	return 0;
+}
+
+static const struct nmea_type *nmea_find_type(const char *addr, size_t len)
+{
+	int i;
+
+	/* Talker identifier (GP, GN, GL...) is not checked */
+	if (len != 5)
+		return NULL;
+
+	for (i = 0; i < ARRAY_SIZE(nmea_types); i++) {
+		if (memcmp(addr + 2, nmea_types[i].name, 3) == 0)
+			return &nmea_types[i];
+	}
+	return NULL;
+}
+
+nmea_sentence_t nmea_parse(struct nmea_parser *p, struct gps_data *gps,
+			   const char *s, size_t len)
+{
+	const struct nmea_type *type;
+	const char *data, *star;
+	union nmea_scratch tmp;
+	unsigned char sum = 0;
+	int hi, lo;
+	size_t i;
+
+	/* $<address>,<data>*hh */
+	if (len < 4 || s[0] != '$' || s[len - 3] != '*') {
+		p->stats.bad_frame++;
+		return NMEA_INVALID;
+	}
+	star = s + len - 3;
+	hi = nmea_hex(star[1]);
+	lo = nmea_hex(star[2]);
+	if (hi < 0 || lo < 0) {
+		p->stats.bad_frame++;
+		return NMEA_INVALID;
+	}
+
+	for (i = 1; s + i < star; i++)
+		sum ^= s[i];
+	if (sum != ((hi << 4) | lo)) {
+		p->stats.bad_checksum++;
+		return NMEA_INVALID;
+	}
+	p->stats.sentences++;
+
+	data = memchr(s + 1, ',', star - s - 1);
+	if (data == NULL)
+		data = star;
+	type = nmea_find_type(s + 1, data - s - 1);
+	if (type == NULL) {
+		p->stats.unknown++;
+		return NMEA_UNKNOWN;
+	}
+	if (data < star)
+		data++;
+
+	memcpy(&tmp, (char *)p + type->offset, type->size);
+	if (nmea_get_fields(type, &tmp, data, star) != 0) {
+		p->stats.bad_field[type->sentence]++;
+		return NMEA_INVALID;
+	}
+	memcpy((char *)p + type->offset, &tmp, type->size);
+
+	if (type->sentence == NMEA_GGA && gps != NULL) {
+		if (len > NMEA_STRING_LEN)
+			len = NMEA_STRING_LEN;
+		memcpy(gps->nmea_string, s, len);
+		gps->nmea_string[len] = '\0';
+		gps->gga = p->gga;
+	}
+	return type->sentence;
+}
@@ -0,0 +1,92 @@
+#ifndef NMEA_PARSE_H_INCLUDED
+#define NMEA_PARSE_H_INCLUDED
+
+#include <stddef.h>
+
+#include "gps.h"
+
+typedef enum {
+	NMEA_INVALID = -1,
+	NMEA_UNKNOWN = 0,	/* well formed, but not parsed */
+	NMEA_GGA,
+	NMEA_RMC,
+	NMEA_VTG,
+	NMEA_GSA,
+	NMEA_GST,
+	NMEA_SENTENCES_NR
+} nmea_sentence_t;
+
+#define NMEA_GSA_PRN_NR		12
+
+/* Recommended minimum data, position kept raw (ddmm.mmmm) as in GGA */
+struct nmea_rmc {
+	double utc_time;
+	char status;
+	double latitude;
+	char latitude_hemisphere;
+	double longitude;
+	char longitude_hemisphere;
+	double speed;			/* knots */
+	double course;			/* degrees true */
+	int date;			/* ddmmyy */
+	char mode;
+};
+
+struct nmea_vtg {
+	double course;			/* degrees true */
+	double course_magnetic;
+	double speed;			/* knots */
+	double speed_kmh;
+	char mode;
+};
+
+struct nmea_gsa {
+	char mode;
+	int fix_type;
+	int prn[NMEA_GSA_PRN_NR];	/* zero when unused */
+	double pdop, hdop, vdop;
+};
+
+/* Pseudorange error statistics, in metres */
+struct nmea_gst {
+	double utc_time;
+	double rms;
+	double sd_major, sd_minor, orientation;
+	double sd_latitude, sd_longitude, sd_altitude;
+};
+
+struct nmea_stats {
+	unsigned long sentences;	/* well formed lines */
+	unsigned long bad_frame;	/* no '$', '*' or hex checksum */
+	unsigned long bad_checksum;
+	unsigned long unknown;
+	/* Sentences dropped for a malformed field, per type */
+	unsigned long bad_field[NMEA_SENTENCES_NR];
+};
+
+/**
+ * Parser state, last accepted sentence of every type. A sentence is
+ * committed only when all its fields parsed, empty fields keep the
+ * value of the previous one.
+ */
+struct nmea_parser {
+	struct gga gga;
+	struct nmea_rmc rmc;
+	struct nmea_vtg vtg;
+	struct nmea_gsa gsa;
+	struct nmea_gst gst;
+	struct nmea_stats stats;
+};
+
+extern void nmea_parser_init(struct nmea_parser *p);
+
+/**
+ * Validate checksum of line @s of @len chars (as framed by nmea_ring)
+ * and parse it. Accepted GGA is copied into @gps together with the
+ * sentence itself, @gps may be NULL. Returns type of the sentence or
+ * NMEA_INVALID.
+ */
+extern nmea_sentence_t nmea_parse(struct nmea_parser *p, struct gps_data *gps,
+				  const char *s, size_t len);
+
+#endif	/* NMEA_PARSE_H_INCLUDED */
@@ -0,0 +1,159 @@
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include "nmea-ring.h"
+#include "debug.h"
+
+void nmea_ring_init(struct nmea_ring *r)
+{
+	r->head = r->scan = r->tail = 0;
+	r->cut = 0;
+	r->discard = 0;
+	r->overruns = 0;
+	r->frame_len = NULL;
+	r->frame_sync = 0;
+}
+
+void nmea_ring_set_framer(struct nmea_ring *r, unsigned char sync,
+			  nmea_frame_len_t frame_len)
+{
+	r->frame_sync = sync;
+	r->frame_len = frame_len;
+}
+
+/* Drop the frame handed out last, closing the gap in line before it */
+static void nmea_ring_cut(struct nmea_ring *r)
+{
+	unsigned int len = r->scan - r->head;
+
+	if (r->cut == 0)
+		return;
+	if (len)
+		memmove(r->buf + r->head + r->cut, r->buf + r->head, len);
+	r->head += r->cut;
+	r->scan += r->cut;
+	r->cut = 0;
+}
+
+/* Make room at the end of buffer moving the unfinished line to front */
+static void nmea_ring_compact(struct nmea_ring *r)
+{
+	unsigned int len = r->tail - r->head;
+
+	if (len >= NMEA_LINE_MAX && r->scan == r->tail) {
+		/* Line can't end in time, drop it up to next LF */
+		if (!r->discard)
+			r->overruns++;
+		r->discard = 1;
+		len = 0;
+	} else if (len) {
+		memmove(r->buf, r->buf + r->head, len);
+	}
+	r->scan -= r->tail - len;
+	r->head = 0;
+	r->tail = len;
+}
+
+ssize_t nmea_ring_fill(struct nmea_ring *r, int fd)
+{
+	ssize_t n;
+
+	nmea_ring_cut(r);
+	if (r->head == r->tail)
+		r->head = r->scan = r->tail = 0;
+	else if (NMEA_RING_SIZE - r->tail < NMEA_LINE_MAX)
+		nmea_ring_compact(r);
+	if (r->tail == NMEA_RING_SIZE)
+		return 0;	/* Lines have to be consumed first */
+
+	do {
+		n = read(fd, r->buf + r->tail, NMEA_RING_SIZE - r->tail);
+	} while (n < 0 && errno == EINTR);
+
+	if (n < 0) {
+		if (errno == EAGAIN)
+			return 0;
+		SYSERR("read() error.");
+		return -1;
+	} else if (n == 0) {
+		DEBUG("End of file on descriptor %d", fd);
+		return -1;
+	}
+	r->tail += n;
+	return n;
+}
+
+/*
+ * Look for a frame before @end, the line end or end of data. Returns 1
+ * with the frame in @v, 0 when scanned up to @end and -1 when waiting
+ * for the rest of a frame.
+ */
+static int nmea_ring_frame(struct nmea_ring *r, const char *end,
+			   struct nmea_view *v)
+{
+	char *p = r->buf + r->scan;
+	int n;
+
+	while ((p = memchr(p, r->frame_sync, end - p)) != NULL) {
+		n = r->frame_len(p, r->buf + r->tail - p);
+		if (n > 0) {
+			r->scan = p - r->buf;
+			r->cut = n;
+			v->s = p;
+			v->len = n;
+			v->frame = 1;
+			return 1;
+		}
+		/* Buffer full from start can't take the rest, no frame */
+		if (n == 0 && !(r->head == 0 && r->tail == NMEA_RING_SIZE)) {
+			r->scan = p - r->buf;
+			return -1;
+		}
+		p++;
+	}
+	return 0;
+}
+
+int nmea_ring_next(struct nmea_ring *r, struct nmea_view *v)
+{
+	nmea_ring_cut(r);
+	while (r->scan < r->tail) {
+		char *s = r->buf + r->head;
+		char *lf = memchr(r->buf + r->scan, '\n', r->tail - r->scan);
+		size_t len;
+		int rc;
+
+		if (r->frame_len) {
+			rc = nmea_ring_frame(r, lf ? lf : r->buf + r->tail, v);
+			if (rc > 0)
+				return 1;
+			if (rc < 0)
+				return 0;
+		}
+
+		if (lf == NULL) {
+			r->scan = r->tail;
+			return 0;
+		}
+		len = lf - s;
+		r->head = r->scan = lf - r->buf + 1;
+
+		if (r->discard) {
+			r->discard = 0;
+			continue;
+		}
+		if (len && s[len - 1] == '\r')
+			len--;
+		if (len == 0)
+			continue;
+
+		/* Line end is consumed already, reuse it as terminator */
+		s[len] = '\0';
+		v->s = s;
+		v->len = len;
+		v->frame = 0;
+		return 1;
+	}
+	return 0;
+}
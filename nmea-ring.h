@@ -0,0 +1,67 @@
+#ifndef NMEA_RING_H_INCLUDED
+#define NMEA_RING_H_INCLUDED
+
+#include <stddef.h>
+#include <sys/types.h>
+
+#define NMEA_RING_SIZE		1024
+/* Longest line kept, NovAtel ASCII logs exceed the 82 chars of NMEA */
+#define NMEA_LINE_MAX		(NMEA_RING_SIZE / 2)
+
+/**
+ * Length of binary frame at @data of @size bytes available: frame
+ * length once it is all there, 0 when more bytes are needed and -1
+ * when @data is no frame start.
+ */
+typedef int (*nmea_frame_len_t)(const void *data, size_t size);
+
+/**
+ * Receive buffer of one serial port splitting its input into lines
+ * ($GPGGA sentences, NovAtel '#' logs and '<' replies) in place.
+ * Data is read in one syscall per fill and consumed as views pointing
+ * into the buffer. Only an unfinished line is ever moved, when it
+ * reaches the end of the buffer.
+ *
+ * With a framer set, binary frames are cut out of the input before it
+ * is split into lines, so they never reach the line framer and a line
+ * interrupted by a frame is joined again.
+ */
+struct nmea_ring {
+	char buf[NMEA_RING_SIZE];
+	unsigned int head;		/* start of unconsumed data */
+	unsigned int scan;		/* searched for line end up to */
+	unsigned int tail;		/* end of received data */
+	unsigned int cut;		/* frame at scan handed out, to drop */
+	unsigned int discard : 1;	/* dropping rest of over-long line */
+	unsigned long overruns;		/* over-long lines dropped */
+	nmea_frame_len_t frame_len;	/* NULL for lines only */
+	unsigned char frame_sync;	/* first byte of a frame */
+};
+
+/*
+ * Line without CR LF, NUL terminated, or binary frame as is. Valid
+ * until the next fill.
+ */
+struct nmea_view {
+	const char *s;
+	size_t len;
+	unsigned int frame : 1;
+};
+
+extern void nmea_ring_init(struct nmea_ring *r);
+
+/* Hand out frames starting with @sync byte as measured by @frame_len */
+extern void nmea_ring_set_framer(struct nmea_ring *r, unsigned char sync,
+				 nmea_frame_len_t frame_len);
+
+/**
+ * Read what is pending on non-blocking @fd with a single read().
+ * Returns number of bytes added, 0 when nothing was pending and -1
+ * on error or end of file.
+ */
+extern ssize_t nmea_ring_fill(struct nmea_ring *r, int fd);
+
+/* Store next complete line or frame in @v, 0 when none is buffered */
+extern int nmea_ring_next(struct nmea_ring *r, struct nmea_view *v);
+
+#endif	/* NMEA_RING_H_INCLUDED */
@@ -0,0 +1,328 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+
+#include "novatel.h"
+#include "nmea.h"
+#include "debug.h"
+
+#define NOVATEL_HEADER_LEN	28
+#define NOVATEL_HEADER_MAX	64
+#define NOVATEL_CRC_LEN		4
+
+/* Message type: binary format, not a response */
+#define NOVATEL_MSG_FORMAT	0x60
+#define NOVATEL_MSG_RESPONSE	0x80
+
+#define NOVATEL_SOL_COMPUTED	0
+#define NOVATEL_UTC_VALID	1
+
+/* Until TIME log arrives, GPS is ahead of UTC by the leap seconds */
+#define NOVATEL_LEAP_SECONDS	18
+
+#define SECONDS_PER_DAY		86400.0
+
+static uint32_t novatel_crc_table[256];
+
+static void novatel_crc_init(void)
+{
+	uint32_t c;
+	int i, j;
+
+	for (i = 0; i < 256; i++) {
+		c = i;
+		for (j = 0; j < 8; j++)
+			c = (c & 1) ? (c >> 1) ^ 0xEDB88320 : c >> 1;
+		novatel_crc_table[i] = c;
+	}
+}
+
+unsigned int novatel_crc32(const unsigned char *data, size_t size)
+{
+	uint32_t crc = 0;
+
+	if (novatel_crc_table[1] == 0)
+		novatel_crc_init();
+
+	while (size--)
+		crc = (crc >> 8) ^ novatel_crc_table[(crc ^ *data++) & 0xff];
+	return crc;
+}
+
+static inline unsigned int get_u16(const unsigned char *p)
+{
+	return p[0] | (p[1] << 8);
+}
+
+static inline uint32_t get_u32(const unsigned char *p)
+{
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline float get_f32(const unsigned char *p)
+{
+	uint32_t u = get_u32(p);
+	float f;
+
+	memcpy(&f, &u, sizeof(f));
+	return f;
+}
+
+static inline double get_f64(const unsigned char *p)
+{
+	uint64_t u = get_u32(p) | ((uint64_t)get_u32(p + 4) << 32);
+	double d;
+
+	memcpy(&d, &u, sizeof(d));
+	return d;
+}
+
+void novatel_decoder_init(struct novatel_decoder *d)
+{
+	memset(d, 0, sizeof(struct novatel_decoder));
+	d->utc_offset = -NOVATEL_LEAP_SECONDS;
+}
+
+/* GGA quality indicator for BESTPOS position type */
+static int novatel_fix_quality(uint32_t pos_type)
+{
+	switch (pos_type) {
+	case 0:			/* NONE */
+		return 0;
+	case 16:		/* SINGLE */
+		return 1;
+	case 17:		/* PSRDIFF */
+	case 18:		/* WAAS */
+	case 20:		/* OMNISTAR */
+		return 2;
+	case 19:		/* PROPAGATED */
+		return 6;
+	case 48:		/* L1_INT */
+	case 49:		/* WIDE_INT */
+	case 50:		/* NARROW_INT */
+		return 4;
+	case 32:		/* L1_FLOAT */
+	case 33:		/* IONOFREE_FLOAT */
+	case 34:		/* NARROW_FLOAT */
+	case 64:		/* OMNISTAR_HP */
+	case 65:		/* OMNISTAR_XP */
+		return 5;
+	default:
+		return 1;
+	}
+}
+
+/* Degrees into raw NMEA ddmm.mmmm as kept in gga */
+static double novatel_nmea_angle(double deg)
+{
+	double d = floor(fabs(deg));
+
+	return d * 100.0 + (fabs(deg) - d) * 60.0;
+}
+
+/* GPS milliseconds of week into UTC hhmmss.ss */
+static double novatel_utc_time(const struct novatel_decoder *d, uint32_t ms)
+{
+	double t = fmod(ms / 1000.0 + d->utc_offset, SECONDS_PER_DAY);
+	int h, m;
+
+	if (t < 0)
+		t += SECONDS_PER_DAY;
+	h = t / 3600;
+	t -= h * 3600;
+	m = t / 60;
+	t -= m * 60;
+	return h * 10000.0 + m * 100.0 + t;
+}
+
+static void novatel_format_gga(struct gps_data *gps)
+{
+	const struct gga *gga = &gps->gga;
+	char *s = gps->nmea_string;
+	unsigned char sum = 0;
+	int len, i;
+
+	len = snprintf(s, NMEA_STRING_LEN - 2,
+		       "$GPGGA,%09.2lf,%010.5lf,%c,%011.5lf,%c,%d,%02d,,%.1lf,M,,M,,",
+		       gga->utc_time, gga->latitude, gga->latitude_hemisphere,
+		       gga->longitude, gga->longitude_hemisphere,
+		       gga->fix, gga->nsat, gga->altitude);
+	if (len > NMEA_STRING_LEN - 3)
+		len = NMEA_STRING_LEN - 3;
+
+	for (i = 1; i < len; i++)
+		sum ^= s[i];
+	snprintf(s + len, 4, "*%02X", sum);
+}
+
+static int novatel_bestpos(struct novatel_decoder *d, struct gps_data *gps,
+			   const unsigned char *hdr, const unsigned char *msg,
+			   unsigned int len)
+{
+	struct gga *gga = &gps->gga;
+	double lat, lon;
+
+	if (len < 72)
+		return 0;
+
+	gga->utc_time = novatel_utc_time(d, get_u32(hdr + 16));
+	if (get_u32(msg) != NOVATEL_SOL_COMPUTED) {
+		gga->fix = 0;
+		gga->nsat = 0;
+	} else {
+		lat = get_f64(msg + 8);
+		lon = get_f64(msg + 16);
+		gga->latitude = novatel_nmea_angle(lat);
+		gga->latitude_hemisphere = lat < 0 ? 'S' : 'N';
+		gga->longitude = novatel_nmea_angle(lon);
+		gga->longitude_hemisphere = lon < 0 ? 'W' : 'E';
+		gga->altitude = get_f64(msg + 24);
+		gga->alt_unit = 'M';
+		gga->fix = novatel_fix_quality(get_u32(msg + 4));
+		gga->nsat = msg[65];
+
+		d->latitude_sigma = get_f32(msg + 40);
+		d->longitude_sigma = get_f32(msg + 44);
+		d->height_sigma = get_f32(msg + 48);
+	}
+	novatel_format_gga(gps);
+	return NOVATEL_POS_UPDATE;
+}
+
+static int novatel_bestvel(struct novatel_decoder *d,
+			   const unsigned char *msg, unsigned int len)
+{
+	if (len < 44 || get_u32(msg) != NOVATEL_SOL_COMPUTED)
+		return 0;
+
+	d->speed = get_f64(msg + 16);
+	d->track = get_f64(msg + 24);
+	d->vertical_speed = get_f64(msg + 32);
+	return NOVATEL_VEL_UPDATE;
+}
+
+static int novatel_time(struct novatel_decoder *d,
+			const unsigned char *msg, unsigned int len)
+{
+	if (len < 44 || get_u32(msg + 40) != NOVATEL_UTC_VALID)
+		return 0;
+
+	d->utc_offset = get_f64(msg + 20);
+	d->utc_valid = 1;
+	return NOVATEL_TIME_UPDATE;
+}
+
+static int novatel_dispatch(struct novatel_decoder *d, struct gps_data *gps)
+{
+	const unsigned char *hdr = d->buf;
+	const unsigned char *msg = hdr + hdr[3];
+	unsigned int len = get_u16(hdr + 8);
+
+	if (hdr[6] & (NOVATEL_MSG_FORMAT | NOVATEL_MSG_RESPONSE)) {
+		d->stats.unknown++;
+		return 0;
+	}
+
+	switch (get_u16(hdr + 4)) {
+	case NOVATEL_BESTPOS:
+		return gps ? novatel_bestpos(d, gps, hdr, msg, len) : 0;
+	case NOVATEL_BESTVEL:
+		return novatel_bestvel(d, msg, len);
+	case NOVATEL_TIME:
+		return novatel_time(d, msg, len);
+	default:
+		d->stats.unknown++;
+		return 0;
+	}
+}
+
+int novatel_frame_len(const void *data, size_t size)
+{
+	const unsigned char *b = data;
+	unsigned int total;
+
+	if (b[0] != NOVATEL_SYNC0 ||
+	    (size > 1 && b[1] != NOVATEL_SYNC1) ||
+	    (size > 2 && b[2] != NOVATEL_SYNC2))
+		return -1;
+	if (size < 4)
+		return 0;
+	if (b[3] < NOVATEL_HEADER_LEN || b[3] > NOVATEL_HEADER_MAX)
+		return -1;
+	if (size < NOVATEL_HEADER_LEN)
+		return 0;
+
+	total = b[3] + get_u16(b + 8) + NOVATEL_CRC_LEN;
+	if (total > NOVATEL_FRAME_MAX)
+		return -1;
+	return size < total ? 0 : total;
+}
+
+/*
+ * Check collected bytes as a frame prefix. Returns frame length when
+ * complete and valid, 0 when more bytes are needed and -1 when bytes
+ * are no frame start.
+ */
+static int novatel_check(struct novatel_decoder *d)
+{
+	const unsigned char *b = d->buf;
+	int total = novatel_frame_len(b, d->len);
+
+	if (total <= 0)
+		return total;
+
+	if (novatel_crc32(b, total - NOVATEL_CRC_LEN) !=
+	    get_u32(b + total - NOVATEL_CRC_LEN)) {
+		d->stats.bad_crc++;
+		return -1;
+	}
+	return total;
+}
+
+static void novatel_drop(struct novatel_decoder *d, unsigned int n)
+{
+	d->len -= n;
+	if (d->len)
+		memmove(d->buf, d->buf + n, d->len);
+}
+
+/* Drop bytes up to the next sync candidate */
+static void novatel_resync(struct novatel_decoder *d)
+{
+	unsigned int n = 1;
+
+	while (n < d->len && d->buf[n] != NOVATEL_SYNC0)
+		n++;
+	d->stats.skipped += n;
+	novatel_drop(d, n);
+}
+
+int novatel_decode(struct novatel_decoder *d, struct gps_data *gps,
+		   const void *data, size_t size)
+{
+	const unsigned char *p = data;
+	const unsigned char *end = p + size;
+	int rc, mask = 0;
+
+	while (p < end) {
+		/* Skip garbage in bulk while out of sync */
+		if (d->len == 0 && *p != NOVATEL_SYNC0) {
+			d->stats.skipped++;
+			p++;
+			continue;
+		}
+		d->buf[d->len++] = *p++;
+
+		while (d->len && (rc = novatel_check(d)) != 0) {
+			if (rc < 0) {
+				novatel_resync(d);
+				continue;
+			}
+			d->stats.frames++;
+			mask |= novatel_dispatch(d, gps);
+			novatel_drop(d, rc);
+		}
+	}
+	return mask;
+}
@@ -0,0 +1,77 @@
+#ifndef NOVATEL_H_INCLUDED
+#define NOVATEL_H_INCLUDED
+
+#include <stddef.h>
+
+#include "gps.h"
+
+/*
+ * Binary logs decoded, requested by the default GPS commands with
+ *	LOG BESTPOSB ONTIME 0.2
+ *	LOG BESTVELB ONTIME 0.5
+ *	LOG TIMEB ONTIME 10
+ * which fit 9600 baud. Faster rates need GPS_BAUDRATE raised as well.
+ */
+#define NOVATEL_BESTPOS		42
+#define NOVATEL_BESTVEL		99
+#define NOVATEL_TIME		101
+
+/* Bits of mask returned by novatel_decode() */
+#define NOVATEL_POS_UPDATE	0x01
+#define NOVATEL_VEL_UPDATE	0x02
+#define NOVATEL_TIME_UPDATE	0x04
+
+#define NOVATEL_FRAME_MAX	256
+
+/* Frames start with these */
+#define NOVATEL_SYNC0		0xAA
+#define NOVATEL_SYNC1		0x44
+#define NOVATEL_SYNC2		0x12
+
+struct novatel_stats {
+	unsigned long frames;		/* frames passing CRC */
+	unsigned long bad_crc;
+	unsigned long skipped;		/* bytes dropped while in sync search */
+	unsigned long unknown;		/* other logs and responses */
+};
+
+struct novatel_decoder {
+	unsigned char buf[NOVATEL_FRAME_MAX];
+	unsigned int len;		/* bytes of frame collected */
+
+	double utc_offset;		/* UTC - GPS time, seconds */
+	unsigned int utc_valid : 1;
+
+	/* Last BESTPOS standard deviations, metres */
+	float latitude_sigma, longitude_sigma, height_sigma;
+
+	/* Last BESTVEL */
+	double speed;			/* horizontal, m/s */
+	double track;			/* degrees true */
+	double vertical_speed;		/* m/s, positive up */
+
+	struct novatel_stats stats;
+};
+
+extern void novatel_decoder_init(struct novatel_decoder *d);
+
+/**
+ * Feed @size received bytes, resynchronizing on the sync bytes after
+ * garbage or a frame failing CRC. BESTPOS is mapped into gps->gga and a
+ * GPGGA sentence rebuilt in gps->nmea_string for DOCH and console.
+ * Returns mask of NOVATEL_*_UPDATE for logs decoded.
+ */
+extern int novatel_decode(struct novatel_decoder *d, struct gps_data *gps,
+			  const void *data, size_t size);
+
+/**
+ * Length of frame at @data from its header, once all @size bytes of it
+ * arrived, 0 when more are needed and -1 when @data is no frame start.
+ * CRC is left to novatel_decode(). Fits nmea_ring_set_framer().
+ */
+extern int novatel_frame_len(const void *data, size_t size);
+
+/* CRC32 of NovAtel frames, over header and message */
+extern unsigned int novatel_crc32(const unsigned char *data, size_t size);
+
+#endif	/* NOVATEL_H_INCLUDED */
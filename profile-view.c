@@ -1,4 +1,5 @@
 #include <stdlib.h>
+#include <string.h>
 
 #include "profile-view.h"
 #include "svgalib-private.h"
@@ -22,9 +23,16 @@ struct profile_attribute {
 	int scale_index; /* current scale number */
 };
 
+/* Envelope of samples falling into one pixel column */
+struct profile_column {
+	double min, max;
+	double first, last;
+};
+
 struct profile_view_entry {
-	double *sample_list;
+	struct profile_column *column_list;
 	int sample_index;
+	int marker;	/* column of last drawn marker, -1 if none */
 	int color;
 };
 
@@ -32,6 +40,8 @@ struct gl_profile_view {
 	struct gl_frame frame;
 	struct profile_view_entry **entry_list;
 	struct profile_attribute attr;
+	unsigned char *dirty;	/* columns changed since last draw */
+	int nr_columns;
 	int nr_entries;
 	int sample_size;
 	int marker_color;
@@ -40,7 +50,11 @@ struct gl_profile_view {
 
 #define PROFILE_VIEW(frame) ((struct gl_profile_view *)frame)
 
-static struct profile_view_entry *profile_view_entry_create(int sample_size)
+/* Column dirty flags */
+#define PROFILE_COLUMN_CHANGED		0x01
+#define PROFILE_COLUMN_NEIGHBOUR	0x02
+
+static struct profile_view_entry *profile_view_entry_create(int nr_columns)
 {
 	struct profile_view_entry *en = NULL;
 
@@ -49,12 +63,13 @@ static struct profile_view_entry *profile_view_entry_create(int sample_size)
 		ERROR("Out of memory.");
 		goto exit;
 	}
-	en->sample_list = calloc(sample_size, sizeof(double));
-	if (en->sample_list == NULL) {
+	en->column_list = calloc(nr_columns, sizeof(struct profile_column));
+	if (en->column_list == NULL) {
 		ERROR("Out of memory.");
 		goto exit_free;
 	}
 	en->sample_index = -1;
+	en->marker = -1;
 	en->color = svgalib_get_color(10, 10, 10);
 	return en;
 
@@ -67,20 +82,48 @@ static struct profile_view_entry *profile_view_entry_create(int sample_size)
 static void profile_view_entry_destroy(struct profile_view_entry *en)
 {
 	if (en) {
-		free(en->sample_list);
+		free(en->column_list);
 		free(en);
 	}
 	en = NULL;
 }
 
+/* Pixel column of sample, several samples share a column if needed */
+static inline int profile_view_column(const struct gl_profile_view *pv,
+				      int sample)
+{
+	return (int)((long)sample * pv->nr_columns / pv->sample_size);
+}
+
+/**
+ * Fold sample into envelope of its column. The first sample landing
+ * in a column restarts the envelope as the sweep passes over it.
+ */
 void gl_profile_view_add_sample(struct gl_profile_view *pv,
 				int pos, double sample)
 {
 	struct profile_view_entry *en = pv->entry_list[pos];
-	if (en != NULL) {
-		en->sample_index = (en->sample_index + 1) % pv->sample_size;
-		en->sample_list[en->sample_index] = sample;
+	struct profile_column *col = NULL;
+	int c;
+
+	if (en == NULL)
+		return;
+
+	en->sample_index = (en->sample_index + 1) % pv->sample_size;
+	c = profile_view_column(pv, en->sample_index);
+	col = &en->column_list[c];
+
+	if (en->sample_index == 0 ||
+	    profile_view_column(pv, en->sample_index - 1) != c) {
+		col->min = col->max = col->first = sample;
+	} else {
+		if (sample < col->min)
+			col->min = sample;
+		if (sample > col->max)
+			col->max = sample;
 	}
+	col->last = sample;
+	pv->dirty[c] |= PROFILE_COLUMN_CHANGED;
 }
 
 void gl_profile_view_set_color(struct gl_profile_view *pv, int pos, int color)
@@ -103,58 +146,148 @@ static void profile_view_destroy(struct gl_frame *frm)
 			profile_view_entry_destroy(en);
 		}
 		free(pv->entry_list);
+		free(pv->dirty);
 		free(pv);
 	}
 	pv = NULL;
 }
 
+/* Screen row of sample value, values beyond frame height wrap around */
+static int profile_view_y(const struct gl_frame *frm, float scale,
+			  double value)
+{
+	int s = frm->yb + frm->height;
+	double y = value / scale;
+	int wrapped = ((int)y) % frm->height;
+
+	y = y / frm->height;
+	if (y < frm->yb || y > s)
+		y = s - wrapped;
+	else
+		y = s - y;
+
+	if (y < frm->yb + 2)
+		return frm->yb + 2;
+	if (y > s - 2)
+		return s - 2;
+	return (int)y;
+}
+
+/* Restore grid background of a single column inside the bevel */
+static void profile_view_clear_column(const struct gl_profile_view *pv, int x)
+{
+	const struct gl_frame *frm = &pv->frame;
+	int yb = frm->yb + 2, ye = frm->yb + frm->height - 2;
+	register int y;
+
+	if ((x - frm->xb) % PROFILE_GRID_SIZE == 0) {
+		svgalib_draw_line(x, yb, x, ye, pv->grid_color);
+		return;
+	}
+
+	svgalib_draw_line(x, yb, x, ye, svgalib_get_color(0, 0, 0));
+	y = frm->yb + PROFILE_GRID_SIZE;
+	for (; y <= ye; y += PROFILE_GRID_SIZE)
+		svgalib_set_pixel(x, y, pv->grid_color);
+}
+
+static void profile_view_plot_column(const struct gl_profile_view *pv,
+				     const struct profile_view_entry *en,
+				     int c, float scale)
+{
+	const struct gl_frame *frm = &pv->frame;
+	const struct profile_column *col = &en->column_list[c];
+	int x = frm->xb + 2 + c;
+
+	if (c > 0)
+		svgalib_draw_line(x - 1,
+				  profile_view_y(frm, scale,
+						 en->column_list[c - 1].last),
+				  x, profile_view_y(frm, scale, col->first),
+				  en->color);
+	if (col->min != col->max)
+		svgalib_draw_line(x, profile_view_y(frm, scale, col->min),
+				  x, profile_view_y(frm, scale, col->max),
+				  en->color);
+}
+
+static void profile_view_plot_marker(const struct gl_profile_view *pv,
+				     int c)
+{
+	const struct gl_frame *frm = &pv->frame;
+	int x = frm->xb + 2 + c;
+	int xb = x > frm->xb + 2 ? x - 1 : x;
+	int xe = c < pv->nr_columns - 1 ? x + 1 : x;
+
+	for (x = xb; x <= xe; x++)
+		svgalib_draw_line(x, frm->yb + 2, x,
+				  frm->yb + frm->height - 2, pv->marker_color);
+}
+
+/**
+ * Invalidated frame (first draw, scale change) is rebuilt from column
+ * envelopes. Otherwise only columns touched by new samples and moved
+ * markers are restored, together with their neighbours which share
+ * connecting lines and marker width.
+ */
 static void profile_view_draw(struct gl_frame *frm)
 {
 	struct gl_profile_view *pv = PROFILE_VIEW(frm);
-	register int i, j, k;
-	int e, s;
+	unsigned char *dirty = pv->dirty;
+	int nr = pv->nr_columns;
 	float scale = gl_profile_view_get_scale(pv);
 	char txt[64] = "";
+	register int c, k;
 
-	e = frm->xb + frm->width;
-	s = frm->yb + frm->height;
+	if (frm->dirty) {
+		svgalib_draw_grid(frm->xb, frm->yb, frm->width, frm->height,
+				  PROFILE_GRID_SIZE, pv->grid_color);
+		memset(dirty, PROFILE_COLUMN_CHANGED, nr);
+	}
+
+	for (k = 0; k < pv->nr_entries; k++) {
+		struct profile_view_entry *en = pv->entry_list[k];
+		if (en == NULL || en->marker < 0)
+			continue;
+		dirty[en->marker] |= PROFILE_COLUMN_CHANGED;
+	}
 
-	/* Border */
-	svgalib_draw_grid(frm->xb, frm->yb, frm->width, frm->height,
-			  PROFILE_GRID_SIZE, pv->grid_color);
+	for (c = 0; c < nr; c++) {
+		if (!(dirty[c] & PROFILE_COLUMN_CHANGED))
+			continue;
+		if (c > 0)
+			dirty[c - 1] |= PROFILE_COLUMN_NEIGHBOUR;
+		if (c < nr - 1)
+			dirty[c + 1] |= PROFILE_COLUMN_NEIGHBOUR;
+	}
+
+	if (!frm->dirty) {
+		for (c = 0; c < nr; c++) {
+			if (dirty[c])
+				profile_view_clear_column(pv, frm->xb + 2 + c);
+		}
+	}
 
 	for (k = 0; k < pv->nr_entries; k++) {
 		struct profile_view_entry *en = pv->entry_list[k];
 		if (en == NULL)
 			continue;
 
-		/* Draw all samples of each entry */
-		for (i = frm->xb + 2, j = 1;
-		     (j < pv->sample_size) && (i < e); i++, j++) {
-			double y1 = en->sample_list[j - 1] / scale;
-			double y2 = en->sample_list[j] / scale;
-			int y3 = ((int)y1) % frm->height;
-			int y4 = ((int)y2) % frm->height;
-			y1 = y1 / frm->height;
-			y2 = y2 / frm->height;
-
-			if (y1 < frm->yb || y1 > s)
-				y1 = s - y3;
-			else
-				y1 = s - y1;
-
-			if (y2 < frm->yb || y2 > s)
-				y2 = s - y4;
-			else
-				y2 = s - y2;
-
-			svgalib_draw_line(i - 1, y1, i, y2, en->color);
-
-			if (j == en->sample_index)
-				svgalib_draw_thick_line(i, frm->yb, i,
-						  s, pv->marker_color);
+		for (c = 0; c < nr; c++) {
+			if (dirty[c] || (c > 0 && dirty[c - 1]))
+				profile_view_plot_column(pv, en, c, scale);
 		}
 	}
+
+	for (k = 0; k < pv->nr_entries; k++) {
+		struct profile_view_entry *en = pv->entry_list[k];
+		if (en == NULL || en->sample_index < 0)
+			continue;
+		en->marker = profile_view_column(pv, en->sample_index);
+		profile_view_plot_marker(pv, en->marker);
+	}
+	memset(dirty, 0, nr);
+
 	snprintf(txt, 64, "%.1f pT/div", scale * PROFILE_GRID_SIZE);
 	svgalib_display_text(frm->xb + 5, frm->yb + 5, txt, FONT_7x14,
 				frm->color, svgalib_get_color(0, 31, 0));
@@ -179,9 +312,20 @@ int gl_profile_view_create(struct gl_frame **out, int x, int y, int w, int h,
 		goto exit_free;
 	}
 
+	/* Columns inside the bevel, at least one sample per column */
 	pv->sample_size = sample_size;
+	pv->nr_columns = w - 3;
+	if (pv->nr_columns > sample_size)
+		pv->nr_columns = sample_size;
+
+	pv->dirty = calloc(pv->nr_columns, sizeof(unsigned char));
+	if (pv->dirty == NULL) {
+		ERROR("Out of memory");
+		goto exit_free_list;
+	}
+
 	for (i = 0; i < nr_entries; i++) {
-		pv->entry_list[i] = profile_view_entry_create(pv->sample_size);
+		pv->entry_list[i] = profile_view_entry_create(pv->nr_columns);
 		if (pv->entry_list[i] == NULL)
 			DEBUG("profile_view_entry_create() failed");
 	}
@@ -196,6 +340,8 @@ int gl_profile_view_create(struct gl_frame **out, int x, int y, int w, int h,
 	*out = GL_FRAME(pv);
 	return 0;
 
+ exit_free_list:
+	free(pv->entry_list);
  exit_free:
 	free(pv);
  exit:
@@ -0,0 +1,206 @@
+#include <stdlib.h>
+#include <errno.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+
+#include "reactor.h"
+#include "debug.h"
+
+#define REACTOR_EVENTS_NR	8
+
+struct reactor_source {
+	int fd;
+	reactor_handler_t handler;
+	void *userdata;
+	struct reactor_source *next;
+};
+
+struct reactor {
+	int epfd;
+	int timerfd;
+	struct reactor_source timer;
+	struct reactor_source *sources;
+};
+
+static struct reactor_source *reactor_find(struct reactor *r, int fd)
+{
+	struct reactor_source *src;
+
+	for (src = r->sources; src != NULL; src = src->next)
+		if (src->fd == fd)
+			return src;
+	return NULL;
+}
+
+int reactor_create(struct reactor **out)
+{
+	struct reactor *r = calloc(1, sizeof(struct reactor));
+	if (r == NULL) {
+		SYSERR("Failed to allocate reactor.");
+		return -1;
+	}
+
+	r->timerfd = -1;
+	r->epfd = epoll_create1(EPOLL_CLOEXEC);
+	if (r->epfd < 0) {
+		SYSERR("epoll_create1() failed.");
+		free(r);
+		return -1;
+	}
+	*out = r;
+	return 0;
+}
+
+void reactor_destroy(struct reactor *r)
+{
+	struct reactor_source *src, *next;
+
+	if (r == NULL)
+		return;
+
+	for (src = r->sources; src != NULL; src = next) {
+		next = src->next;
+		free(src);
+	}
+	if (r->timerfd >= 0)
+		close(r->timerfd);
+	close(r->epfd);
+	free(r);
+}
+
+int reactor_add(struct reactor *r, int fd,
+		reactor_handler_t handler, void *userdata)
+{
+	struct reactor_source *src = reactor_find(r, fd);
+	struct epoll_event ev;
+
+	if (fd < 0 || handler == NULL) {
+		ERROR("Invalid argument.");
+		return -1;
+	}
+
+	if (src != NULL) {
+		src->handler = handler;
+		src->userdata = userdata;
+		return 0;
+	}
+
+	src = malloc(sizeof(struct reactor_source));
+	if (src == NULL) {
+		SYSERR("Failed to allocate reactor source.");
+		return -1;
+	}
+	src->fd = fd;
+	src->handler = handler;
+	src->userdata = userdata;
+
+	ev.events = EPOLLIN;
+	ev.data.ptr = src;
+	if (epoll_ctl(r->epfd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+		SYSERR("epoll_ctl() failed to add descriptor %d.", fd);
+		free(src);
+		return -1;
+	}
+	src->next = r->sources;
+	r->sources = src;
+	return 0;
+}
+
+int reactor_remove(struct reactor *r, int fd)
+{
+	struct reactor_source **pp, *src;
+
+	for (pp = &r->sources; *pp != NULL; pp = &(*pp)->next) {
+		if ((*pp)->fd == fd)
+			break;
+	}
+	src = *pp;
+	if (src == NULL) {
+		WARN("Descriptor %d not watched.", fd);
+		return -1;
+	}
+
+	*pp = src->next;
+	free(src);
+	if (epoll_ctl(r->epfd, EPOLL_CTL_DEL, fd, NULL) != 0) {
+		SYSERR("epoll_ctl() failed to remove descriptor %d.", fd);
+		return -1;
+	}
+	return 0;
+}
+
+int reactor_set_timer(struct reactor *r, int period,
+		      reactor_handler_t handler, void *userdata)
+{
+	struct itimerspec its;
+
+	if (r->timerfd < 0) {
+		struct epoll_event ev;
+
+		if (period <= 0)
+			return 0;
+
+		r->timerfd = timerfd_create(CLOCK_MONOTONIC,
+					    TFD_NONBLOCK | TFD_CLOEXEC);
+		if (r->timerfd < 0) {
+			SYSERR("timerfd_create() failed.");
+			return -1;
+		}
+		r->timer.fd = r->timerfd;
+
+		ev.events = EPOLLIN;
+		ev.data.ptr = &r->timer;
+		if (epoll_ctl(r->epfd, EPOLL_CTL_ADD, r->timerfd, &ev) != 0) {
+			SYSERR("epoll_ctl() failed to add timer.");
+			close(r->timerfd);
+			r->timerfd = -1;
+			return -1;
+		}
+	}
+	r->timer.handler = handler;
+	r->timer.userdata = userdata;
+
+	if (period < 0)
+		period = 0;
+	its.it_value.tv_sec = period / 1000;
+	its.it_value.tv_nsec = (period % 1000) * 1000000L;
+	its.it_interval = its.it_value;
+	if (timerfd_settime(r->timerfd, 0, &its, NULL) != 0) {
+		SYSERR("timerfd_settime() failed.");
+		return -1;
+	}
+	return 0;
+}
+
+int reactor_run_once(struct reactor *r, int timeout)
+{
+	struct epoll_event ev[REACTOR_EVENTS_NR];
+	int n, i, called = 0;
+
+	n = epoll_wait(r->epfd, ev, REACTOR_EVENTS_NR, timeout);
+	if (n < 0) {
+		if (errno == EINTR)
+			return 0;
+		SYSERR("epoll_wait() failed.");
+		return -1;
+	}
+
+	for (i = 0; i < n; i++) {
+		struct reactor_source *src = ev[i].data.ptr;
+
+		if (src == &r->timer) {
+			uint64_t expired;
+
+			/* Drain expiration count, late ticks are coalesced */
+			if (read(r->timerfd, &expired, sizeof(expired)) < 0)
+				continue;
+			if (r->timer.handler == NULL)
+				continue;
+		}
+		src->handler(src->fd, ev[i].events, src->userdata);
+		called++;
+	}
+	return called;
+}
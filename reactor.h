@@ -0,0 +1,39 @@
+#ifndef REACTOR_H_INCLUDED
+#define REACTOR_H_INCLUDED
+
+/**
+ * Single epoll loop owning device descriptors and a periodic timer.
+ * Readiness is dispatched straight to the handler registered with the
+ * descriptor, so a byte arriving costs one wakeup and no per-call select.
+ */
+struct reactor;
+
+/* Called with descriptor and epoll events it became ready for */
+typedef void (*reactor_handler_t)(int fd, unsigned int events,
+				  void *userdata);
+
+extern int reactor_create(struct reactor **out);
+
+extern void reactor_destroy(struct reactor *r);
+
+/* Watch @fd for input, replacing handler when already watched */
+extern int reactor_add(struct reactor *r, int fd,
+		       reactor_handler_t handler, void *userdata);
+
+/* Stop watching @fd, handlers may remove only their own descriptor */
+extern int reactor_remove(struct reactor *r, int fd);
+
+/**
+ * Call @handler every @period ms from the loop, zero period stops
+ * the timer. Missed expirations are coalesced into one call.
+ */
+extern int reactor_set_timer(struct reactor *r, int period,
+			     reactor_handler_t handler, void *userdata);
+
+/**
+ * Wait up to @timeout ms (-1 forever) and dispatch ready descriptors.
+ * Returns number of handlers called, 0 on timeout and -1 on error.
+ */
+extern int reactor_run_once(struct reactor *r, int timeout);
+
+#endif	/* REACTOR_H_INCLUDED */
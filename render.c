@@ -0,0 +1,82 @@
+#include "render.h"
+#include "timing.h"
+#include "debug.h"
+
+#define RENDER_FRAME_RATE_MAX	100
+
+int render_frame_rate = 10;
+int render_latency_budget = 150;
+
+void render_sched_init(struct render_sched *rs,
+		       int frame_rate, int latency_budget)
+{
+	if (frame_rate <= 0 || frame_rate > RENDER_FRAME_RATE_MAX) {
+		WARN("Invalid render frame rate %d, using %d",
+		     frame_rate, RENDER_FRAME_RATE_MAX);
+		frame_rate = RENDER_FRAME_RATE_MAX;
+	}
+	if (latency_budget < 0)
+		latency_budget = 0;
+
+	rs->rc = RC_NONE;
+	rs->urgent = 0;
+	rs->interval = 1000 / frame_rate;
+	rs->budget = latency_budget;
+	rs->last = timing_now_ms() - rs->interval;
+	rs->first = 0;
+}
+
+void render_sched_post(struct render_sched *rs, rc_t rc, unsigned int urgent)
+{
+	if (rc == RC_NONE && !urgent)
+		return;
+
+	if (rs->rc == RC_NONE && !rs->urgent)
+		rs->first = timing_now_ms();
+	rs->rc |= rc;
+	if (urgent)
+		rs->urgent = 1;
+}
+
+/* Time when pending updates are due, frame rate or latency whichever first */
+static unsigned long render_sched_deadline(const struct render_sched *rs)
+{
+	unsigned long next = rs->last + rs->interval;
+	unsigned long limit = rs->first + rs->budget;
+
+	return timing_after_eq(limit, next) ? next : limit;
+}
+
+int render_sched_due(const struct render_sched *rs)
+{
+	if (rs->urgent)
+		return 1;
+	if (rs->rc == RC_NONE)
+		return 0;
+	return timing_after_eq(timing_now_ms(), render_sched_deadline(rs));
+}
+
+int render_sched_timeout(const struct render_sched *rs, int timeout)
+{
+	long left;
+
+	if (rs->urgent)
+		return 0;
+	if (rs->rc == RC_NONE)
+		return timeout;
+
+	left = (long)(render_sched_deadline(rs) - timing_now_ms());
+	if (left <= 0)
+		return 0;
+	return left < timeout ? (int)left : timeout;
+}
+
+rc_t render_sched_done(struct render_sched *rs)
+{
+	rc_t rc = rs->rc;
+
+	rs->rc = RC_NONE;
+	rs->urgent = 0;
+	rs->last = timing_now_ms();
+	return rc;
+}
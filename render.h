@@ -0,0 +1,40 @@
+#ifndef RENDER_H_INCLUDED
+#define RENDER_H_INCLUDED
+
+#include "internals.h"
+
+/* Tunables read from configuration file, see config.c */
+extern int render_frame_rate;
+extern int render_latency_budget;
+
+/**
+ * Render scheduler coalescing update masks between two screen refreshes.
+ * Refresh happens at most once per frame interval unless an update is
+ * urgent, and no update waits longer than the latency budget.
+ */
+struct render_sched {
+	rc_t rc;		/* updates since last render */
+	unsigned int urgent : 1;
+	long interval;		/* minimal time between renders, ms */
+	long budget;		/* maximal delay of an update, ms */
+	unsigned long last;	/* time of last render, ms */
+	unsigned long first;	/* time of oldest unrendered update, ms */
+};
+
+extern void render_sched_init(struct render_sched *rs,
+			      int frame_rate, int latency_budget);
+
+/* Record update mask, @urgent forces render on next check */
+extern void render_sched_post(struct render_sched *rs, rc_t rc,
+			      unsigned int urgent);
+
+/* Non zero when pending updates have to be rendered now */
+extern int render_sched_due(const struct render_sched *rs);
+
+/* Clip event wait @timeout (ms) to the moment next render is due */
+extern int render_sched_timeout(const struct render_sched *rs, int timeout);
+
+/* Mark pending updates as rendered, returns their mask */
+extern rc_t render_sched_done(struct render_sched *rs);
+
+#endif	/* RENDER_H_INCLUDED */
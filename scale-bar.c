@@ -1,10 +1,15 @@
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
 
 #include "scale-bar.h"
 #include "svgalib-private.h"
 #include "debug.h"
 
+#define SCALE_BAR_PIXELS_PER_UNIT	5
+
+/* Tape is pre-rendered for this many bar lengths around current value */
+#define SCALE_BAR_TAPE_SPAN		3
 
 static void gl_scale_bar_adjust_text_positions(struct gl_scale_bar *sbar,
                                                 struct gl_frame *frm)
@@ -31,25 +36,219 @@ static void gl_scale_bar_adjust_text_positions(struct gl_scale_bar *sbar,
 	}
 }
 
-static int gl_scale_bar_color_callback_default(int curr, int mid,
+static int gl_scale_bar_color_callback_default(int value, int highlight,
 					       const void *data)
 {
-	int scaled = (mid - curr) / 5;
-	int color = svgalib_get_color(5, 5, 5);
+	if (value % 10 == 0)
+		return svgalib_get_color(10, 10, 10);
+	return svgalib_get_color(5, 5, 5);
+}
+
+static inline int floor_div(int a, int b)
+{
+	return (a >= 0) ? a / b : -((-a + b - 1) / b);
+}
+
+static inline int gl_scale_bar_is_vertical(const struct gl_scale_bar *sbar)
+{
+	return (sbar->pointer == GL_SCALE_POINTER_LEFT ||
+		sbar->pointer == GL_SCALE_POINTER_RIGHT);
+}
+
+/* Tape index of tape coordinate, vertical tapes grow upwards */
+static inline int gl_scale_bar_tape_index(const struct gl_scale_bar *sbar,
+					  int t)
+{
+	const struct gl_scale_bar_tape *tape = &sbar->tape;
+
+	if (gl_scale_bar_is_vertical(sbar))
+		return tape->origin + tape->length - 1 - t;
+	return t - tape->origin;
+}
+
+/**
+ * Tape index of first screen position of the bar. Tape coordinate of a
+ * screen position is curr + (mid - i) on vertical tapes and curr + (i - mid)
+ * on horizontal ones.
+ */
+static inline int gl_scale_bar_window(const struct gl_scale_bar *sbar,
+				      int curr, int start, int mid)
+{
+	if (gl_scale_bar_is_vertical(sbar))
+		return gl_scale_bar_tape_index(sbar, curr + mid - start);
+	return gl_scale_bar_tape_index(sbar, curr + start - mid);
+}
+
+static void gl_scale_bar_tape_free(struct gl_scale_bar_tape *tape)
+{
+	free(tape->normal);
+	free(tape->highlight);
+	tape->normal = tape->highlight = NULL;
+	tape->length = tape->width = 0;
+	tape->valid = 0;
+}
+
+static int gl_scale_bar_tape_alloc(struct gl_scale_bar_tape *tape,
+				   int length, int width)
+{
+	size_t size = length * width * sizeof(svgalib_pixel_t);
+
+	if (tape->normal && tape->length == length && tape->width == width)
+		return 0;
+
+	gl_scale_bar_tape_free(tape);
+	tape->normal = malloc(size);
+	tape->highlight = malloc(size);
+	if (tape->normal == NULL || tape->highlight == NULL) {
+		SYSERR("Failed to allocate scale bar tape.");
+		gl_scale_bar_tape_free(tape);
+		return -1;
+	}
+	tape->length = length;
+	tape->width = width;
+	return 0;
+}
+
+/* Render tape pattern centred on tape coordinate @center */
+static void gl_scale_bar_tape_render(struct gl_scale_bar *sbar, int center)
+{
+	struct gl_scale_bar_tape *tape = &sbar->tape;
+	int vertical = gl_scale_bar_is_vertical(sbar);
+	int normal = 0, highlight = 0, prev = 0;
+	register int i, j;
+
+	tape->origin = center - (tape->length >> 1);
+	tape->callback = sbar->callback;
+	tape->callback_data = sbar->callback_data;
+
+	for (i = 0; i < tape->length; i++) {
+		int t = vertical ? tape->origin + tape->length - 1 - i :
+				   tape->origin + i;
+		int value = floor_div(t, SCALE_BAR_PIXELS_PER_UNIT);
+
+		if (i == 0 || value != prev) {
+			normal = sbar->callback(value, 0, sbar->callback_data);
+			highlight = sbar->callback(value, 1,
+						   sbar->callback_data);
+			prev = value;
+		}
+
+		for (j = 0; j < tape->width; j++) {
+			int k = vertical ? i * tape->width + j :
+					   j * tape->length + i;
+			tape->normal[k] = normal;
+			tape->highlight[k] = highlight;
+		}
+	}
+	tape->valid = 1;
+}
+
+/* Blit tape pixels for screen positions [a, b) along scale axis */
+static void gl_scale_bar_tape_blit(struct gl_scale_bar *sbar,
+				   const svgalib_pixel_t *buf,
+				   int a, int b, int index)
+{
+	struct gl_frame *frm = GL_FRAME(sbar);
+	const struct gl_scale_bar_tape *tape = &sbar->tape;
 
-	if (scaled % 10 == 0)
-		color = svgalib_get_color(10, 10, 10);
+	switch (sbar->pointer) {
+	case GL_SCALE_POINTER_LEFT:
+		svgalib_put_box(frm->xb, a, tape->width, b - a,
+				buf + index * tape->width, tape->width);
+		break;
+	case GL_SCALE_POINTER_RIGHT:
+		svgalib_put_box(frm->xb + frm->width - tape->width + 1, a,
+				tape->width, b - a,
+				buf + index * tape->width, tape->width);
+		break;
+	case GL_SCALE_POINTER_TOP:
+		svgalib_put_box(a, frm->yb, b - a, tape->width,
+				buf + index, tape->length);
+		break;
+	case GL_SCALE_POINTER_BOTTOM:
+		svgalib_put_box(a, frm->yb + frm->height - tape->width + 1,
+				b - a, tape->width, buf + index, tape->length);
+		break;
+	default:
+		break;
+	}
+}
 
-	return color;
+/* Pointer is drawn over tape where it is within pointer width of middle */
+static void gl_scale_bar_draw_pointer(struct gl_scale_bar *sbar,
+				      int mid, int pointer_width)
+{
+	struct gl_frame *frm = GL_FRAME(sbar);
+	int xb = frm->xb, yb = frm->yb, pw = pointer_width;
+	int xe = frm->xb + frm->width, ye = frm->yb + frm->height;
+
+	switch (sbar->pointer) {
+	case GL_SCALE_POINTER_LEFT: {
+		int pgn[] = {
+			xb + 1, mid,
+			xb + pw + 1, mid - pw,
+			xe, mid - pw,
+			xe, mid + pw + 1,
+			xb + pw + 2, mid + pw + 1,
+		};
+		svgalib_fill_polygon(pgn, 5, sbar->pointer_color);
+		break;
+	}
+	case GL_SCALE_POINTER_RIGHT: {
+		int pgn[] = {
+			xe - 1, mid,
+			xe - pw - 1, mid - pw,
+			xb, mid - pw,
+			xb, mid + pw + 1,
+			xe - pw - 2, mid + pw + 1,
+		};
+		svgalib_fill_polygon(pgn, 5, sbar->pointer_color);
+		break;
+	}
+	case GL_SCALE_POINTER_TOP: {
+		int pgn[] = {
+			mid, yb + 1,
+			mid + pw, yb + pw + 1,
+			mid + pw, ye + 1,
+			mid - pw, ye + 1,
+			mid - pw, yb + pw + 1,
+		};
+		svgalib_fill_polygon(pgn, 5, sbar->pointer_color);
+		break;
+	}
+	case GL_SCALE_POINTER_BOTTOM: {
+		/*
+		 * Scanlines are sampled at their top and the bottom vertex
+		 * row is not filled, so slants run on to row ye, one pixel
+		 * past the tip, to keep the tip pixel at (mid, ye - 1).
+		 */
+		int pgn[] = {
+			mid - pw, yb,
+			mid + pw, yb,
+			mid + pw, ye - pw - 1,
+			mid - 1, ye,
+			mid + 1, ye,
+			mid - pw, ye - pw - 1,
+		};
+		svgalib_fill_polygon(pgn, 6, sbar->pointer_color);
+		break;
+	}
+	default:
+		break;
+	}
 }
 
 static void gl_scale_bar_draw(struct gl_frame *frm)
 {
 	struct gl_scale_bar *sbar = GL_SCALE_BAR(frm);
-	int color, start, mid, end, pointer_width, i;
+	struct gl_scale_bar_tape *tape = &sbar->tape;
+	int start, mid, end, pointer_width;
+	int curr, ref, index, lo, hi, a, b;
 
-	if (sbar->pointer == GL_SCALE_POINTER_LEFT ||
-	    sbar->pointer == GL_SCALE_POINTER_RIGHT) {
+	if (sbar->pointer == GL_SCALE_POINTER_NONE)
+		goto text;
+
+	if (gl_scale_bar_is_vertical(sbar)) {
 		start = frm->yb;
 		mid = frm->yb + (frm->height >> 1);
 		end = frm->yb + frm->height;
@@ -61,56 +260,47 @@ static void gl_scale_bar_draw(struct gl_frame *frm)
 		pointer_width = frm->height >> 1;
 	}
 
-	for (i = start; i < end; ++i) {
-		int width, abs_width, pointer_region;
+	if (gl_scale_bar_tape_alloc(tape, SCALE_BAR_TAPE_SPAN * (end - start),
+				    pointer_width + 1) < 0)
+		goto text;
 
-		abs_width = abs(mid - i);
-		if (abs_width <= pointer_width) {
-			width = abs_width;
-			pointer_region = 1;
-		} else {
-			width = pointer_width;
-			pointer_region = 0;
-		}
+	/* Tape coordinates of current value and reference */
+	curr = lround(sbar->value * SCALE_BAR_PIXELS_PER_UNIT);
+	ref = lround(sbar->reference * SCALE_BAR_PIXELS_PER_UNIT);
 
-		color = sbar->callback(i, mid, sbar->callback_data);
-
-		switch (sbar->pointer) {
-		case GL_SCALE_POINTER_LEFT:
-			if (pointer_region)
-				svgalib_draw_hline(frm->xb, i,
-						   frm->xb + frm->width,
-						   sbar->pointer_color);
-			svgalib_draw_hline(frm->xb, i, frm->xb + width, color);
-			break;
-		case GL_SCALE_POINTER_RIGHT:
-			if (pointer_region)
-				svgalib_draw_hline(frm->xb, i,
-						   frm->xb + frm->width,
-						   sbar->pointer_color);
-			svgalib_draw_hline(frm->xb + frm->width - width, i,
-					   frm->xb + frm->width, color);
-			break;
-		case GL_SCALE_POINTER_TOP:
-			if (pointer_region)
-				svgalib_draw_line(i, frm->yb, i,
-						  frm->yb + frm->height,
-						  sbar->pointer_color);
-			svgalib_draw_line(i, frm->yb, i, frm->yb + width, color);
-			break;
-		case GL_SCALE_POINTER_BOTTOM:
-			if (pointer_region)
-				svgalib_draw_line(i, frm->yb, i,
-						  frm->yb + frm->height,
-						  sbar->pointer_color);
-			svgalib_draw_line(i, frm->yb + frm->height - width,
-					  i, frm->yb + frm->height, color);
-			break;
-		default:
-			break;
-		}
+	index = gl_scale_bar_window(sbar, curr, start, mid);
+	if (!tape->valid || tape->callback != sbar->callback ||
+	    tape->callback_data != sbar->callback_data ||
+	    tape->reference != ref || index < 0 ||
+	    index + end - start > tape->length) {
+		tape->reference = ref;
+		gl_scale_bar_tape_render(sbar, curr);
+		index = gl_scale_bar_window(sbar, curr, start, mid);
 	}
 
+	gl_scale_bar_tape_blit(sbar, tape->normal, start, end, index);
+
+	/* Highlight band between reference and current value */
+	lo = (curr < ref ? curr : ref) + 1;
+	hi = (curr < ref ? ref : curr);
+	if (gl_scale_bar_is_vertical(sbar)) {
+		a = curr + mid - hi;
+		b = curr + mid - lo + 1;
+	} else {
+		a = lo - curr + mid;
+		b = hi - curr + mid + 1;
+	}
+	if (a < start)
+		a = start;
+	if (b > end)
+		b = end;
+	if (a < b)
+		gl_scale_bar_tape_blit(sbar, tape->highlight, a, b,
+				       index + a - start);
+
+	gl_scale_bar_draw_pointer(sbar, mid, pointer_width);
+
+text:
 	svgalib_display_text(sbar->txt_xb, sbar->txt_yb, sbar->pointer_text,
 			     FONT_10x18, sbar->pointer_color, sbar->txt_color);
 }
@@ -118,15 +308,17 @@ static void gl_scale_bar_draw(struct gl_frame *frm)
 static void gl_scale_bar_destroy(struct gl_frame *frm)
 {
 	struct gl_scale_bar *sbar = GL_SCALE_BAR(frm);
-	if (sbar)
+	if (sbar) {
+		gl_scale_bar_tape_free(&sbar->tape);
 		free(sbar);
+	}
 	sbar = NULL;
 }
 
 int gl_scale_bar_create(struct gl_frame **out,
                         int x, int y, int w, int h, int color)
 {
-	struct gl_scale_bar *sbar = malloc(sizeof(struct gl_scale_bar));
+	struct gl_scale_bar *sbar = calloc(1, sizeof(struct gl_scale_bar));
 	if (sbar == NULL) {
 		SYSERR("Out of memory");
 		return -1;
@@ -135,6 +327,7 @@ int gl_scale_bar_create(struct gl_frame **out,
 	gl_frame_init(&sbar->frame, x, y, w, h, color);
 	sbar->frame.draw = gl_scale_bar_draw;
 	sbar->frame.destroy = gl_scale_bar_destroy;
+	gl_frame_memoize(&sbar->frame);
 
 	sbar->pointer = GL_SCALE_POINTER_NONE;
 	sbar->pointer_color = svgalib_get_color(0, 0, 0);
@@ -142,6 +335,8 @@ int gl_scale_bar_create(struct gl_frame **out,
 	strcpy(sbar->pointer_text, "----");
 	sbar->callback = gl_scale_bar_color_callback_default;
 	sbar->callback_data = NULL;
+	sbar->value = 0.0;
+	sbar->reference = 0.0;
 	gl_scale_bar_adjust_text_positions(sbar, &sbar->frame);
 
 	*out = GL_FRAME(sbar);
@@ -151,9 +346,11 @@ int gl_scale_bar_create(struct gl_frame **out,
 void gl_scale_bar_set_text(struct gl_scale_bar *sbar, const char *txt, int size)
 {
 	if (size > 4)
-		strcpy(sbar->pointer_text, "----");
-	else
-		strcpy(sbar->pointer_text, txt);
+		txt = "----";
+	if (strcmp(sbar->pointer_text, txt) == 0)
+		return;
+	strcpy(sbar->pointer_text, txt);
+	gl_frame_changed(&sbar->frame);
 }
 
 void gl_scale_bar_set_pointer(struct gl_scale_bar *sbar,
@@ -161,12 +358,15 @@ void gl_scale_bar_set_pointer(struct gl_scale_bar *sbar,
 {
 	sbar->pointer = pointer;
 	gl_scale_bar_adjust_text_positions(sbar, &sbar->frame);
+	gl_frame_changed(&sbar->frame);
 }
 
 void gl_scale_bar_set_color_callback(struct gl_scale_bar *sbar,
 				     gl_scale_bar_color_callback_t callback,
 				     const void *userdata)
 {
+	if (sbar->callback != callback || sbar->callback_data != userdata)
+		gl_frame_changed(&sbar->frame);
 	sbar->callback = callback;
 	sbar->callback_data = userdata;
 }
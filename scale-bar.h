@@ -2,8 +2,17 @@
 #define GL_SCALE_BAR_H_INCLUDED
 
 #include "frame.h"
+#include "svgalib-private.h"
 
-typedef int (*gl_scale_bar_color_callback_t)(int, int, const void *);
+/**
+ * Tape color of a scale value.
+ *
+ * @value: Scale value, in units of the bar.
+ * @highlight: Non zero when value lies between reference and current value.
+ * @data: User data of the callback.
+ */
+typedef int (*gl_scale_bar_color_callback_t)(int value, int highlight,
+					     const void *data);
 
 /* Scale pointer direction */
 typedef enum gl_scale_pointer_t {
@@ -14,6 +23,18 @@ typedef enum gl_scale_pointer_t {
 	GL_SCALE_POINTER_BOTTOM,
 } gl_scale_pointer_t;
 
+/* Tape pattern pre-rendered around current value */
+struct gl_scale_bar_tape {
+	svgalib_pixel_t *normal;
+	svgalib_pixel_t *highlight;
+	int length, width;
+	int origin;
+	gl_scale_bar_color_callback_t callback;
+	const void *callback_data;
+	int reference;
+	unsigned int valid : 1;
+};
+
 struct gl_scale_bar {
 	struct gl_frame frame;
 	gl_scale_pointer_t pointer;
@@ -23,6 +44,9 @@ struct gl_scale_bar {
 	int pointer_color;
 	gl_scale_bar_color_callback_t callback;
 	const void *callback_data;
+	double value;
+	double reference;
+	struct gl_scale_bar_tape tape;
 };
 
 #define GL_SCALE_BAR(frame)   ((struct gl_scale_bar *)frame)
@@ -39,15 +63,37 @@ extern void gl_scale_bar_set_pointer(struct gl_scale_bar *sbar,
 extern void gl_scale_bar_set_color_callback(struct gl_scale_bar *sbar,
 		gl_scale_bar_color_callback_t callback, const void *userdata);
 
+/* Value under the pointer, tape scrolls with it */
+static inline void gl_scale_bar_set_value(struct gl_scale_bar *sbar,
+					  double value)
+{
+	if (sbar->value != value)
+		gl_frame_changed(&sbar->frame);
+	sbar->value = value;
+}
+
+/* Tape is highlighted between reference and current value */
+static inline void gl_scale_bar_set_reference(struct gl_scale_bar *sbar,
+					      double reference)
+{
+	if (sbar->reference != reference)
+		gl_frame_changed(&sbar->frame);
+	sbar->reference = reference;
+}
+
 static inline void gl_scale_bar_set_text_color(struct gl_scale_bar *sbar,
 					       int color)
 {
+	if (sbar->txt_color != color)
+		gl_frame_changed(&sbar->frame);
 	sbar->txt_color = color;
 }
 
 static inline void gl_scale_bar_set_pointer_color(struct gl_scale_bar *sbar,
 						  int color)
 {
+	if (sbar->pointer_color != color)
+		gl_frame_changed(&sbar->frame);
 	sbar->pointer_color = color;
 }
 
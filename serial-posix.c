@@ -335,6 +335,27 @@ int serial_read(const serial_port_t *port,
 		fd_set fds;
 		struct timeval tvt;
 
+		/*
+		 * Port is non-blocking, so take what is already buffered
+		 * first and wait on select() only once it runs dry.
+		 */
+		ssize_t n = read(port->descriptor,
+				 (char *)buf + nbytes, size - nbytes);
+		if (n > 0) {
+			nbytes += n;
+			continue;
+		} else if (n == 0) {
+			break;	/* EOF */
+		} else if (errno == EINTR) {
+			continue; /* retry reading. */
+		} else if (errno != EAGAIN) {
+			SYSERR("read() error.");
+			goto exit;
+		}
+
+		if (port->timeout == 0)
+			break; /* Polling read, nothing more buffered. */
+
 		FD_ZERO(&fds);	/* Clear file descriptor set */
 		FD_SET(port->descriptor, &fds);	/* Add port descriptor to set */
 
@@ -357,14 +378,11 @@ int serial_read(const serial_port_t *port,
 					timerclear(&tvt);
 			}
 			init = 0;
-
-		} else if (port->timeout == 0) {
-			timerclear(&tvt);
 		}
 
 		/* wait for data on port */
 		int rc = select(port->descriptor + 1, &fds, NULL, NULL,
-				port->timeout >= 0 ? &tvt : NULL);
+				port->timeout > 0 ? &tvt : NULL);
 		if (rc < 0) {
 			if (errno == EINTR)
 				continue; /* Retry. */
@@ -373,18 +391,6 @@ int serial_read(const serial_port_t *port,
 		} else if (rc == 0) {
 			break; /* Timeout. */
 		}
-
-		ssize_t n = read(port->descriptor,
-				 (char *)buf + nbytes, size - nbytes);
-		if (n < 0) {
-			if (errno == EINTR || errno == EAGAIN)
-				continue; /* retry reading. */
-			SYSERR("read() error.");
-			goto exit;
-		} else if (n == 0) {
-			break;	/* EOF */
-		}
-		nbytes += n;
 	}
 	retval = 0;
 	if (nbytes != size)
@@ -405,6 +411,21 @@ int serial_write(const serial_port_t *port, const void *buf,
 	while (nbytes < size) {
 		fd_set fds;
 
+		/* Wait for room only when output queue is full */
+		ssize_t n = write(port->descriptor,
+				(const char *)buf + nbytes, size - nbytes);
+		if (n > 0) {
+			nbytes += n;
+			continue;
+		} else if (n == 0) {
+			break; /* EOF. */
+		} else if (errno == EINTR) {
+			continue; /* Retry. */
+		} else if (errno != EAGAIN) {
+			SYSERR("write() error.");
+			goto exit;
+		}
+
 		FD_ZERO(&fds);
 		FD_SET(port->descriptor, &fds);
 
@@ -417,27 +438,12 @@ int serial_write(const serial_port_t *port, const void *buf,
 		} else if (rc == 0) {
 			break; /* Timeout. */
 		}
-
-		ssize_t n = write(port->descriptor,
-				(const char *)buf + nbytes, size - nbytes);
-		if (n < 0) {
-			if (errno == EINTR || errno == EAGAIN)
-				continue; /* Retry. */
-			SYSERR("write() error.");
-			goto exit;
-		} else if (n == 0) {
-			 break; /* EOF. */
-		}
-		nbytes += n;
 	}
 
-	/* Wait until all data has been transmitted. */
-	while (tcdrain(port->descriptor) != 0) {
-		if (errno != EINTR) {
-			SYSERR("tcdrain() error.");
-			goto exit;
-		}
-	}
+	/*
+	 * Data is left queued in the driver rather than waited out with
+	 * tcdrain(), which would stall the loop for the whole transmission.
+	 */
 	retval = 0;
 
  exit:
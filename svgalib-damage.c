@@ -0,0 +1,144 @@
+#include <stdlib.h>
+
+#define SVGALIB_BACKEND
+#include "svgalib-private.h"
+#include "svgalib-damage.h"
+#include "debug.h"
+
+/* Maximum number of disjoint damaged regions tracked between two flushes */
+#define DAMAGE_RECTS_NR		16
+
+/**
+ * Above this share of the screen (in percent) a single full screen copy
+ * is cheaper than copying the damaged boxes one after the other.
+ */
+#define DAMAGE_FULL_COPY_LIMIT	75
+
+static struct svgalib_rect damage_list[DAMAGE_RECTS_NR];
+static int damage_nr = 0;
+static int damage_full = 0;
+
+static inline int damage_area(const struct svgalib_rect *r)
+{
+	return r->w * r->h;
+}
+
+static void damage_union(const struct svgalib_rect *a,
+			 const struct svgalib_rect *b, struct svgalib_rect *u)
+{
+	int xe = (a->x + a->w > b->x + b->w) ? a->x + a->w : b->x + b->w;
+	int ye = (a->y + a->h > b->y + b->h) ? a->y + a->h : b->y + b->h;
+
+	u->x = (a->x < b->x) ? a->x : b->x;
+	u->y = (a->y < b->y) ? a->y : b->y;
+	u->w = xe - u->x;
+	u->h = ye - u->y;
+}
+
+static inline int damage_touches(const struct svgalib_rect *a,
+				 const struct svgalib_rect *b)
+{
+	return (a->x <= b->x + b->w && b->x <= a->x + a->w &&
+		a->y <= b->y + b->h && b->y <= a->y + a->h);
+}
+
+/**
+ * Merging is accepted when the union does not add more uncovered area
+ * than the smaller of both boxes, so that neighbouring widgets collapse
+ * into one copy while far apart widgets are still copied separately.
+ */
+static int damage_try_merge(const struct svgalib_rect *a,
+			    const struct svgalib_rect *b,
+			    struct svgalib_rect *u)
+{
+	int aa = damage_area(a), ab = damage_area(b);
+
+	damage_union(a, b, u);
+	if (damage_touches(a, b) &&
+	    damage_area(u) - aa - ab <= ((aa < ab) ? aa : ab))
+		return 1;
+	return 0;
+}
+
+void svgalib_damage_screen(void)
+{
+	damage_full = 1;
+	damage_nr = 0;
+}
+
+void svgalib_damage_box(int x, int y, int w, int h)
+{
+	struct svgalib_rect r, u;
+	register int i;
+	int best = 0, growth = -1, total = 0;
+
+	if (damage_full)
+		return;
+
+	/* Clip to physical screen */
+	if (x < 0) {
+		w += x;
+		x = 0;
+	}
+	if (y < 0) {
+		h += y;
+		y = 0;
+	}
+	if (x + w > CTX_WIDTH)
+		w = CTX_WIDTH - x;
+	if (y + h > CTX_HEIGHT)
+		h = CTX_HEIGHT - y;
+	if (w <= 0 || h <= 0)
+		return;
+
+	r.x = x;
+	r.y = y;
+	r.w = w;
+	r.h = h;
+
+	/* Absorb every existing box the new one merges with */
+	for (i = 0; i < damage_nr; ) {
+		if (damage_try_merge(&damage_list[i], &r, &u)) {
+			r = u;
+			damage_list[i] = damage_list[--damage_nr];
+			i = 0;
+		} else {
+			i++;
+		}
+	}
+
+	/* List full, grow the box which gets least bigger */
+	if (damage_nr == DAMAGE_RECTS_NR) {
+		for (i = 0; i < damage_nr; i++) {
+			int g;
+			damage_union(&damage_list[i], &r, &u);
+			g = damage_area(&u) - damage_area(&damage_list[i]);
+			if (growth < 0 || g < growth) {
+				growth = g;
+				best = i;
+			}
+		}
+		damage_union(&damage_list[best], &r, &u);
+		damage_list[best] = u;
+	} else {
+		damage_list[damage_nr++] = r;
+	}
+
+	for (i = 0; i < damage_nr; i++)
+		total += damage_area(&damage_list[i]);
+
+	if (total * 100 >= CTX_WIDTH * CTX_HEIGHT * DAMAGE_FULL_COPY_LIMIT)
+		svgalib_damage_screen();
+}
+
+int svgalib_damage_collect(const struct svgalib_rect **rects)
+{
+	*rects = damage_list;
+	return damage_full ? -1 : damage_nr;
+}
+
+void svgalib_damage_reset(void)
+{
+	damage_nr = 0;
+	damage_full = 0;
+}
@@ -0,0 +1,19 @@
+#ifndef SVGALIB_DAMAGE_H_INCLUDED
+#define SVGALIB_DAMAGE_H_INCLUDED
+
+struct svgalib_rect {
+	int x, y;
+	int w, h;
+};
+
+/**
+ * Damaged boxes collected since last reset, already clipped and merged.
+ *
+ * @rects: Filled with pointer to internal array of damaged boxes.
+ * @return: Number of boxes, or -1 when whole screen has to be copied.
+ */
+extern int svgalib_damage_collect(const struct svgalib_rect **rects);
+
+extern void svgalib_damage_reset(void);
+
+#endif	/* SVGALIB_DAMAGE_H_INCLUDED */
@@ -0,0 +1,501 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SVGALIB_BACKEND
+#include "svgalib-private.h"
+#include "svgalib-damage.h"
+#include "svgalib-glyph.h"
+#include "debug.h"
+
+/* If set in environment, every shown frame is dumped in that directory */
+#define FB_DUMP_DIR_ENV		"GPGS_FB_DUMP_DIR"
+
+static GraphicsContext *physical_context = NULL;
+static GraphicsContext *current_context = NULL;
+static GraphicsContext *saved_context = NULL;
+static const char *dump_directory = NULL;
+static unsigned int frame_nr = 0;
+
+static GraphicsContext *fb_context_create(int width, int height)
+{
+	GraphicsContext *gc = malloc(sizeof(GraphicsContext));
+	if (gc == NULL) {
+		SYSERR("Failed to allocate frame buffer context.");
+		return NULL;
+	}
+
+	gc->vbuf = calloc(width * height, sizeof(svgalib_pixel_t));
+	if (gc->vbuf == NULL) {
+		SYSERR("Failed to allocate frame buffer.");
+		free(gc);
+		return NULL;
+	}
+	gc->width = width;
+	gc->height = height;
+	return gc;
+}
+
+static inline void fb_setpixel(GraphicsContext *gc, int x, int y, int color)
+{
+	if (x >= 0 && y >= 0 && x < gc->width && y < gc->height)
+		gc->vbuf[y * gc->width + x] = color;
+}
+
+static void fb_hline(GraphicsContext *gc, int xb, int y, int xe, int color)
+{
+	svgalib_pixel_t *p;
+
+	if (xb > xe) {
+		int t = xb;
+		xb = xe;
+		xe = t;
+	}
+	if (y < 0 || y >= gc->height || xe < 0 || xb >= gc->width)
+		return;
+	if (xb < 0)
+		xb = 0;
+	if (xe >= gc->width)
+		xe = gc->width - 1;
+
+	for (p = &gc->vbuf[y * gc->width + xb]; xb <= xe; xb++)
+		*p++ = color;
+}
+
+static void fb_fillbox(GraphicsContext *gc, int x, int y,
+		       int w, int h, int color)
+{
+	register int i;
+
+	for (i = 0; i < h; i++)
+		fb_hline(gc, x, y + i, x + w - 1, color);
+}
+
+static void fb_line(GraphicsContext *gc, int xb, int yb,
+		    int xe, int ye, int color)
+{
+	int dx = abs(xe - xb), sx = (xb < xe) ? 1 : -1;
+	int dy = -abs(ye - yb), sy = (yb < ye) ? 1 : -1;
+	int err = dx + dy;
+
+	if (yb == ye) {
+		fb_hline(gc, xb, yb, xe, color);
+		return;
+	}
+
+	for (;;) {
+		int e2 = err << 1;
+
+		fb_setpixel(gc, xb, yb, color);
+		if (xb == xe && yb == ye)
+			break;
+		if (e2 >= dy) {
+			err += dy;
+			xb += sx;
+		}
+		if (e2 <= dx) {
+			err += dx;
+			yb += sy;
+		}
+	}
+}
+
+static void fb_circle_points(GraphicsContext *gc, int xc, int yc,
+			     int x, int y, int color, int filled)
+{
+	if (filled) {
+		fb_hline(gc, xc - x, yc + y, xc + x, color);
+		fb_hline(gc, xc - x, yc - y, xc + x, color);
+		fb_hline(gc, xc - y, yc + x, xc + y, color);
+		fb_hline(gc, xc - y, yc - x, xc + y, color);
+	} else {
+		fb_setpixel(gc, xc + x, yc + y, color);
+		fb_setpixel(gc, xc - x, yc + y, color);
+		fb_setpixel(gc, xc + x, yc - y, color);
+		fb_setpixel(gc, xc - x, yc - y, color);
+		fb_setpixel(gc, xc + y, yc + x, color);
+		fb_setpixel(gc, xc - y, yc + x, color);
+		fb_setpixel(gc, xc + y, yc - x, color);
+		fb_setpixel(gc, xc - y, yc - x, color);
+	}
+}
+
+/* Midpoint circle, same pixels as gl_circle() */
+static void fb_circle(GraphicsContext *gc, int xc, int yc,
+		      int r, int color, int filled)
+{
+	int x = 0, y = r, d = 1 - r;
+
+	if (r < 1) {
+		fb_setpixel(gc, xc, yc, color);
+		return;
+	}
+
+	fb_circle_points(gc, xc, yc, x, y, color, filled);
+	while (x < y) {
+		if (d < 0) {
+			d += (x << 1) + 3;
+		} else {
+			d += ((x - y) << 1) + 5;
+			y--;
+		}
+		x++;
+		fb_circle_points(gc, xc, yc, x, y, color, filled);
+	}
+}
+
+static void fb_putbox(GraphicsContext *gc, int x, int y, int w, int h,
+		      const svgalib_pixel_t *buf, int pitch)
+{
+	register int i, j;
+
+	for (i = 0; i < h; i++, buf += pitch) {
+		if (y + i < 0 || y + i >= gc->height)
+			continue;
+		if (x >= 0 && x + w <= gc->width) {
+			memcpy(&gc->vbuf[(y + i) * gc->width + x], buf,
+			       w * sizeof(svgalib_pixel_t));
+			continue;
+		}
+		for (j = 0; j < w; j++)
+			fb_setpixel(gc, x + j, y + i, buf[j]);
+	}
+}
+
+static void fb_glyph_spans(GraphicsContext *gc, const struct glyph_font *gf,
+			   int x, int y, unsigned char c, int color)
+{
+	const struct glyph_span *span = NULL;
+	register int i;
+	int nr;
+
+	span = svgalib_glyph_spans(gf, c, &nr);
+	for (i = 0; i < nr; i++, span++)
+		fb_hline(gc, x + span->xb, y + span->row, x + span->xe, color);
+}
+
+static void fb_copybox(const GraphicsContext *from, int x, int y, int w, int h,
+		       GraphicsContext *to, int xt, int yt)
+{
+	register int i;
+
+	/* Clip against source, then target context */
+	if (x < 0) {
+		w += x;
+		xt -= x;
+		x = 0;
+	}
+	if (y < 0) {
+		h += y;
+		yt -= y;
+		y = 0;
+	}
+	if (xt < 0) {
+		w += xt;
+		x -= xt;
+		xt = 0;
+	}
+	if (yt < 0) {
+		h += yt;
+		y -= yt;
+		yt = 0;
+	}
+	if (x + w > from->width)
+		w = from->width - x;
+	if (y + h > from->height)
+		h = from->height - y;
+	if (xt + w > to->width)
+		w = to->width - xt;
+	if (yt + h > to->height)
+		h = to->height - yt;
+	if (w <= 0 || h <= 0)
+		return;
+
+	/* Rows are copied bottom up when moving down within a context */
+	if (from == to && yt > y) {
+		for (i = h - 1; i >= 0; i--)
+			memmove(&to->vbuf[(yt + i) * to->width + xt],
+				&from->vbuf[(y + i) * from->width + x],
+				w * sizeof(svgalib_pixel_t));
+		return;
+	}
+	for (i = 0; i < h; i++)
+		memmove(&to->vbuf[(yt + i) * to->width + xt],
+			&from->vbuf[(y + i) * from->width + x],
+			w * sizeof(svgalib_pixel_t));
+}
+
+int svgalib_init(int mode)
+{
+	physical_context = fb_context_create(CTX_WIDTH, CTX_HEIGHT);
+	if (physical_context == NULL) {
+		DEBUG("Failed to allocate physical context.");
+		return -1;
+	}
+	current_context = physical_context;
+
+	if (svgalib_glyph_init() != 0) {
+		DEBUG("Failed to build glyph cache.");
+		svgalib_virtual_context_destroy(physical_context);
+		physical_context = NULL;
+		return -1;
+	}
+	dump_directory = getenv(FB_DUMP_DIR_ENV);
+	frame_nr = 0;
+
+	INFO("Frame buffer %dx%d initialized for mode %d",
+	     CTX_WIDTH, CTX_HEIGHT, mode);
+	return 0;
+}
+
+void svgalib_exit(void)
+{
+	svgalib_glyph_exit();
+	if (physical_context)
+		svgalib_virtual_context_destroy(physical_context);
+	physical_context = NULL;
+	current_context = NULL;
+}
+
+GraphicsContext *svgalib_virtual_context_create(void)
+{
+	return fb_context_create(CTX_WIDTH, CTX_HEIGHT);
+}
+
+void svgalib_virtual_context_destroy(GraphicsContext *gc)
+{
+	if (gc) {
+		free(gc->vbuf);
+		free(gc);
+	}
+}
+
+void svgalib_set_context(GraphicsContext *gc)
+{
+	current_context = gc;
+}
+
+GraphicsContext *svgalib_layer_create(int w, int h)
+{
+	return fb_context_create(w, h);
+}
+
+void svgalib_layer_begin(GraphicsContext *gc)
+{
+	saved_context = current_context;
+	current_context = gc;
+}
+
+void svgalib_layer_end(void)
+{
+	current_context = saved_context;
+	saved_context = NULL;
+}
+
+void svgalib_copy_layer(GraphicsContext *gc, int x, int y, int w, int h,
+			int xd, int yd)
+{
+	fb_copybox(gc, x, y, w, h, current_context, xd, yd);
+}
+
+void svgalib_clear_context(GraphicsContext *gc, int color)
+{
+	current_context = gc;
+	fb_fillbox(gc, 0, 0, gc->width, gc->height, color);
+	svgalib_damage_screen();
+}
+
+void svgalib_show_context(GraphicsContext *gc)
+{
+	const struct svgalib_rect *rects = NULL;
+	register int i;
+	int nr = svgalib_damage_collect(&rects);
+
+	current_context = gc;
+	if (nr < 0) {
+		fb_copybox(gc, 0, 0, gc->width, gc->height,
+			   physical_context, 0, 0);
+	} else {
+		for (i = 0; i < nr; i++)
+			fb_copybox(gc, rects[i].x, rects[i].y,
+				   rects[i].w, rects[i].h, physical_context,
+				   rects[i].x, rects[i].y);
+	}
+	svgalib_damage_reset();
+
+	if (dump_directory != NULL) {
+		char filename[256] = "";
+		snprintf(filename, 256, "%s/frame_%06u.ppm",
+			 dump_directory, frame_nr);
+		svgalib_fb_dump(filename);
+	}
+	frame_nr++;
+}
+
+void svgalib_clear_screen(int color)
+{
+	current_context = physical_context;
+	fb_fillbox(physical_context, 0, 0, physical_context->width,
+		   physical_context->height, color);
+}
+
+void svgalib_copy_box_to_screen(int x, int y, int w, int h)
+{
+	fb_copybox(current_context, x, y, w, h, physical_context, x, y);
+}
+
+void svgalib_draw_frame(int x, int y, int w, int h, int color)
+{
+	GraphicsContext *gc = current_context;
+	int e = x + w;
+	int s = y + h;
+
+	fb_fillbox(gc, x, y, w, h, color);
+
+	color = svgalib_get_color(20, 20, 20);
+	fb_hline(gc, x, y, e, color);
+	fb_hline(gc, x + 1, y + 1, e - 1, color);
+	fb_line(gc, x, y, x, s, color);
+	fb_line(gc, x + 1, y + 1, x + 1, s - 1, color);
+
+	color = svgalib_get_color(10, 10, 10);
+	fb_hline(gc, x, s, e, color);
+	fb_hline(gc, x + 1, s - 1, e - 1, color);
+	fb_line(gc, e, y, e, s, color);
+	fb_line(gc, e - 1, y + 1, e - 1, s - 1, color);
+}
+
+void svgalib_display_text(int xb, int yb, const char txt[],
+			  font_t type, int bgcolor, int txtcolor)
+{
+	GraphicsContext *gc = current_context;
+	struct glyph_font *gf = svgalib_glyph_font(type);
+	int fw, fh;
+
+	if (gf == NULL || txt == NULL)
+		return;
+
+	fw = svgalib_glyph_width(gf);
+	fh = svgalib_glyph_height(gf);
+	for (; *txt != '\0'; txt++, xb += fw) {
+		const svgalib_pixel_t *bm = NULL;
+
+		bm = svgalib_glyph_bitmap(gf, *txt, bgcolor, txtcolor);
+		if (bm != NULL) {
+			fb_putbox(gc, xb, yb, fw, fh, bm, fw);
+		} else {
+			fb_fillbox(gc, xb, yb, fw, fh, bgcolor);
+			fb_glyph_spans(gc, gf, xb, yb, *txt, txtcolor);
+		}
+	}
+}
+
+/* Text centered at given position, background left untouched */
+void svgalib_display_text_wrapped(int xb, int yb, const char txt[],
+				  font_t type, int bgcolor, int txtcolor)
+{
+	const struct glyph_font *gf = svgalib_glyph_font(type);
+	int fw;
+
+	(void)bgcolor;	/* background is left untouched */
+	if (gf == NULL || txt == NULL)
+		return;
+
+	fw = svgalib_glyph_width(gf);
+	xb -= svgalib_text_width(txt, type) >> 1;
+	yb -= svgalib_glyph_height(gf) >> 1;
+	for (; *txt != '\0'; txt++, xb += fw)
+		fb_glyph_spans(current_context, gf, xb, yb, *txt, txtcolor);
+}
+
+void svgalib_draw_grid(int x, int y, int w, int h, int step, int color)
+{
+	register int i;
+
+	if (!step) {
+		DEBUG("Invalid grid step size");
+		return;
+	}
+
+	svgalib_draw_frame(x, y, w, h, svgalib_get_color(0, 0, 0));
+
+	for (i = x; i <= (x + w); i += step)
+		fb_line(current_context, i, y, i, y + h, color);
+
+	for (i = y; i <= (y + h); i += step)
+		fb_hline(current_context, x, i, x + w, color);
+}
+
+void svgalib_draw_box_colored(int x, int y, int w, int h, int color)
+{
+	fb_fillbox(current_context, x, y, w, h, color);
+}
+
+void svgalib_draw_line(int xb, int yb, int xe, int ye, int color)
+{
+	fb_line(current_context, xb, yb, xe, ye, color);
+}
+
+void svgalib_draw_hline(int xb, int yb, int xe, int color)
+{
+	fb_hline(current_context, xb, yb, xe, color);
+}
+
+void svgalib_draw_circle(int xc, int yc, int r, int color)
+{
+	fb_circle(current_context, xc, yc, r, color, 0);
+}
+
+void svgalib_draw_circle_filled(int xc, int yc, int r, int color)
+{
+	fb_circle(current_context, xc, yc, r, color, 1);
+}
+
+void svgalib_set_pixel(int x, int y, int color)
+{
+	fb_setpixel(current_context, x, y, color);
+}
+
+void svgalib_put_box(int x, int y, int w, int h,
+		     const svgalib_pixel_t *buf, int pitch)
+{
+	fb_putbox(current_context, x, y, w, h, buf, pitch);
+}
+
+void svgalib_copy_box(int x, int y, int w, int h, int xd, int yd)
+{
+	fb_copybox(current_context, x, y, w, h, current_context, xd, yd);
+}
+
+int svgalib_fb_dump(const char *filename)
+{
+	const GraphicsContext *gc = physical_context;
+	FILE *fp = NULL;
+	register int i;
+
+	if (gc == NULL)
+		return -1;
+
+	fp = fopen(filename, "wb");
+	if (fp == NULL) {
+		SYSERR("Failed to open file: %s", filename);
+		return -1;
+	}
+
+	fprintf(fp, "P6\n%d %d\n255\n", gc->width, gc->height);
+	for (i = 0; i < gc->width * gc->height; i++) {
+		svgalib_pixel_t p = gc->vbuf[i];
+		unsigned char rgb[3];
+
+		rgb[0] = ((p >> 11) & 0x1F) * 255 / 31;
+		rgb[1] = ((p >> 5) & 0x3F) * 255 / 63;
+		rgb[2] = (p & 0x1F) * 255 / 31;
+		fwrite(rgb, 1, 3, fp);
+	}
+
+	if (fclose(fp) != 0) {
+		SYSERR("Failed to write file: %s", filename);
+		return -1;
+	}
+	return 0;
+}
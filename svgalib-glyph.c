@@ -0,0 +1,265 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "svgalib-private.h"
+#include "svgalib-glyph.h"
+#include "debug.h"
+
+#define GLYPHS_NR		256
+
+/* Expanded bitmaps are only kept for printable ASCII characters */
+#define GLYPH_CACHED_FIRST	32
+#define GLYPH_CACHED_LAST	126
+#define GLYPH_CACHED_NR		(GLYPH_CACHED_LAST - GLYPH_CACHED_FIRST + 1)
+
+/* Color pairs cached per font, least recently used one is replaced */
+#define GLYPH_COLORS_NR		4
+
+#define FONTS_NR		(FONT_ACORN16x16 + 1)
+
+struct glyph_colors {
+	int bgcolor, txtcolor;
+	unsigned int stamp;
+	svgalib_pixel_t *bitmap;
+	unsigned char expanded[GLYPH_CACHED_NR];
+};
+
+struct glyph_font {
+	int width, height;
+	struct glyph_span *spans;
+	unsigned int span_index[GLYPHS_NR + 1];
+	struct glyph_colors colors[GLYPH_COLORS_NR];
+	unsigned int stamp;
+};
+
+static struct glyph_font *glyph_fonts[FONTS_NR];
+
+static inline int glyph_bit(const unsigned char *glyph, int bpr,
+			    int row, int col)
+{
+	return glyph[row * bpr + (col >> 3)] & (0x80 >> (col & 7));
+}
+
+/**
+ * Count (when @spans is NULL) or fill spans of one compressed glyph.
+ * Glyph rows are one bit per pixel padded to a byte boundary.
+ */
+static int glyph_scan(const unsigned char *glyph, int fw, int fh,
+		      struct glyph_span *spans)
+{
+	int bpr = (fw + 7) >> 3;
+	int row, col, nr = 0;
+
+	for (row = 0; row < fh; row++) {
+		for (col = 0; col < fw; col++) {
+			int xb;
+
+			if (!glyph_bit(glyph, bpr, row, col))
+				continue;
+			for (xb = col; col + 1 < fw &&
+			     glyph_bit(glyph, bpr, row, col + 1); col++)
+				;
+			if (spans) {
+				spans[nr].row = row;
+				spans[nr].xb = xb;
+				spans[nr].xe = col;
+			}
+			nr++;
+		}
+	}
+	return nr;
+}
+
+static struct glyph_font *glyph_font_create(const struct font *f)
+{
+	struct glyph_font *gf = NULL;
+	const unsigned char *data = font_data(f);
+	int fw = font_width(f), fh = font_height(f);
+	int glyph_size = fh * ((fw + 7) >> 3);
+	register int c;
+	unsigned int nr = 0;
+
+	gf = calloc(1, sizeof(struct glyph_font));
+	if (gf == NULL) {
+		SYSERR("Failed to allocate glyph font.");
+		return NULL;
+	}
+	gf->width = fw;
+	gf->height = fh;
+
+	for (c = 0; c < GLYPHS_NR; c++) {
+		gf->span_index[c] = nr;
+		nr += glyph_scan(data + c * glyph_size, fw, fh, NULL);
+	}
+	gf->span_index[GLYPHS_NR] = nr;
+
+	gf->spans = malloc((nr ? nr : 1) * sizeof(struct glyph_span));
+	if (gf->spans == NULL) {
+		SYSERR("Failed to allocate glyph spans.");
+		free(gf);
+		return NULL;
+	}
+
+	for (c = 0; c < GLYPHS_NR; c++)
+		glyph_scan(data + c * glyph_size, fw, fh,
+			   gf->spans + gf->span_index[c]);
+	return gf;
+}
+
+static void glyph_font_destroy(struct glyph_font *gf)
+{
+	register int i;
+
+	if (gf == NULL)
+		return;
+
+	for (i = 0; i < GLYPH_COLORS_NR; i++)
+		free(gf->colors[i].bitmap);
+	free(gf->spans);
+	free(gf);
+}
+
+int svgalib_glyph_init(void)
+{
+	register int i;
+	int nr = 0;
+
+	for (i = FONT_NONE + 1; i < FONTS_NR; i++) {
+		const struct font *f = get_font(i);
+		if (f == NULL)
+			continue;
+
+		glyph_fonts[i] = glyph_font_create(f);
+		if (glyph_fonts[i] == NULL) {
+			DEBUG("Failed to create glyphs of font %d", i);
+			continue;
+		}
+		nr++;
+	}
+	glyph_fonts[FONT_NONE] = glyph_fonts[FONT_VGA8x8];
+
+	INFO("Glyphs of %d fonts cached", nr);
+	return nr ? 0 : -1;
+}
+
+void svgalib_glyph_exit(void)
+{
+	register int i;
+
+	for (i = FONT_NONE + 1; i < FONTS_NR; i++) {
+		glyph_font_destroy(glyph_fonts[i]);
+		glyph_fonts[i] = NULL;
+	}
+	glyph_fonts[FONT_NONE] = NULL;
+}
+
+struct glyph_font *svgalib_glyph_font(font_t type)
+{
+	if (type < FONT_NONE || type >= FONTS_NR)
+		type = FONT_NONE;
+	return glyph_fonts[type];
+}
+
+int svgalib_text_width(const char txt[], font_t type)
+{
+	const struct glyph_font *gf = svgalib_glyph_font(type);
+
+	if (gf == NULL || txt == NULL)
+		return 0;
+	return strlen(txt) * gf->width;
+}
+
+int svgalib_text_height(font_t type)
+{
+	const struct glyph_font *gf = svgalib_glyph_font(type);
+	return gf ? gf->height : 0;
+}
+
+int svgalib_glyph_width(const struct glyph_font *gf)
+{
+	return gf->width;
+}
+
+int svgalib_glyph_height(const struct glyph_font *gf)
+{
+	return gf->height;
+}
+
+const struct glyph_span *svgalib_glyph_spans(const struct glyph_font *gf,
+					     unsigned char c, int *nr)
+{
+	*nr = gf->span_index[c + 1] - gf->span_index[c];
+	return gf->spans + gf->span_index[c];
+}
+
+static struct glyph_colors *glyph_colors_lookup(struct glyph_font *gf,
+						int bgcolor, int txtcolor)
+{
+	struct glyph_colors *gcl = &gf->colors[0];
+	register int i;
+
+	gf->stamp++;
+	for (i = 0; i < GLYPH_COLORS_NR; i++) {
+		struct glyph_colors *p = &gf->colors[i];
+
+		if (p->bitmap && p->bgcolor == bgcolor &&
+		    p->txtcolor == txtcolor) {
+			p->stamp = gf->stamp;
+			return p;
+		}
+		if (p->stamp < gcl->stamp)
+			gcl = p;
+	}
+
+	/* Replace least recently used color pair */
+	if (gcl->bitmap == NULL) {
+		gcl->bitmap = malloc(GLYPH_CACHED_NR * gf->width *
+				     gf->height * sizeof(svgalib_pixel_t));
+		if (gcl->bitmap == NULL) {
+			SYSERR("Failed to allocate glyph bitmap.");
+			return NULL;
+		}
+	}
+	memset(gcl->expanded, 0, GLYPH_CACHED_NR);
+	gcl->bgcolor = bgcolor;
+	gcl->txtcolor = txtcolor;
+	gcl->stamp = gf->stamp;
+	return gcl;
+}
+
+const svgalib_pixel_t *svgalib_glyph_bitmap(struct glyph_font *gf,
+					    unsigned char c,
+					    int bgcolor, int txtcolor)
+{
+	struct glyph_colors *gcl = NULL;
+	svgalib_pixel_t *bm = NULL;
+	const struct glyph_span *span = NULL;
+	int size = gf->width * gf->height;
+	int i, nr;
+
+	if (c < GLYPH_CACHED_FIRST || c > GLYPH_CACHED_LAST)
+		return NULL;
+
+	gcl = glyph_colors_lookup(gf, bgcolor, txtcolor);
+	if (gcl == NULL)
+		return NULL;
+
+	c -= GLYPH_CACHED_FIRST;
+	bm = gcl->bitmap + c * size;
+	if (gcl->expanded[c])
+		return bm;
+
+	/* Expand glyph once for this color pair */
+	for (i = 0; i < size; i++)
+		bm[i] = bgcolor;
+	span = svgalib_glyph_spans(gf, c + GLYPH_CACHED_FIRST, &nr);
+	for (i = 0; i < nr; i++, span++) {
+		svgalib_pixel_t *p = bm + span->row * gf->width;
+		register int x;
+
+		for (x = span->xb; x <= span->xe; x++)
+			p[x] = txtcolor;
+	}
+	gcl->expanded[c] = 1;
+	return bm;
+}
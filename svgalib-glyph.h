@@ -0,0 +1,43 @@
+#ifndef SVGALIB_GLYPH_H_INCLUDED
+#define SVGALIB_GLYPH_H_INCLUDED
+
+#include "font/font.h"
+
+/* Horizontal run of set pixels in a glyph row, both ends inclusive */
+struct glyph_span {
+	unsigned char row;
+	unsigned char xb, xe;
+};
+
+struct glyph_font;
+
+extern int svgalib_glyph_init(void);
+
+extern void svgalib_glyph_exit(void);
+
+/* Cached font of given type, falls back to 8x8 font for FONT_NONE */
+extern struct glyph_font *svgalib_glyph_font(font_t type);
+
+extern int svgalib_glyph_width(const struct glyph_font *gf);
+
+extern int svgalib_glyph_height(const struct glyph_font *gf);
+
+/**
+ * Spans of set pixels of a glyph.
+ *
+ * @nr: Filled with number of spans.
+ * @return: Pointer to first span.
+ */
+extern const struct glyph_span *svgalib_glyph_spans(const struct glyph_font *gf,
+						    unsigned char c, int *nr);
+
+/**
+ * Glyph expanded into width x height pixels in given colors.
+ *
+ * @return: Pixel buffer, or NULL when glyph is outside cached range.
+ */
+extern const svgalib_pixel_t *svgalib_glyph_bitmap(struct glyph_font *gf,
+						   unsigned char c,
+						   int bgcolor, int txtcolor);
+
+#endif	/* SVGALIB_GLYPH_H_INCLUDED */
@@ -11,6 +11,10 @@ extern void svgalib_exit(void);
 
 extern void svgalib_show_context(GraphicsContext *gc);
 
+extern void svgalib_damage_box(int x, int y, int w, int h);
+
+extern void svgalib_damage_screen(void);
+
 extern void svgalib_clear_screen(int color);
 
 extern void svgalib_copy_box_to_screen(int x, int y, int w, int h);
@@ -23,8 +27,33 @@ extern void svgalib_display_text(int xb, int yb, const char txt[],
 extern void svgalib_display_text_wrapped(int xb, int yb, const char txt[],
 				 font_t type, int bgcolor, int txtcolor);
 
+extern int svgalib_text_width(const char txt[], font_t type);
+
+extern int svgalib_text_height(font_t type);
+
 extern void svgalib_draw_thick_line(int xb, int yb, int xe, int ye, int color);
 
+/**
+ * Draw @nr segments given as x0, y0, x1, y1 in @seg, clipped to @clip
+ * (NULL for none) and 1 to 3 pixels wide. Coordinates are fixed point,
+ * see SVGALIB_SUBPIXEL_SHIFT.
+ */
+extern void svgalib_draw_segments(const int seg[], int nr,
+				  const struct svgalib_clip *clip,
+				  int width, int color);
+
+/* Connected segments through @nr points given as x, y pairs in @pts */
+extern void svgalib_draw_polyline(const int pts[], int nr,
+				  const struct svgalib_clip *clip,
+				  int width, int color);
+
+/**
+ * Clip fixed point segment as the line primitives do, @out gets its end
+ * points in whole pixels. Returns -1 when nothing is left.
+ */
+extern int svgalib_clip_segment(const struct svgalib_clip *clip,
+				const int seg[4], int out[4]);
+
 extern void svgalib_draw_grid(int x, int y, int w, int h, int step, int color);
 
 extern GraphicsContext *svgalib_virtual_context_create(void);
@@ -39,10 +68,29 @@ static inline void svgalib_set_context(GraphicsContext *gc)
 	gl_setcontext(gc);
 }
 
+/**
+ * Offscreen layer of given size, drawn into between svgalib_layer_begin()
+ * and svgalib_layer_end(). Destroyed with svgalib_virtual_context_destroy().
+ */
+extern GraphicsContext *svgalib_layer_create(int w, int h);
+
+/* Make layer current context, previous one is restored by layer_end */
+extern void svgalib_layer_begin(GraphicsContext *gc);
+
+extern void svgalib_layer_end(void);
+
+/* Copy box of layer at (x, y) to (xd, yd) of current context */
+static inline void svgalib_copy_layer(GraphicsContext *gc, int x, int y,
+				      int w, int h, int xd, int yd)
+{
+	gl_copyboxfromcontext(gc, x, y, w, h, xd, yd);
+}
+
 static inline void svgalib_clear_context(GraphicsContext *gc, int color)
 {
 	gl_setcontext(gc);
 	gl_clearscreen(color);
+	svgalib_damage_screen();
 }
 
 static inline void svgalib_draw_box_colored(int x, int y,
@@ -76,9 +124,32 @@ static inline void svgalib_draw_circle_filled(int xc, int yc, int r, int color)
 	gl_fillcircle(xc, yc, r, color);
 }
 
+/**
+ * Fill polygon of @nr vertices given as x, y pairs in @pgn, convex or
+ * concave, using even-odd rule.
+ */
+extern void svgalib_fill_polygon(const int pgn[], int nr, int color);
+
 static inline void svgalib_set_pixel(int x, int y, int color)
 {
 	gl_setpixel(x, y, color);
 }
 
+/* Copy box of current context to (xd, yd), boxes may overlap */
+static inline void svgalib_copy_box(int x, int y, int w, int h,
+				    int xd, int yd)
+{
+	gl_copybox(x, y, w, h, xd, yd);
+}
+
+/* Blit box of pixels, @pitch is number of pixels per row of @buf */
+static inline void svgalib_put_box(int x, int y, int w, int h,
+				   const svgalib_pixel_t *buf, int pitch)
+{
+	if (pitch == w)
+		gl_putbox(x, y, w, h, (void *)buf);
+	else
+		gl_putboxpart(x, y, w, h, pitch, h, (void *)buf, 0, 0);
+}
+
 #endif	/* SVGALIB_GRAPHICS_MODE_H_INCLUDED */
@@ -0,0 +1,190 @@
+#include <stdlib.h>
+
+#define SVGALIB_BACKEND
+#include "svgalib-private.h"
+#include "debug.h"
+
+#define FIX_SHIFT		SVGALIB_SUBPIXEL_SHIFT
+#define FIX_HALF		(1 << (FIX_SHIFT - 1))
+
+/* Cohen-Sutherland outcodes */
+#define OUT_LEFT		0x1
+#define OUT_RIGHT		0x2
+#define OUT_TOP			0x4
+#define OUT_BOTTOM		0x8
+
+static inline int line_pixel(long long v)
+{
+	return (int)((v + FIX_HALF) >> FIX_SHIFT);
+}
+
+static inline int line_outcode(const long long box[4], long long x,
+			       long long y)
+{
+	int code = 0;
+
+	if (x < box[0])
+		code |= OUT_LEFT;
+	else if (x > box[2])
+		code |= OUT_RIGHT;
+	if (y < box[1])
+		code |= OUT_TOP;
+	else if (y > box[3])
+		code |= OUT_BOTTOM;
+	return code;
+}
+
+int svgalib_clip_segment(const struct svgalib_clip *clip,
+			 const int seg[4], int out[4])
+{
+	long long x0 = seg[0], y0 = seg[1], x1 = seg[2], y1 = seg[3];
+	long long box[4];
+	int code0, code1;
+
+	if (clip == NULL)
+		goto exit;
+
+	box[0] = (long long)clip->xmin << FIX_SHIFT;
+	box[1] = (long long)clip->ymin << FIX_SHIFT;
+	box[2] = (long long)clip->xmax << FIX_SHIFT;
+	box[3] = (long long)clip->ymax << FIX_SHIFT;
+	code0 = line_outcode(box, x0, y0);
+	code1 = line_outcode(box, x1, y1);
+
+	while (code0 | code1) {
+		int code = code0 ? code0 : code1;
+		long long x, y;
+
+		/* Both ends beyond the same edge */
+		if (code0 & code1)
+			return -1;
+
+		if (code & OUT_TOP) {
+			y = box[1];
+			x = x0 + (x1 - x0) * (y - y0) / (y1 - y0);
+		} else if (code & OUT_BOTTOM) {
+			y = box[3];
+			x = x0 + (x1 - x0) * (y - y0) / (y1 - y0);
+		} else if (code & OUT_LEFT) {
+			x = box[0];
+			y = y0 + (y1 - y0) * (x - x0) / (x1 - x0);
+		} else {
+			x = box[2];
+			y = y0 + (y1 - y0) * (x - x0) / (x1 - x0);
+		}
+
+		if (code == code0) {
+			x0 = x;
+			y0 = y;
+			code0 = line_outcode(box, x0, y0);
+		} else {
+			x1 = x;
+			y1 = y;
+			code1 = line_outcode(box, x1, y1);
+		}
+	}
+ exit:
+	out[0] = line_pixel(x0);
+	out[1] = line_pixel(y0);
+	out[2] = line_pixel(x1);
+	out[3] = line_pixel(y1);
+	return 0;
+}
+
+/* Text mode only needs the clip helper, for the recorder */
+#if defined(CONFIG_SVGALIB_GRAPHICS_MODE) || \
+    defined(CONFIG_SVGALIB_FRAMEBUFFER_MODE)
+
+/**
+ * Bresenham walk, consecutive pixels of a row joined into one span.
+ * Width grows across the minor axis: columns of steep lines, rows of
+ * flat ones, so all of it is written in the same pass.
+ */
+static void line_raster(int xb, int yb, int xe, int ye, int width, int color)
+{
+	int dx = abs(xe - xb), sx = (xb < xe) ? 1 : -1;
+	int dy = -abs(ye - yb), sy = (yb < ye) ? 1 : -1;
+	int err = dx + dy;
+	int lo = -((width - 1) >> 1), hi = width >> 1;
+	int steep = (dx <= -dy);
+	int run = xb;
+	register int k;
+
+	if (yb == ye && !steep) {
+		for (k = lo; k <= hi; k++)
+			svgalib_draw_hline(xb, yb + k, xe, color);
+		return;
+	}
+
+	for (;;) {
+		int x = xb, y = yb, e2 = err << 1;
+		int last = (xb == xe && yb == ye);
+
+		if (!last) {
+			if (e2 >= dy) {
+				err += dy;
+				xb += sx;
+			}
+			if (e2 <= dx) {
+				err += dx;
+				yb += sy;
+			}
+		}
+		if (!last && yb == y)
+			continue;
+
+		/* Row of the line finished, from run to x */
+		if (steep) {
+			svgalib_draw_hline((run < x ? run : x) + lo, y,
+					   (run < x ? x : run) + hi, color);
+		} else {
+			for (k = lo; k <= hi; k++)
+				svgalib_draw_hline(run < x ? run : x, y + k,
+						   run < x ? x : run, color);
+		}
+		if (last)
+			break;
+		run = xb;
+	}
+}
+
+void svgalib_draw_segments(const int seg[], int nr,
+			   const struct svgalib_clip *clip,
+			   int width, int color)
+{
+	register int i;
+	int l[4];
+
+	if (width < 1 || width > 3) {
+		DEBUG("Lines of width %d not drawn", width);
+		return;
+	}
+
+	for (i = 0; i < nr; i++, seg += 4) {
+		if (svgalib_clip_segment(clip, seg, l) == 0)
+			line_raster(l[0], l[1], l[2], l[3], width, color);
+	}
+}
+
+void svgalib_draw_polyline(const int pts[], int nr,
+			   const struct svgalib_clip *clip,
+			   int width, int color)
+{
+	register int i;
+
+	/* Segments share end points with their neighbours */
+	for (i = 0; i + 1 < nr; i++)
+		svgalib_draw_segments(pts + 2 * i, 1, clip, width, color);
+}
+
+void svgalib_draw_thick_line(int xb, int yb, int xe, int ye, int color)
+{
+	int seg[4] = {
+		xb << FIX_SHIFT, yb << FIX_SHIFT,
+		xe << FIX_SHIFT, ye << FIX_SHIFT,
+	};
+
+	svgalib_draw_segments(seg, 1, NULL, 3, color);
+}
+
+#endif
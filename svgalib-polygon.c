@@ -0,0 +1,104 @@
+#include <stdlib.h>
+
+#define SVGALIB_BACKEND
+#include "svgalib-private.h"
+#include "debug.h"
+
+/* Largest polygon accepted by svgalib_fill_polygon() */
+#define POLYGON_VERTICES_MAX	32
+
+#define FIX_SHIFT		16
+#define FIX_ONE			(1 << FIX_SHIFT)
+#define FIX_HALF		(FIX_ONE >> 1)
+
+/* Non horizontal polygon edge, covering scanlines [yb, ye) */
+struct polygon_edge {
+	int yb, ye;
+	int x;		/* 16.16 fixed point x at current scanline */
+	int dxdy;	/* 16.16 fixed point x step per scanline */
+};
+
+static int polygon_edges(const int pgn[], int nr, struct polygon_edge *edges)
+{
+	register int i, j;
+	int count = 0;
+
+	for (i = 0; i < nr; i++) {
+		int x0 = pgn[2 * i], y0 = pgn[2 * i + 1];
+		int x1 = pgn[2 * ((i + 1) % nr)], y1 = pgn[2 * ((i + 1) % nr) + 1];
+		struct polygon_edge e;
+
+		if (y0 == y1)
+			continue;
+		if (y0 > y1) {
+			int t = x0;
+			x0 = x1;
+			x1 = t;
+			t = y0;
+			y0 = y1;
+			y1 = t;
+		}
+		e.yb = y0;
+		e.ye = y1;
+		e.x = x0 * FIX_ONE;
+		e.dxdy = (x1 - x0) * FIX_ONE / (y1 - y0);
+
+		/* Keep edge table sorted on first scanline */
+		for (j = count; j > 0 && edges[j - 1].yb > e.yb; j--)
+			edges[j] = edges[j - 1];
+		edges[j] = e;
+		count++;
+	}
+	return count;
+}
+
+void svgalib_fill_polygon(const int pgn[], int nr, int color)
+{
+	struct polygon_edge edges[POLYGON_VERTICES_MAX];
+	struct polygon_edge *active[POLYGON_VERTICES_MAX];
+	int count, next = 0, nactive = 0, y;
+	register int i, j;
+
+	if (nr < 3 || nr > POLYGON_VERTICES_MAX) {
+		DEBUG("Polygon of %d vertices not filled", nr);
+		return;
+	}
+
+	count = polygon_edges(pgn, nr, edges);
+	if (count == 0)
+		return;
+
+	for (y = edges[0].yb; next < count || nactive; y++) {
+		/* Move edges starting at this scanline into active list */
+		while (next < count && edges[next].yb == y)
+			active[nactive++] = &edges[next++];
+
+		/* Drop edges ending here, insertion sort rest on x */
+		for (i = 0, j = 0; i < nactive; i++) {
+			if (active[i]->ye > y)
+				active[j++] = active[i];
+		}
+		nactive = j;
+
+		for (i = 1; i < nactive; i++) {
+			struct polygon_edge *e = active[i];
+
+			for (j = i; j > 0 && active[j - 1]->x > e->x; j--)
+				active[j] = active[j - 1];
+			active[j] = e;
+		}
+
+		/* Fill between pairs of crossings, even-odd rule */
+		for (i = 0; i + 1 < nactive; i += 2)
+			svgalib_draw_hline((active[i]->x + FIX_HALF) >> FIX_SHIFT,
+					   y,
+					   (active[i + 1]->x + FIX_HALF) >> FIX_SHIFT,
+					   color);
+
+		for (i = 0; i < nactive; i++)
+			active[i]->x += active[i]->dxdy;
+
+		if (nactive == 0 && next < count)
+			y = edges[next].yb - 1;
+	}
+}
@@ -14,10 +14,26 @@
 #define CTX_HEIGHT	(MAXY_PIXELS)
 #define CTX_WIDTH	(MAXX_PIXELS)
 
-#ifdef CONFIG_SVGALIB_GRAPHICS_MODE
+/* Pixel of 64K color modes, see svgalib_get_color() for layout */
+typedef unsigned short svgalib_pixel_t;
+
+/* End points of line primitives are given in 1/256 of a pixel */
+#define SVGALIB_SUBPIXEL_SHIFT	8
+
+/* Clip rectangle of line primitives, edges included */
+struct svgalib_clip {
+	int xmin, ymin;
+	int xmax, ymax;
+};
+
+#if defined(CONFIG_SVGALIB_GRAPHICS_MODE)
 #include "svgalib-graphics.h"
+#elif defined(CONFIG_SVGALIB_FRAMEBUFFER_MODE)
+#include "svgalib-fb.h"
 #else
 #include "svgalib-text.h"
 #endif
 
+#include "svgalib-record.h"
+
 #endif  /* SVGALIB_PRIVATE_H_INCLUDED */
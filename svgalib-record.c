@@ -0,0 +1,987 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SVGALIB_BACKEND
+#include "svgalib-private.h"
+#include "internals.h"
+#include "debug.h"
+
+#define DL_MAGIC		"GPGSDL"
+#define DL_VERSION		1
+#define DL_HEADER_SIZE		12
+
+/* Contexts and layers told apart in a capture, id 0 stands for NULL */
+#define DL_CONTEXTS_NR		16
+
+#define DL_BUFFER_CHUNK		4096
+
+/* Sanity limit of replayed polygons */
+#define DL_POLYGON_VERTICES_MAX	256
+
+typedef enum dl_op_t {
+	DL_SHOW = 1,
+	DL_DAMAGE_BOX,
+	DL_DAMAGE_SCREEN,
+	DL_CLEAR_SCREEN,
+	DL_COPY_BOX_TO_SCREEN,
+	DL_DRAW_FRAME,
+	DL_TEXT,
+	DL_TEXT_WRAPPED,
+	DL_THICK_LINE,
+	DL_GRID,
+	DL_CONTEXT_CREATE,
+	DL_CONTEXT_DESTROY,
+	DL_SET_CONTEXT,
+	DL_LAYER_CREATE,
+	DL_LAYER_BEGIN,
+	DL_LAYER_END,
+	DL_COPY_LAYER,
+	DL_CLEAR_CONTEXT,
+	DL_BOX,
+	DL_LINE,
+	DL_HLINE,
+	DL_CIRCLE,
+	DL_CIRCLE_FILLED,
+	DL_POLYGON,
+	DL_PIXEL,
+	DL_PUT_BOX,
+	DL_COPY_BOX,
+	DL_SEGMENT,
+} dl_op_t;
+
+struct dl_buffer {
+	unsigned char *data;
+	size_t size, alloc;
+};
+
+/* Context of a slot, layers with their size and virtual ones with 0 */
+struct dl_context {
+	const GraphicsContext *gc;
+	int w, h;
+};
+
+/**
+ * Commands of a frame are collected until svgalib_show_context() and
+ * written as difference to the previous frame: lengths of the common
+ * head and tail followed by the differing bytes in between. Contexts
+ * as last written are kept apart, so that a dropped frame does not
+ * lose their create and destroy commands.
+ */
+struct dl_recorder {
+	FILE *fp;
+	struct dl_buffer cur, prev;
+	struct dl_context contexts[DL_CONTEXTS_NR];
+	struct dl_context written[DL_CONTEXTS_NR];
+	unsigned int frames;
+	unsigned long bytes;
+	unsigned int failed : 1;
+};
+
+static struct dl_recorder recorder;
+
+static int dl_reserve(struct dl_buffer *b, size_t size)
+{
+	unsigned char *p = NULL;
+	size_t alloc;
+
+	if (b->size + size <= b->alloc)
+		return 0;
+
+	alloc = (b->size + size + DL_BUFFER_CHUNK) & ~(DL_BUFFER_CHUNK - 1);
+	p = realloc(b->data, alloc);
+	if (p == NULL) {
+		SYSERR("Failed to grow display list.");
+		return -1;
+	}
+	b->data = p;
+	b->alloc = alloc;
+	return 0;
+}
+
+static void dl_put8(int v)
+{
+	struct dl_buffer *b = &recorder.cur;
+
+	if (dl_reserve(b, 1) != 0) {
+		recorder.failed = 1;
+		return;
+	}
+	b->data[b->size++] = v & 0xFF;
+}
+
+/* Coordinates and colors both fit into 16 bits, stored little endian */
+static void dl_put16(int v)
+{
+	dl_put8(v);
+	dl_put8(v >> 8);
+}
+
+static void dl_put32(FILE *fp, unsigned long v)
+{
+	unsigned char b[4];
+
+	b[0] = v & 0xFF;
+	b[1] = (v >> 8) & 0xFF;
+	b[2] = (v >> 16) & 0xFF;
+	b[3] = (v >> 24) & 0xFF;
+	fwrite(b, 1, 4, fp);
+}
+
+static void dl_record(dl_op_t op, int nr, const int *args)
+{
+	register int i;
+
+	dl_put8(op);
+	for (i = 0; i < nr; i++)
+		dl_put16(args[i]);
+}
+
+static inline int dl_recording(void)
+{
+	return recorder.fp != NULL;
+}
+
+/* Id of context, new ones are announced to the capture first */
+static int dl_context_id(const GraphicsContext *gc)
+{
+	register int i;
+	int id = 0;
+
+	if (gc == NULL)
+		return 0;
+
+	for (i = 1; i < DL_CONTEXTS_NR; i++) {
+		if (recorder.contexts[i].gc == gc)
+			return i;
+		if (!id && recorder.contexts[i].gc == NULL)
+			id = i;
+	}
+	if (!id) {
+		DEBUG("Too many contexts to record.");
+		return 0;
+	}
+
+	/* Created before recording started, replayed as virtual one */
+	recorder.contexts[id].gc = gc;
+	recorder.contexts[id].w = recorder.contexts[id].h = 0;
+	dl_record(DL_CONTEXT_CREATE, 1, &id);
+	return id;
+}
+
+static void dl_close(void)
+{
+	fclose(recorder.fp);
+	recorder.fp = NULL;
+
+	INFO("Recorded %u frames in %lu bytes",
+	     recorder.frames, recorder.bytes);
+	free(recorder.cur.data);
+	free(recorder.prev.data);
+	memset(&recorder.cur, 0, sizeof(struct dl_buffer));
+	memset(&recorder.prev, 0, sizeof(struct dl_buffer));
+}
+
+/* Bring contexts of the replay in step with the recorded ones */
+static void dl_record_contexts(void)
+{
+	const struct dl_context *c, *w;
+	int i, a[3];
+
+	for (i = 1; i < DL_CONTEXTS_NR; i++) {
+		c = &recorder.contexts[i];
+		w = &recorder.written[i];
+		if (c->gc == w->gc && c->w == w->w && c->h == w->h)
+			continue;
+
+		a[0] = i;
+		a[1] = c->w;
+		a[2] = c->h;
+		if (c->gc == NULL)
+			dl_record(DL_CONTEXT_DESTROY, 1, a);
+		else if (c->w)
+			dl_record(DL_LAYER_CREATE, 3, a);
+		else
+			dl_record(DL_CONTEXT_CREATE, 1, a);
+	}
+}
+
+static void dl_flush_frame(void)
+{
+	struct dl_recorder *r = &recorder;
+	struct dl_buffer tmp;
+	size_t head = 0, tail = 0, n;
+
+	if (r->failed) {
+		/*
+		 * Drop broken frame, only its context changes are written
+		 * and the next frame in full. Without memory even for them,
+		 * frames keep being dropped until they fit.
+		 */
+		r->failed = 0;
+		r->cur.size = 0;
+		r->prev.size = 0;
+		dl_record_contexts();
+		if (r->failed) {
+			r->cur.size = 0;
+			return;
+		}
+	}
+
+	n = r->cur.size < r->prev.size ? r->cur.size : r->prev.size;
+	while (head < n && r->cur.data[head] == r->prev.data[head])
+		head++;
+	while (tail < n - head &&
+	       r->cur.data[r->cur.size - tail - 1] ==
+	       r->prev.data[r->prev.size - tail - 1])
+		tail++;
+
+	dl_put32(r->fp, r->cur.size);
+	dl_put32(r->fp, head);
+	dl_put32(r->fp, tail);
+	fwrite(r->cur.data + head, 1, r->cur.size - head - tail, r->fp);
+	if (ferror(r->fp)) {
+		/* Stream is broken from here on, replay stops before it */
+		SYSERR("Failed to write capture, recording stopped.");
+		dl_close();
+		return;
+	}
+	memcpy(r->written, r->contexts, sizeof(r->written));
+	r->bytes += 12 + r->cur.size - head - tail;
+	r->frames++;
+
+	tmp = r->prev;
+	r->prev = r->cur;
+	r->cur = tmp;
+	r->cur.size = 0;
+}
+
+int svgalib_record_start(const char *file)
+{
+	unsigned char hdr[DL_HEADER_SIZE] = DL_MAGIC;
+
+	if (dl_recording())
+		svgalib_record_stop();
+
+	recorder.fp = fopen(file, "wb");
+	if (recorder.fp == NULL) {
+		SYSERR("Failed to open capture file: %s", file);
+		return -1;
+	}
+
+	hdr[6] = DL_VERSION;
+	hdr[8] = CTX_WIDTH & 0xFF;
+	hdr[9] = CTX_WIDTH >> 8;
+	hdr[10] = CTX_HEIGHT & 0xFF;
+	hdr[11] = CTX_HEIGHT >> 8;
+	fwrite(hdr, 1, DL_HEADER_SIZE, recorder.fp);
+
+	memset(recorder.contexts, 0, sizeof(recorder.contexts));
+	memset(recorder.written, 0, sizeof(recorder.written));
+	recorder.cur.size = recorder.prev.size = 0;
+	recorder.frames = 0;
+	recorder.bytes = DL_HEADER_SIZE;
+	recorder.failed = 0;
+	INFO("Recording display list into %s", file);
+	return 0;
+}
+
+void svgalib_record_stop(void)
+{
+	if (!dl_recording())
+		return;
+
+	if (recorder.cur.size)
+		dl_flush_frame();
+	if (dl_recording())
+		dl_close();
+}
+
+/*
+ * Recording hooks, see svgalib-record.h. Each records its command and
+ * then calls the backend.
+ */
+
+#define DL_RECORD(op, ...)						\
+	do {								\
+		if (dl_recording()) {					\
+			const int __args[] = { __VA_ARGS__ };		\
+			dl_record(op, ARRAY_SIZE(__args), __args);	\
+		}							\
+	} while (0)
+
+static void dl_record_text(dl_op_t op, int xb, int yb, const char txt[],
+			   font_t type, int bgcolor, int txtcolor)
+{
+	int len = txt ? strlen(txt) : 0;
+	register int i;
+
+	if (len > 0xFFFF)
+		len = 0xFFFF;
+
+	DL_RECORD(op, xb, yb, type, bgcolor, txtcolor, len);
+	for (i = 0; i < len; i++)
+		dl_put8(txt[i]);
+}
+
+int svgalib_rec_init(int mode)
+{
+	const char *file = NULL;
+	int retval = svgalib_init(mode);
+
+	file = getenv(SVGALIB_RECORD_FILE_ENV);
+	if (!retval && file != NULL)
+		svgalib_record_start(file);
+	return retval;
+}
+
+void svgalib_rec_exit(void)
+{
+	svgalib_record_stop();
+	svgalib_exit();
+}
+
+void svgalib_rec_show_context(GraphicsContext *gc)
+{
+	if (dl_recording()) {
+		DL_RECORD(DL_SHOW, dl_context_id(gc));
+		dl_flush_frame();
+	}
+	svgalib_show_context(gc);
+}
+
+void svgalib_rec_damage_box(int x, int y, int w, int h)
+{
+	DL_RECORD(DL_DAMAGE_BOX, x, y, w, h);
+	svgalib_damage_box(x, y, w, h);
+}
+
+void svgalib_rec_damage_screen(void)
+{
+	if (dl_recording())
+		dl_put8(DL_DAMAGE_SCREEN);
+	svgalib_damage_screen();
+}
+
+void svgalib_rec_clear_screen(int color)
+{
+	DL_RECORD(DL_CLEAR_SCREEN, color);
+	svgalib_clear_screen(color);
+}
+
+void svgalib_rec_copy_box_to_screen(int x, int y, int w, int h)
+{
+	DL_RECORD(DL_COPY_BOX_TO_SCREEN, x, y, w, h);
+	svgalib_copy_box_to_screen(x, y, w, h);
+}
+
+void svgalib_rec_draw_frame(int x, int y, int w, int h, int color)
+{
+	DL_RECORD(DL_DRAW_FRAME, x, y, w, h, color);
+	svgalib_draw_frame(x, y, w, h, color);
+}
+
+void svgalib_rec_display_text(int xb, int yb, const char txt[],
+			      font_t type, int bgcolor, int txtcolor)
+{
+	if (dl_recording())
+		dl_record_text(DL_TEXT, xb, yb, txt, type, bgcolor, txtcolor);
+	svgalib_display_text(xb, yb, txt, type, bgcolor, txtcolor);
+}
+
+void svgalib_rec_display_text_wrapped(int xb, int yb, const char txt[],
+				      font_t type, int bgcolor, int txtcolor)
+{
+	if (dl_recording())
+		dl_record_text(DL_TEXT_WRAPPED, xb, yb, txt, type,
+			       bgcolor, txtcolor);
+	svgalib_display_text_wrapped(xb, yb, txt, type, bgcolor, txtcolor);
+}
+
+void svgalib_rec_draw_thick_line(int xb, int yb, int xe, int ye, int color)
+{
+	DL_RECORD(DL_THICK_LINE, xb, yb, xe, ye, color);
+	svgalib_draw_thick_line(xb, yb, xe, ye, color);
+}
+
+/* Segments are recorded clipped, in whole pixels */
+static void dl_record_segment(const struct svgalib_clip *clip,
+			      const int seg[4], int width, int color)
+{
+	int l[4];
+
+	if (svgalib_clip_segment(clip, seg, l) == 0)
+		DL_RECORD(DL_SEGMENT, l[0], l[1], l[2], l[3], width, color);
+}
+
+void svgalib_rec_draw_segments(const int seg[], int nr,
+			       const struct svgalib_clip *clip,
+			       int width, int color)
+{
+	register int i;
+
+	if (dl_recording()) {
+		for (i = 0; i < nr; i++)
+			dl_record_segment(clip, seg + 4 * i, width, color);
+	}
+	svgalib_draw_segments(seg, nr, clip, width, color);
+}
+
+void svgalib_rec_draw_polyline(const int pts[], int nr,
+			       const struct svgalib_clip *clip,
+			       int width, int color)
+{
+	register int i;
+
+	if (dl_recording()) {
+		for (i = 0; i + 1 < nr; i++)
+			dl_record_segment(clip, pts + 2 * i, width, color);
+	}
+	svgalib_draw_polyline(pts, nr, clip, width, color);
+}
+
+void svgalib_rec_draw_grid(int x, int y, int w, int h, int step, int color)
+{
+	DL_RECORD(DL_GRID, x, y, w, h, step, color);
+	svgalib_draw_grid(x, y, w, h, step, color);
+}
+
+GraphicsContext *svgalib_rec_virtual_context_create(void)
+{
+	GraphicsContext *gc = svgalib_virtual_context_create();
+
+	if (dl_recording() && gc != NULL)
+		dl_context_id(gc);
+	return gc;
+}
+
+void svgalib_rec_virtual_context_destroy(GraphicsContext *gc)
+{
+	if (dl_recording() && gc != NULL) {
+		int id = dl_context_id(gc);
+
+		DL_RECORD(DL_CONTEXT_DESTROY, id);
+		recorder.contexts[id].gc = NULL;
+	}
+	svgalib_virtual_context_destroy(gc);
+}
+
+void svgalib_rec_set_context(GraphicsContext *gc)
+{
+	DL_RECORD(DL_SET_CONTEXT, dl_context_id(gc));
+	svgalib_set_context(gc);
+}
+
+GraphicsContext *svgalib_rec_layer_create(int w, int h)
+{
+	GraphicsContext *gc = svgalib_layer_create(w, h);
+	register int i;
+
+	if (!dl_recording() || gc == NULL)
+		return gc;
+
+	for (i = 1; i < DL_CONTEXTS_NR; i++) {
+		if (recorder.contexts[i].gc == NULL) {
+			recorder.contexts[i].gc = gc;
+			recorder.contexts[i].w = w;
+			recorder.contexts[i].h = h;
+			DL_RECORD(DL_LAYER_CREATE, i, w, h);
+			return gc;
+		}
+	}
+	DEBUG("Too many contexts to record.");
+	return gc;
+}
+
+void svgalib_rec_layer_begin(GraphicsContext *gc)
+{
+	DL_RECORD(DL_LAYER_BEGIN, dl_context_id(gc));
+	svgalib_layer_begin(gc);
+}
+
+void svgalib_rec_layer_end(void)
+{
+	if (dl_recording())
+		dl_put8(DL_LAYER_END);
+	svgalib_layer_end();
+}
+
+void svgalib_rec_copy_layer(GraphicsContext *gc, int x, int y,
+			    int w, int h, int xd, int yd)
+{
+	DL_RECORD(DL_COPY_LAYER, dl_context_id(gc), x, y, w, h, xd, yd);
+	svgalib_copy_layer(gc, x, y, w, h, xd, yd);
+}
+
+void svgalib_rec_clear_context(GraphicsContext *gc, int color)
+{
+	DL_RECORD(DL_CLEAR_CONTEXT, dl_context_id(gc), color);
+	svgalib_clear_context(gc, color);
+}
+
+void svgalib_rec_draw_box_colored(int x, int y, int w, int h, int color)
+{
+	DL_RECORD(DL_BOX, x, y, w, h, color);
+	svgalib_draw_box_colored(x, y, w, h, color);
+}
+
+void svgalib_rec_draw_line(int xb, int yb, int xe, int ye, int color)
+{
+	DL_RECORD(DL_LINE, xb, yb, xe, ye, color);
+	svgalib_draw_line(xb, yb, xe, ye, color);
+}
+
+void svgalib_rec_draw_hline(int xb, int yb, int xe, int color)
+{
+	DL_RECORD(DL_HLINE, xb, yb, xe, color);
+	svgalib_draw_hline(xb, yb, xe, color);
+}
+
+void svgalib_rec_draw_circle(int xc, int yc, int r, int color)
+{
+	DL_RECORD(DL_CIRCLE, xc, yc, r, color);
+	svgalib_draw_circle(xc, yc, r, color);
+}
+
+void svgalib_rec_draw_circle_filled(int xc, int yc, int r, int color)
+{
+	DL_RECORD(DL_CIRCLE_FILLED, xc, yc, r, color);
+	svgalib_draw_circle_filled(xc, yc, r, color);
+}
+
+void svgalib_rec_fill_polygon(const int pgn[], int nr, int color)
+{
+	register int i;
+
+	if (dl_recording() && nr > 0) {
+		DL_RECORD(DL_POLYGON, nr, color);
+		for (i = 0; i < 2 * nr; i++)
+			dl_put16(pgn[i]);
+	}
+	svgalib_fill_polygon(pgn, nr, color);
+}
+
+void svgalib_rec_set_pixel(int x, int y, int color)
+{
+	DL_RECORD(DL_PIXEL, x, y, color);
+	svgalib_set_pixel(x, y, color);
+}
+
+void svgalib_rec_put_box(int x, int y, int w, int h,
+			 const svgalib_pixel_t *buf, int pitch)
+{
+	register int i, j;
+
+	if (dl_recording() && w > 0 && h > 0) {
+		int run = 0, pixel = buf[0];
+
+		/* Pixels as runs of up to 255 equal ones, rows joined */
+		DL_RECORD(DL_PUT_BOX, x, y, w, h);
+		for (j = 0; j < h; j++) {
+			for (i = 0; i < w; i++) {
+				if (buf[j * pitch + i] == pixel && run < 0xFF) {
+					run++;
+					continue;
+				}
+				dl_put8(run);
+				dl_put16(pixel);
+				pixel = buf[j * pitch + i];
+				run = 1;
+			}
+		}
+		dl_put8(run);
+		dl_put16(pixel);
+	}
+	svgalib_put_box(x, y, w, h, buf, pitch);
+}
+
+void svgalib_rec_copy_box(int x, int y, int w, int h, int xd, int yd)
+{
+	DL_RECORD(DL_COPY_BOX, x, y, w, h, xd, yd);
+	svgalib_copy_box(x, y, w, h, xd, yd);
+}
+
+/*
+ * Replay
+ */
+
+struct dl_reader {
+	const unsigned char *p, *end;
+	GraphicsContext *contexts[DL_CONTEXTS_NR];
+	svgalib_pixel_t *pixels;
+	size_t pixels_nr;
+	unsigned int error : 1;
+};
+
+static int dl_get8(struct dl_reader *rd)
+{
+	if (rd->p >= rd->end) {
+		rd->error = 1;
+		return 0;
+	}
+	return *rd->p++;
+}
+
+static int dl_get16u(struct dl_reader *rd)
+{
+	int v = dl_get8(rd);
+	return v | (dl_get8(rd) << 8);
+}
+
+static int dl_get16(struct dl_reader *rd)
+{
+	return (short)dl_get16u(rd);
+}
+
+static void dl_get_args(struct dl_reader *rd, int *args, int nr)
+{
+	register int i;
+
+	for (i = 0; i < nr; i++)
+		args[i] = dl_get16(rd);
+}
+
+static GraphicsContext *dl_get_context(struct dl_reader *rd)
+{
+	int id = dl_get16(rd);
+
+	if (id < 0 || id >= DL_CONTEXTS_NR) {
+		rd->error = 1;
+		return NULL;
+	}
+	return rd->contexts[id];
+}
+
+/* Context slot to be filled by a newly created one */
+static GraphicsContext **dl_new_context(struct dl_reader *rd, int id)
+{
+	if (id <= 0 || id >= DL_CONTEXTS_NR) {
+		rd->error = 1;
+		return NULL;
+	}
+	if (rd->contexts[id] != NULL)
+		svgalib_virtual_context_destroy(rd->contexts[id]);
+	rd->contexts[id] = NULL;
+	return &rd->contexts[id];
+}
+
+static void dl_replay_text(struct dl_reader *rd, dl_op_t op)
+{
+	int a[6];
+	char *txt = NULL;
+
+	dl_get_args(rd, a, 6);
+	a[5] &= 0xFFFF;
+	if (rd->error || rd->end - rd->p < a[5]) {
+		rd->error = 1;
+		return;
+	}
+
+	txt = malloc(a[5] + 1);
+	if (txt == NULL) {
+		SYSERR("Failed to allocate text.");
+		rd->error = 1;
+		return;
+	}
+	memcpy(txt, rd->p, a[5]);
+	txt[a[5]] = '\0';
+	rd->p += a[5];
+
+	if (op == DL_TEXT)
+		svgalib_display_text(a[0], a[1], txt, a[2], a[3] & 0xFFFF,
+				     a[4] & 0xFFFF);
+	else
+		svgalib_display_text_wrapped(a[0], a[1], txt, a[2],
+					     a[3] & 0xFFFF, a[4] & 0xFFFF);
+	free(txt);
+}
+
+static void dl_replay_polygon(struct dl_reader *rd)
+{
+	int pgn[2 * DL_POLYGON_VERTICES_MAX];
+	int nr = dl_get16(rd), color = dl_get16u(rd);
+	register int i;
+
+	if (nr <= 0 || nr > DL_POLYGON_VERTICES_MAX) {
+		rd->error = 1;
+		return;
+	}
+	for (i = 0; i < 2 * nr; i++)
+		pgn[i] = dl_get16(rd);
+	if (!rd->error)
+		svgalib_fill_polygon(pgn, nr, color);
+}
+
+static void dl_replay_put_box(struct dl_reader *rd)
+{
+	int a[4];
+	size_t nr;
+	register size_t i;
+
+	dl_get_args(rd, a, 4);
+	if (rd->error || a[2] <= 0 || a[3] <= 0) {
+		rd->error = 1;
+		return;
+	}
+
+	nr = (size_t)a[2] * a[3];
+	if (nr > (size_t)CTX_WIDTH * CTX_HEIGHT) {
+		rd->error = 1;
+		return;
+	}
+	if (nr > rd->pixels_nr) {
+		svgalib_pixel_t *p = realloc(rd->pixels,
+					     nr * sizeof(svgalib_pixel_t));
+		if (p == NULL) {
+			SYSERR("Failed to allocate pixels.");
+			rd->error = 1;
+			return;
+		}
+		rd->pixels = p;
+		rd->pixels_nr = nr;
+	}
+	for (i = 0; i < nr && !rd->error; ) {
+		size_t run = dl_get8(rd);
+		svgalib_pixel_t pixel = dl_get16u(rd);
+
+		if (!run || run > nr - i) {
+			rd->error = 1;
+			return;
+		}
+		while (run--)
+			rd->pixels[i++] = pixel;
+	}
+	if (!rd->error)
+		svgalib_put_box(a[0], a[1], a[2], a[3], rd->pixels, a[2]);
+}
+
+/* Execute commands of one frame */
+static void dl_replay_frame(struct dl_reader *rd)
+{
+	GraphicsContext **slot = NULL;
+	int a[7];
+
+	while (rd->p < rd->end && !rd->error) {
+		dl_op_t op = dl_get8(rd);
+
+		switch (op) {
+		case DL_SHOW:
+			svgalib_show_context(dl_get_context(rd));
+			break;
+		case DL_DAMAGE_BOX:
+			dl_get_args(rd, a, 4);
+			svgalib_damage_box(a[0], a[1], a[2], a[3]);
+			break;
+		case DL_DAMAGE_SCREEN:
+			svgalib_damage_screen();
+			break;
+		case DL_CLEAR_SCREEN:
+			svgalib_clear_screen(dl_get16u(rd));
+			break;
+		case DL_COPY_BOX_TO_SCREEN:
+			dl_get_args(rd, a, 4);
+			svgalib_copy_box_to_screen(a[0], a[1], a[2], a[3]);
+			break;
+		case DL_DRAW_FRAME:
+			dl_get_args(rd, a, 5);
+			svgalib_draw_frame(a[0], a[1], a[2], a[3],
+					   a[4] & 0xFFFF);
+			break;
+		case DL_TEXT:
+		case DL_TEXT_WRAPPED:
+			dl_replay_text(rd, op);
+			break;
+		case DL_THICK_LINE:
+			dl_get_args(rd, a, 5);
+			svgalib_draw_thick_line(a[0], a[1], a[2], a[3],
+						a[4] & 0xFFFF);
+			break;
+		case DL_GRID:
+			dl_get_args(rd, a, 6);
+			svgalib_draw_grid(a[0], a[1], a[2], a[3], a[4],
+					  a[5] & 0xFFFF);
+			break;
+		case DL_CONTEXT_CREATE:
+			slot = dl_new_context(rd, dl_get16(rd));
+			if (slot != NULL)
+				*slot = svgalib_virtual_context_create();
+			break;
+		case DL_CONTEXT_DESTROY:
+			dl_new_context(rd, dl_get16(rd));
+			break;
+		case DL_SET_CONTEXT:
+			a[0] = dl_get16(rd);
+			if (a[0] > 0 && a[0] < DL_CONTEXTS_NR &&
+			    rd->contexts[a[0]] != NULL)
+				svgalib_set_context(rd->contexts[a[0]]);
+			break;
+		case DL_LAYER_CREATE:
+			dl_get_args(rd, a, 3);
+			slot = dl_new_context(rd, a[0]);
+			if (slot != NULL)
+				*slot = svgalib_layer_create(a[1], a[2]);
+			break;
+		case DL_LAYER_BEGIN:
+			a[0] = dl_get16(rd);
+			if (a[0] > 0 && a[0] < DL_CONTEXTS_NR &&
+			    rd->contexts[a[0]] != NULL)
+				svgalib_layer_begin(rd->contexts[a[0]]);
+			break;
+		case DL_LAYER_END:
+			svgalib_layer_end();
+			break;
+		case DL_COPY_LAYER:
+			dl_get_args(rd, a, 7);
+			if (a[0] > 0 && a[0] < DL_CONTEXTS_NR &&
+			    rd->contexts[a[0]] != NULL)
+				svgalib_copy_layer(rd->contexts[a[0]], a[1],
+						   a[2], a[3], a[4], a[5],
+						   a[6]);
+			break;
+		case DL_CLEAR_CONTEXT:
+			dl_get_args(rd, a, 2);
+			if (a[0] > 0 && a[0] < DL_CONTEXTS_NR &&
+			    rd->contexts[a[0]] != NULL)
+				svgalib_clear_context(rd->contexts[a[0]],
+						      a[1] & 0xFFFF);
+			break;
+		case DL_BOX:
+			dl_get_args(rd, a, 5);
+			svgalib_draw_box_colored(a[0], a[1], a[2], a[3],
+						 a[4] & 0xFFFF);
+			break;
+		case DL_LINE:
+			dl_get_args(rd, a, 5);
+			svgalib_draw_line(a[0], a[1], a[2], a[3],
+					  a[4] & 0xFFFF);
+			break;
+		case DL_HLINE:
+			dl_get_args(rd, a, 4);
+			svgalib_draw_hline(a[0], a[1], a[2], a[3] & 0xFFFF);
+			break;
+		case DL_CIRCLE:
+			dl_get_args(rd, a, 4);
+			svgalib_draw_circle(a[0], a[1], a[2], a[3] & 0xFFFF);
+			break;
+		case DL_CIRCLE_FILLED:
+			dl_get_args(rd, a, 4);
+			svgalib_draw_circle_filled(a[0], a[1], a[2],
+						   a[3] & 0xFFFF);
+			break;
+		case DL_POLYGON:
+			dl_replay_polygon(rd);
+			break;
+		case DL_PIXEL:
+			dl_get_args(rd, a, 3);
+			svgalib_set_pixel(a[0], a[1], a[2] & 0xFFFF);
+			break;
+		case DL_PUT_BOX:
+			dl_replay_put_box(rd);
+			break;
+		case DL_SEGMENT:
+			dl_get_args(rd, a, 6);
+			a[0] <<= SVGALIB_SUBPIXEL_SHIFT;
+			a[1] <<= SVGALIB_SUBPIXEL_SHIFT;
+			a[2] <<= SVGALIB_SUBPIXEL_SHIFT;
+			a[3] <<= SVGALIB_SUBPIXEL_SHIFT;
+			svgalib_draw_segments(a, 1, NULL, a[4], a[5] & 0xFFFF);
+			break;
+		case DL_COPY_BOX:
+			dl_get_args(rd, a, 6);
+			svgalib_copy_box(a[0], a[1], a[2], a[3], a[4], a[5]);
+			break;
+		default:
+			DEBUG("Unknown display list command %d", op);
+			rd->error = 1;
+			break;
+		}
+	}
+}
+
+static int dl_read32(FILE *fp, unsigned long *v)
+{
+	unsigned char b[4];
+
+	if (fread(b, 1, 4, fp) != 4)
+		return -1;
+	*v = b[0] | (b[1] << 8) | ((unsigned long)b[2] << 16) |
+	     ((unsigned long)b[3] << 24);
+	return 0;
+}
+
+int svgalib_replay(const char *file, svgalib_replay_callback_t fn,
+		   void *userdata)
+{
+	struct dl_reader rd;
+	struct dl_buffer cur = { NULL, 0, 0 }, prev = { NULL, 0, 0 }, tmp;
+	unsigned char hdr[DL_HEADER_SIZE];
+	unsigned long size, head, tail;
+	int frames = 0, retval = -1;
+	register int i;
+	FILE *fp = NULL;
+
+	fp = fopen(file, "rb");
+	if (fp == NULL) {
+		SYSERR("Failed to open capture file: %s", file);
+		return -1;
+	}
+
+	if (fread(hdr, 1, DL_HEADER_SIZE, fp) != DL_HEADER_SIZE ||
+	    memcmp(hdr, DL_MAGIC, 6) || hdr[6] != DL_VERSION) {
+		ERROR("Not a display list capture: %s", file);
+		goto exit_close;
+	}
+	memset(&rd, 0, sizeof(struct dl_reader));
+
+	while (!dl_read32(fp, &size)) {
+		if (dl_read32(fp, &head) || dl_read32(fp, &tail) ||
+		    head + tail > size || head > prev.size ||
+		    tail > prev.size - head) {
+			ERROR("Broken frame %d in %s", frames, file);
+			goto exit_free;
+		}
+
+		cur.size = 0;
+		if (dl_reserve(&cur, size) != 0)
+			goto exit_free;
+		memcpy(cur.data, prev.data, head);
+		if (fread(cur.data + head, 1, size - head - tail, fp) !=
+		    size - head - tail) {
+			ERROR("Truncated frame %d in %s", frames, file);
+			goto exit_free;
+		}
+		memcpy(cur.data + size - tail,
+		       prev.data + prev.size - tail, tail);
+		cur.size = size;
+
+		rd.p = cur.data;
+		rd.end = cur.data + cur.size;
+		dl_replay_frame(&rd);
+		if (rd.error) {
+			ERROR("Broken command in frame %d of %s",
+			      frames, file);
+			goto exit_free;
+		}
+		frames++;
+
+		if (fn != NULL && fn(frames - 1, userdata))
+			break;
+
+		tmp = prev;
+		prev = cur;
+		cur = tmp;
+	}
+	retval = frames;
+
+ exit_free:
+	for (i = 1; i < DL_CONTEXTS_NR; i++) {
+		if (rd.contexts[i] != NULL)
+			svgalib_virtual_context_destroy(rd.contexts[i]);
+	}
+	free(rd.pixels);
+	free(cur.data);
+	free(prev.data);
+ exit_close:
+	fclose(fp);
+	return retval;
+}
@@ -0,0 +1,111 @@
+#ifndef SVGALIB_RECORD_H_INCLUDED
+#define SVGALIB_RECORD_H_INCLUDED
+
+/*
+ * Display list capture of svgalib_* drawing calls. Built with
+ * CONFIG_SVGALIB_RECORD, every call outside the backends goes through a
+ * recording hook, and recording starts in svgalib_init() when the
+ * environment variable below names a capture file.
+ */
+#define SVGALIB_RECORD_FILE_ENV		"GPGS_RECORD_FILE"
+
+extern int svgalib_record_start(const char *file);
+
+extern void svgalib_record_stop(void);
+
+/* Called after each replayed frame, non zero return stops the replay */
+typedef int (*svgalib_replay_callback_t)(int frame, void *userdata);
+
+/**
+ * Replay capture against the current backend. Contexts created by the
+ * capture are destroyed at the end, so caller has to set its own one.
+ *
+ * @return: Number of frames replayed, or -1 on error.
+ */
+extern int svgalib_replay(const char *file, svgalib_replay_callback_t fn,
+			  void *userdata);
+
+#ifdef CONFIG_SVGALIB_RECORD
+
+extern int svgalib_rec_init(int mode);
+extern void svgalib_rec_exit(void);
+extern void svgalib_rec_show_context(GraphicsContext *gc);
+extern void svgalib_rec_damage_box(int x, int y, int w, int h);
+extern void svgalib_rec_damage_screen(void);
+extern void svgalib_rec_clear_screen(int color);
+extern void svgalib_rec_copy_box_to_screen(int x, int y, int w, int h);
+extern void svgalib_rec_draw_frame(int x, int y, int w, int h, int color);
+extern void svgalib_rec_display_text(int xb, int yb, const char txt[],
+				     font_t type, int bgcolor, int txtcolor);
+extern void svgalib_rec_display_text_wrapped(int xb, int yb, const char txt[],
+					     font_t type, int bgcolor,
+					     int txtcolor);
+extern void svgalib_rec_draw_thick_line(int xb, int yb, int xe, int ye,
+					int color);
+extern void svgalib_rec_draw_segments(const int seg[], int nr,
+				      const struct svgalib_clip *clip,
+				      int width, int color);
+extern void svgalib_rec_draw_polyline(const int pts[], int nr,
+				      const struct svgalib_clip *clip,
+				      int width, int color);
+extern void svgalib_rec_draw_grid(int x, int y, int w, int h,
+				  int step, int color);
+extern GraphicsContext *svgalib_rec_virtual_context_create(void);
+extern void svgalib_rec_virtual_context_destroy(GraphicsContext *gc);
+extern void svgalib_rec_set_context(GraphicsContext *gc);
+extern GraphicsContext *svgalib_rec_layer_create(int w, int h);
+extern void svgalib_rec_layer_begin(GraphicsContext *gc);
+extern void svgalib_rec_layer_end(void);
+extern void svgalib_rec_copy_layer(GraphicsContext *gc, int x, int y,
+				   int w, int h, int xd, int yd);
+extern void svgalib_rec_clear_context(GraphicsContext *gc, int color);
+extern void svgalib_rec_draw_box_colored(int x, int y, int w, int h,
+					 int color);
+extern void svgalib_rec_draw_line(int xb, int yb, int xe, int ye, int color);
+extern void svgalib_rec_draw_hline(int xb, int yb, int xe, int color);
+extern void svgalib_rec_draw_circle(int xc, int yc, int r, int color);
+extern void svgalib_rec_draw_circle_filled(int xc, int yc, int r, int color);
+extern void svgalib_rec_fill_polygon(const int pgn[], int nr, int color);
+extern void svgalib_rec_set_pixel(int x, int y, int color);
+extern void svgalib_rec_put_box(int x, int y, int w, int h,
+				const svgalib_pixel_t *buf, int pitch);
+extern void svgalib_rec_copy_box(int x, int y, int w, int h, int xd, int yd);
+
+/* Backends define SVGALIB_BACKEND to keep calling each other directly */
+#ifndef SVGALIB_BACKEND
+#define svgalib_init			svgalib_rec_init
+#define svgalib_exit			svgalib_rec_exit
+#define svgalib_show_context		svgalib_rec_show_context
+#define svgalib_damage_box		svgalib_rec_damage_box
+#define svgalib_damage_screen		svgalib_rec_damage_screen
+#define svgalib_clear_screen		svgalib_rec_clear_screen
+#define svgalib_copy_box_to_screen	svgalib_rec_copy_box_to_screen
+#define svgalib_draw_frame		svgalib_rec_draw_frame
+#define svgalib_display_text		svgalib_rec_display_text
+#define svgalib_display_text_wrapped	svgalib_rec_display_text_wrapped
+#define svgalib_draw_thick_line		svgalib_rec_draw_thick_line
+#define svgalib_draw_segments		svgalib_rec_draw_segments
+#define svgalib_draw_polyline		svgalib_rec_draw_polyline
+#define svgalib_draw_grid		svgalib_rec_draw_grid
+#define svgalib_virtual_context_create	svgalib_rec_virtual_context_create
+#define svgalib_virtual_context_destroy	svgalib_rec_virtual_context_destroy
+#define svgalib_set_context		svgalib_rec_set_context
+#define svgalib_layer_create		svgalib_rec_layer_create
+#define svgalib_layer_begin		svgalib_rec_layer_begin
+#define svgalib_layer_end		svgalib_rec_layer_end
+#define svgalib_copy_layer		svgalib_rec_copy_layer
+#define svgalib_clear_context		svgalib_rec_clear_context
+#define svgalib_draw_box_colored	svgalib_rec_draw_box_colored
+#define svgalib_draw_line		svgalib_rec_draw_line
+#define svgalib_draw_hline		svgalib_rec_draw_hline
+#define svgalib_draw_circle		svgalib_rec_draw_circle
+#define svgalib_draw_circle_filled	svgalib_rec_draw_circle_filled
+#define svgalib_fill_polygon		svgalib_rec_fill_polygon
+#define svgalib_set_pixel		svgalib_rec_set_pixel
+#define svgalib_put_box			svgalib_rec_put_box
+#define svgalib_copy_box		svgalib_rec_copy_box
+#endif	/* SVGALIB_BACKEND */
+
+#endif	/* CONFIG_SVGALIB_RECORD */
+
+#endif	/* SVGALIB_RECORD_H_INCLUDED */
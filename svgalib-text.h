@@ -2,6 +2,7 @@
 #define SVGALIB_TEXT_MODE_H_INCLUDED
 
 #include <stdlib.h>
+#include <string.h>
 
 #include "font/font.h"
 #include "debug.h"
@@ -26,6 +27,17 @@ static inline void svgalib_show_context(GraphicsContext *gc)
 	DEBUG("Graphics context displayed.");
 }
 
+static inline void svgalib_damage_box(int x, int y, int w, int h)
+{
+	DEBUG("Box of width=%d, height=%d at (%d, %d) marked damaged",
+	      w, h, x, y);
+}
+
+static inline void svgalib_damage_screen(void)
+{
+	DEBUG("Whole screen marked damaged");
+}
+
 static inline void svgalib_clear_screen(int color)
 {
 	DEBUG("Graphics context cleared");
@@ -57,6 +69,18 @@ static inline void svgalib_display_text_wrapped(int xb, int yb,
 	DEBUG("%s at (%d, %d) with font=%i", txt, xb, yb, type);
 }
 
+static inline int svgalib_text_width(const char txt[], font_t type)
+{
+	const struct font *f = get_font(type);
+	return strlen(txt) * (f ? font_width(f) : 8);
+}
+
+static inline int svgalib_text_height(font_t type)
+{
+	const struct font *f = get_font(type);
+	return f ? font_height(f) : 8;
+}
+
 static inline void svgalib_draw_thick_line(int xb, int yb, int xe,
 					   int ye, int color)
 {
@@ -64,6 +88,24 @@ static inline void svgalib_draw_thick_line(int xb, int yb, int xe,
 	      color, xb, yb, xe, ye);
 }
 
+static inline void svgalib_draw_segments(const int seg[], int nr,
+					 const struct svgalib_clip *clip,
+					 int width, int color)
+{
+	DEBUG("%d segments of width=%d, color=%d", nr, width, color);
+}
+
+static inline void svgalib_draw_polyline(const int pts[], int nr,
+					 const struct svgalib_clip *clip,
+					 int width, int color)
+{
+	DEBUG("Polyline of %d points, width=%d, color=%d", nr, width, color);
+}
+
+/* Provided by svgalib-line.c, used by the recorder */
+extern int svgalib_clip_segment(const struct svgalib_clip *clip,
+				const int seg[4], int out[4]);
+
 static inline void svgalib_draw_grid(int x, int y, int w, int h,
 				     int step, int color)
 {
@@ -83,6 +125,29 @@ static inline void svgalib_virtual_context_destroy(GraphicsContext *gc)
 	DEBUG("Virtual context destroyed.");
 }
 
+static inline GraphicsContext *svgalib_layer_create(int w, int h)
+{
+	DEBUG("Layer of width=%d, height=%d created.", w, h);
+	return (GraphicsContext *)malloc(sizeof(GraphicsContext));
+}
+
+static inline void svgalib_layer_begin(GraphicsContext *gc)
+{
+	DEBUG("Drawing into layer.");
+}
+
+static inline void svgalib_layer_end(void)
+{
+	DEBUG("Drawing into layer finished.");
+}
+
+static inline void svgalib_copy_layer(GraphicsContext *gc, int x, int y,
+				      int w, int h, int xd, int yd)
+{
+	DEBUG("Box of width=%d, height=%d of layer copied to (%d, %d)",
+	      w, h, xd, yd);
+}
+
 static inline void svgalib_set_context(GraphicsContext *gc)
 {
 	DEBUG("Graphics context set.");
@@ -128,9 +193,27 @@ static inline void svgalib_draw_circle_filled(int xc, int yc, int r, int color)
 	      color, r, xc, yc);
 }
 
+static inline void svgalib_fill_polygon(const int pgn[], int nr, int color)
+{
+	DEBUG("Polygon of %d vertices filled with color=%d", nr, color);
+}
+
 static inline void svgalib_set_pixel(int x, int y, int color)
 {
 	DEBUG("Pixel at (%d, %d) set with color=%d", x, y, color);
 }
 
+static inline void svgalib_copy_box(int x, int y, int w, int h,
+				    int xd, int yd)
+{
+	DEBUG("Box of width=%d, height=%d at (%d, %d) copied to (%d, %d)",
+	      w, h, x, y, xd, yd);
+}
+
+static inline void svgalib_put_box(int x, int y, int w, int h,
+				   const svgalib_pixel_t *buf, int pitch)
+{
+	DEBUG("Box of width=%d, height=%d put at (%d, %d)", w, h, x, y);
+}
+
 #endif	/* SVGALIB_TEXT_MODE_H_INCLUDED */
@@ -1,11 +1,17 @@
 #include <stdlib.h>
 
+#define SVGALIB_BACKEND
 #include "svgalib-private.h"
+#include "svgalib-damage.h"
+#include "svgalib-glyph.h"
 #include "debug.h"
 
 static GraphicsContext *physical_context = NULL;
 static int vgamode;
 
+/* Context current before drawing into a layer */
+static GraphicsContext saved_context;
+
 int svgalib_init(int mode)
 {
 	if (vga_init() != 0) {
@@ -49,6 +55,12 @@ int svgalib_init(int mode)
 	gl_setfont(8, 8, gl_font8x8);
 	gl_setwritemode(FONT_COMPRESSED + WRITEMODE_OVERWRITE);
 	gl_setfontcolors(0, vga_white());
+
+	/* Pre-rasterized glyphs used for all text drawing */
+	if (svgalib_glyph_init() != 0) {
+		DEBUG("Failed to build glyph cache.");
+		goto exit_restore;
+	}
 	return 0;
 
  exit_restore:
@@ -58,11 +70,52 @@ int svgalib_init(int mode)
 
 void svgalib_exit(void)
 {
+	svgalib_glyph_exit();
 	vga_setmode(TEXT);
 	if (physical_context)
 		gl_freecontext(physical_context);
 }
 
+GraphicsContext *svgalib_layer_create(int w, int h)
+{
+	GraphicsContext saved, *vc = NULL;
+	void *vbuf = NULL;
+
+	gl_getcontext(&saved);
+
+	vbuf = malloc(w * h * saved.bytesperpixel);
+	if (vbuf == NULL) {
+		SYSERR("Failed to allocate layer buffer.");
+		return NULL;
+	}
+
+	/* Buffer is owned by context and freed by gl_freecontext() */
+	gl_setcontextvirtual(w, h, saved.bytesperpixel, saved.bitsperpixel,
+			     vbuf);
+	vc = gl_allocatecontext();
+	if (vc == NULL) {
+		DEBUG("gl_allocatecontext() failed.");
+		free(vbuf);
+		goto exit_restore;
+	}
+	gl_getcontext(vc);
+
+ exit_restore:
+	gl_setcontext(&saved);
+	return vc;
+}
+
+void svgalib_layer_begin(GraphicsContext *gc)
+{
+	gl_getcontext(&saved_context);
+	gl_setcontext(gc);
+}
+
+void svgalib_layer_end(void)
+{
+	gl_setcontext(&saved_context);
+}
+
 GraphicsContext *svgalib_virtual_context_create(void)
 {
 	GraphicsContext saved, *vc = NULL;
@@ -88,8 +141,21 @@ GraphicsContext *svgalib_virtual_context_create(void)
 
 void svgalib_show_context(GraphicsContext *gc)
 {
+	const struct svgalib_rect *rects = NULL;
+	register int i;
+	int nr = svgalib_damage_collect(&rects);
+
 	gl_setcontext(gc);
-	gl_copyscreen(physical_context);
+	if (nr < 0) {
+		gl_copyscreen(physical_context);
+	} else {
+		for (i = 0; i < nr; i++)
+			gl_copyboxtocontext(rects[i].x, rects[i].y,
+					    rects[i].w, rects[i].h,
+					    physical_context,
+					    rects[i].x, rects[i].y);
+	}
+	svgalib_damage_reset();
 }
 
 void svgalib_clear_screen(int color)
@@ -123,44 +189,58 @@ void svgalib_draw_frame(int x, int y, int w, int h, int color)
 	gl_line(e - 1, y + 1, e - 1, s - 1, color);
 }
 
+static void draw_glyph_spans(const struct glyph_font *gf, int x, int y,
+			     unsigned char c, int color)
+{
+	const struct glyph_span *span = NULL;
+	register int i;
+	int nr;
+
+	span = svgalib_glyph_spans(gf, c, &nr);
+	for (i = 0; i < nr; i++, span++)
+		gl_hline(x + span->xb, y + span->row, x + span->xe, color);
+}
+
 void svgalib_display_text(int xb, int yb, const char txt[],
 			  font_t type, int bgcolor, int txtcolor)
 {
-	const struct font *f = get_font(type);
-	if (f != NULL) {
-		gl_setfont(font_width(f), font_height(f), font_data(f));
-		gl_setwritemode(FONT_COMPRESSED + WRITEMODE_OVERWRITE);
+	struct glyph_font *gf = svgalib_glyph_font(type);
+	int fw, fh;
+
+	if (gf == NULL || txt == NULL)
+		return;
+
+	fw = svgalib_glyph_width(gf);
+	fh = svgalib_glyph_height(gf);
+	for (; *txt != '\0'; txt++, xb += fw) {
+		const svgalib_pixel_t *bm = NULL;
+
+		bm = svgalib_glyph_bitmap(gf, *txt, bgcolor, txtcolor);
+		if (bm != NULL) {
+			gl_putbox(xb, yb, fw, fh, (void *)bm);
+		} else {
+			gl_fillbox(xb, yb, fw, fh, bgcolor);
+			draw_glyph_spans(gf, xb, yb, *txt, txtcolor);
+		}
 	}
-	gl_setfontcolors(bgcolor, txtcolor);
-	gl_write(xb, yb, (char *)txt);
 }
 
+/* Text centered at given position, background left untouched */
 void svgalib_display_text_wrapped(int xb, int yb, const char txt[],
 				  font_t type, int bgcolor, int txtcolor)
 {
-	register int i;
-	int len = strlen(txt);
-	const struct font *f = get_font(type);
+	const struct glyph_font *gf = svgalib_glyph_font(type);
+	int fw;
 
-	if (f != NULL) {
-		gl_setfont(font_width(f), font_height(f), font_data(f));
-		gl_setwritemode(FONT_COMPRESSED + WRITEMODE_MASKED);
-	}
-	gl_setfontcolors(bgcolor, txtcolor);
-	for (i = 0; i < len; ++i)
-		gl_printf(xb - (len << 2) + (i << 3), yb - 8, "%c", txt[i]);
-}
+	(void)bgcolor;	/* background is left untouched */
+	if (gf == NULL || txt == NULL)
+		return;
 
-void svgalib_draw_thick_line(int xb, int yb, int xe, int ye, int color)
-{
-	gl_line(xb, yb, xe, ye, color);
-	if (abs(xe - xb) <= abs(ye - yb)) {
-		gl_line(xb - 1, yb, xe - 1, ye, color);
-		gl_line(xb + 1, yb, xe + 1, ye, color);
-	} else {
-		gl_line(xb, yb - 1, xe, ye - 1, color);
-		gl_line(xb, yb + 1, xe, ye + 1, color);
-	}
+	fw = svgalib_glyph_width(gf);
+	xb -= svgalib_text_width(txt, type) >> 1;
+	yb -= svgalib_glyph_height(gf) >> 1;
+	for (; *txt != '\0'; txt++, xb += fw)
+		draw_glyph_spans(gf, xb, yb, *txt, txtcolor);
 }
 
 void svgalib_draw_grid(int x, int y, int w, int h, int step, int color)
@@ -174,13 +254,9 @@ void svgalib_draw_grid(int x, int y, int w, int h, int step, int color)
 
 	svgalib_draw_frame(x, y, w, h, svgalib_get_color(0, 0, 0));
 
-	for (i = x; i <= (x + w); i++) {
-		if (!((i - x) % step))
-			gl_line(i, y, i, y + h, color);
-	}
+	for (i = x; i <= (x + w); i += step)
+		gl_line(i, y, i, y + h, color);
 
-	for (i = y; i <= (y + h); i++) {
-		if (!((i - y) % step))
-			gl_line(x, i, x + w, i, color);
-	}
+	for (i = y; i <= (y + h); i += step)
+		gl_line(x, i, x + w, i, color);
 }
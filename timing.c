@@ -0,0 +1,84 @@
+#include <string.h>
+#include <time.h>
+
+#include "timing.h"
+#include "debug.h"
+
+unsigned long timing_now(void)
+{
+	struct timespec ts;
+
+	if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0) {
+		SYSERR("clock_gettime() failed.");
+		return 0;
+	}
+	return ts.tv_sec * 1000000UL + ts.tv_nsec / 1000;
+}
+
+unsigned long timing_now_ms(void)
+{
+	struct timespec ts;
+
+	if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0) {
+		SYSERR("clock_gettime() failed.");
+		return 0;
+	}
+	return ts.tv_sec * 1000UL + ts.tv_nsec / 1000000;
+}
+
+static int timing_bucket(unsigned long us)
+{
+	int msb = 0, idx;
+
+	if (us < 4)
+		return us;
+
+	while (us >> (msb + 1))
+		msb++;
+	idx = (msb - 1) * 4 + ((us >> (msb - 2)) & 3);
+	return idx < TIMING_BUCKETS_NR ? idx : TIMING_BUCKETS_NR - 1;
+}
+
+/* Smallest duration falling into bucket */
+static unsigned long timing_bucket_base(int idx)
+{
+	if (idx < 4)
+		return idx;
+	return (4UL + (idx & 3)) << (idx / 4 - 1);
+}
+
+void timing_hist_add(struct timing_hist *h, unsigned long us)
+{
+	h->bucket[timing_bucket(us)]++;
+	h->count++;
+	if (us > h->max)
+		h->max = us;
+}
+
+unsigned long timing_hist_percentile(const struct timing_hist *h, int percent)
+{
+	unsigned long limit, sum = 0;
+	register int i;
+
+	if (!h->count)
+		return 0;
+
+	limit = ((unsigned long)h->count * percent + 99) / 100;
+	for (i = 0; i < TIMING_BUCKETS_NR - 1; i++) {
+		sum += h->bucket[i];
+		if (sum >= limit)
+			break;
+	}
+
+	if (i == TIMING_BUCKETS_NR - 1)
+		return h->max;
+
+	/* Never report more than the worst case seen */
+	limit = timing_bucket_base(i + 1) - 1;
+	return limit < h->max ? limit : h->max;
+}
+
+void timing_hist_reset(struct timing_hist *h)
+{
+	memset(h, 0, sizeof(struct timing_hist));
+}
@@ -0,0 +1,45 @@
+#ifndef TIMING_H_INCLUDED
+#define TIMING_H_INCLUDED
+
+/*
+ * Four buckets per power of two microseconds, so percentiles are
+ * resolved within 25% up to about 16 seconds.
+ */
+#define TIMING_BUCKETS_NR	96
+
+/* Histogram of durations in microseconds */
+struct timing_hist {
+	unsigned int bucket[TIMING_BUCKETS_NR];
+	unsigned int count;
+	unsigned long max;
+};
+
+/* Monotonic clock in microseconds */
+extern unsigned long timing_now(void);
+
+/*
+ * Monotonic clock in milliseconds, for deadlines. It wraps like any
+ * unsigned long, so compare two readings by their difference only.
+ */
+extern unsigned long timing_now_ms(void);
+
+/* Non zero when time @a is at or past @b, wrap safe */
+static inline int timing_after_eq(unsigned long a, unsigned long b)
+{
+	return (long)(a - b) >= 0;
+}
+
+extern void timing_hist_add(struct timing_hist *h, unsigned long us);
+
+/* Upper bound of the bucket holding given percentile, 0 when empty */
+extern unsigned long timing_hist_percentile(const struct timing_hist *h,
+					    int percent);
+
+extern void timing_hist_reset(struct timing_hist *h);
+
+static inline unsigned long timing_hist_max(const struct timing_hist *h)
+{
+	return h->max;
+}
+
+#endif	/* TIMING_H_INCLUDED */
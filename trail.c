@@ -0,0 +1,152 @@
+#include <stdlib.h>
+#include <math.h>
+
+#include "trail.h"
+#include "debug.h"
+
+/* Points are kept in chunks with bounding box for culling */
+#define TRAIL_CHUNK_POINTS	64
+#define TRAIL_CHUNKS_NR		256
+
+/* Decimation limits, distances in meters */
+#define TRAIL_MIN_DISTANCE	5.0
+#define TRAIL_MAX_DISTANCE	50.0
+
+/* Sine of heading change (about 5 degrees) that forces a point */
+#define TRAIL_MAX_TURN		0.087
+
+/* Coordinates kept as separate arrays for batched transform */
+struct trail_chunk {
+	double x[TRAIL_CHUNK_POINTS];
+	double y[TRAIL_CHUNK_POINTS];
+	unsigned int nr;
+	struct point min, max;
+};
+
+struct trail {
+	struct trail_chunk chunks[TRAIL_CHUNKS_NR];
+	unsigned int head;		/* chunk being filled */
+	unsigned int chunks_nr;		/* chunks in use */
+	struct point last, prev;	/* last two recorded points */
+	unsigned int points_nr;
+};
+
+struct trail *trail_create(void)
+{
+	struct trail *tr = malloc(sizeof(struct trail));
+	if (tr == NULL) {
+		SYSERR("Failed to allocate trail.");
+		return NULL;
+	}
+	trail_reset(tr);
+	return tr;
+}
+
+void trail_destroy(struct trail *tr)
+{
+	if (tr)
+		free(tr);
+}
+
+void trail_reset(struct trail *tr)
+{
+	tr->head = 0;
+	tr->chunks_nr = 1;
+	tr->chunks[0].nr = 0;
+	tr->points_nr = 0;
+}
+
+static int trail_keep(const struct trail *tr, const struct point *pos)
+{
+	double dx, dy, px, py, d;
+
+	if (tr->points_nr == 0)
+		return 1;
+
+	dx = pos->x - tr->last.x;
+	dy = pos->y - tr->last.y;
+	d = hypot(dx, dy);
+	if (d < TRAIL_MIN_DISTANCE)
+		return 0;
+	if (d >= TRAIL_MAX_DISTANCE || tr->points_nr < 2)
+		return 1;
+
+	/* Keep point where direction of motion changes */
+	px = tr->last.x - tr->prev.x;
+	py = tr->last.y - tr->prev.y;
+	if (px * dx + py * dy <= 0.0)
+		return 1;
+	return fabs(px * dy - py * dx) > TRAIL_MAX_TURN * d * hypot(px, py);
+}
+
+void trail_add(struct trail *tr, const struct point *pos)
+{
+	struct trail_chunk *chunk = NULL;
+
+	if (!trail_keep(tr, pos))
+		return;
+
+	chunk = &tr->chunks[tr->head];
+	if (chunk->nr == TRAIL_CHUNK_POINTS) {
+		/* Overwrite oldest chunk once all are in use */
+		tr->head = (tr->head + 1) % TRAIL_CHUNKS_NR;
+		if (tr->chunks_nr < TRAIL_CHUNKS_NR)
+			tr->chunks_nr++;
+		chunk = &tr->chunks[tr->head];
+
+		/* Runs overlap by a point, so their polylines join */
+		chunk->min = tr->last;
+		chunk->max = tr->last;
+		chunk->x[0] = tr->last.x;
+		chunk->y[0] = tr->last.y;
+		chunk->nr = 1;
+	}
+
+	if (chunk->nr == 0) {
+		chunk->min = *pos;
+		chunk->max = *pos;
+	} else {
+		chunk->min.x = fmin(chunk->min.x, pos->x);
+		chunk->min.y = fmin(chunk->min.y, pos->y);
+		chunk->max.x = fmax(chunk->max.x, pos->x);
+		chunk->max.y = fmax(chunk->max.y, pos->y);
+	}
+	chunk->x[chunk->nr] = pos->x;
+	chunk->y[chunk->nr] = pos->y;
+	chunk->nr++;
+
+	tr->prev = tr->last;
+	tr->last = *pos;
+	tr->points_nr++;
+}
+
+static int chunk_is_near(const struct trail_chunk *chunk,
+			 const struct point *center, double radius)
+{
+	double dx = fmax(fmax(chunk->min.x - center->x, 0.0),
+			 center->x - chunk->max.x);
+	double dy = fmax(fmax(chunk->min.y - center->y, 0.0),
+			 center->y - chunk->max.y);
+
+	return (dx * dx + dy * dy <= radius * radius);
+}
+
+void trail_for_each_near(const struct trail *tr,
+			 const struct point *center, double radius,
+			 void (*fn)(const double *, const double *,
+				    unsigned int, void *),
+			 void *userdata)
+{
+	register unsigned int i;
+
+	for (i = 0; i < tr->chunks_nr; i++) {
+		const struct trail_chunk *chunk =
+			&tr->chunks[(tr->head + TRAIL_CHUNKS_NR - i) %
+				    TRAIL_CHUNKS_NR];
+
+		if (chunk->nr == 0 || !chunk_is_near(chunk, center, radius))
+			continue;
+
+		fn(chunk->x, chunk->y, chunk->nr, userdata);
+	}
+}
@@ -0,0 +1,30 @@
+#ifndef TRAIL_H_INCLUDED
+#define TRAIL_H_INCLUDED
+
+#include "internals.h"
+
+struct trail;
+
+extern struct trail *trail_create(void);
+
+extern void trail_destroy(struct trail *tr);
+
+extern void trail_reset(struct trail *tr);
+
+/**
+ * Record aircraft position. Positions too close to last one, or continuing
+ * straight on, are dropped; oldest points are overwritten once full.
+ */
+extern void trail_add(struct trail *tr, const struct point *pos);
+
+/**
+ * Call @fn for runs of recorded points possibly within @radius of @center,
+ * points are passed as separate x and y arrays of @nr entries.
+ */
+extern void trail_for_each_near(const struct trail *tr,
+				const struct point *center, double radius,
+				void (*fn)(const double *x, const double *y,
+					   unsigned int nr, void *userdata),
+				void *userdata);
+
+#endif	/* TRAIL_H_INCLUDED */
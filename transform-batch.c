@@ -0,0 +1,91 @@
+#include <math.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "transform-batch.h"
+
+/* Span over which coefficients are taken, power of two divides exactly */
+#define AFFINE_SPAN	((double)(1 << 20))
+
+void transform_affine_init(struct transform_affine *af,
+			   const struct transform *tr)
+{
+	struct point o = { 0.0, 0.0 };
+	struct point xp = { AFFINE_SPAN, 0.0 }, xn = { -AFFINE_SPAN, 0.0 };
+	struct point yp = { 0.0, AFFINE_SPAN }, yn = { 0.0, -AFFINE_SPAN };
+
+	/*
+	 * Image of origin is far off for world coordinates of millions of
+	 * metres, so differences to it over a unit would keep few digits.
+	 * Coefficients are taken across a wide span instead.
+	 */
+	o = do_transform(tr, o);
+	xp = do_transform(tr, xp);
+	xn = do_transform(tr, xn);
+	yp = do_transform(tr, yp);
+	yn = do_transform(tr, yn);
+
+	af->a = (xp.x - xn.x) / (2.0 * AFFINE_SPAN);
+	af->c = (xp.y - xn.y) / (2.0 * AFFINE_SPAN);
+	af->b = (yp.x - yn.x) / (2.0 * AFFINE_SPAN);
+	af->d = (yp.y - yn.y) / (2.0 * AFFINE_SPAN);
+	af->tx = o.x;
+	af->ty = o.y;
+}
+
+int transform_affine_invert(const struct transform_affine *af,
+			    double x, double y, struct point *out)
+{
+	double det = af->a * af->d - af->b * af->c;
+
+	if (fabs(det) < 1e-12)
+		return -1;
+
+	x -= af->tx;
+	y -= af->ty;
+	out->x = (af->d * x - af->b * y) / det;
+	out->y = (af->a * y - af->c * x) / det;
+	return 0;
+}
+
+void transform_batch_scalar(const struct transform_affine *af,
+			    const double *x, const double *y,
+			    double *xo, double *yo, unsigned int nr)
+{
+	register unsigned int i;
+
+	for (i = 0; i < nr; i++) {
+		double px = x[i], py = y[i];
+
+		xo[i] = af->a * px + af->b * py + af->tx;
+		yo[i] = af->c * px + af->d * py + af->ty;
+	}
+}
+
+void transform_batch(const struct transform_affine *af,
+		     const double *x, const double *y,
+		     double *xo, double *yo, unsigned int nr)
+{
+	register unsigned int i = 0;
+
+#ifdef __SSE2__
+	const __m128d a = _mm_set1_pd(af->a), b = _mm_set1_pd(af->b);
+	const __m128d c = _mm_set1_pd(af->c), d = _mm_set1_pd(af->d);
+	const __m128d tx = _mm_set1_pd(af->tx), ty = _mm_set1_pd(af->ty);
+
+	for (; i + 2 <= nr; i += 2) {
+		__m128d px = _mm_loadu_pd(x + i);
+		__m128d py = _mm_loadu_pd(y + i);
+		__m128d rx = _mm_add_pd(_mm_add_pd(_mm_mul_pd(a, px),
+						   _mm_mul_pd(b, py)), tx);
+		__m128d ry = _mm_add_pd(_mm_add_pd(_mm_mul_pd(c, px),
+						   _mm_mul_pd(d, py)), ty);
+		_mm_storeu_pd(xo + i, rx);
+		_mm_storeu_pd(yo + i, ry);
+	}
+#endif
+
+	/* Scalar fallback, and tail of vector loop */
+	transform_batch_scalar(af, x + i, y + i, xo + i, yo + i, nr - i);
+}
@@ -0,0 +1,33 @@
+#ifndef TRANSFORM_BATCH_H_INCLUDED
+#define TRANSFORM_BATCH_H_INCLUDED
+
+#include "transform.h"
+
+/* Transform as affine map: x' = a * x + b * y + tx, y' = c * x + d * y + ty */
+struct transform_affine {
+	double a, b, tx;
+	double c, d, ty;
+};
+
+/* Coefficients of current rotation, scale and translation of @tr */
+extern void transform_affine_init(struct transform_affine *af,
+				  const struct transform *tr);
+
+/* Map screen position back into world coordinates, -1 if degenerate */
+extern int transform_affine_invert(const struct transform_affine *af,
+				   double x, double y, struct point *out);
+
+/**
+ * Transform @nr points held as separate x and y arrays. Output arrays may
+ * be same as input ones.
+ */
+extern void transform_batch(const struct transform_affine *af,
+			    const double *x, const double *y,
+			    double *xo, double *yo, unsigned int nr);
+
+/* Same as transform_batch(), one point at a time without SIMD */
+extern void transform_batch_scalar(const struct transform_affine *af,
+				   const double *x, const double *y,
+				   double *xo, double *yo, unsigned int nr);
+
+#endif	/* TRANSFORM_BATCH_H_INCLUDED */
@@ -1,6 +1,10 @@
 #include <math.h>
+#include <string.h>
+#include <unistd.h>
 #include <sys/time.h>
 #include <ctype.h>
+#include <poll.h>
+#include <sys/epoll.h>
 
 #include "ui.h"
 #include "svgalib.h"
@@ -11,11 +15,15 @@
 #include "ral.h"
 #include "log.h"
 #include "doch.h"
-#include "event.h"
 #include "trackbar.h"
 #include "course.h"
 #include "flight.h"
 #include "keyboard.h"
+#include "render.h"
+#include "timing.h"
+#include "reactor.h"
+#include "gps-setup.h"
+#include "gps-port.h"
 
 int ui_init(int *argc, char ***argv)
 {
@@ -39,78 +47,238 @@ int ui_init(int *argc, char ***argv)
 	return 0;
 }
 
-int ui_run(run_mode_t run_mode)
-{
+/* Loop tick for setup timeouts and data read each period, ms */
+#define UI_TICK		50
+
+/* State shared by ui_run() and handlers it registers with the reactor */
+struct ui_loop {
+	run_mode_t run_mode;
 	struct gps_data gps;
 	struct mag_data mag;
 	struct ral_data ral;
 	struct course course;
 	struct flight_data flt;
-	struct graphics_context *gc = NULL;
+	struct graphics_context *gc;
+	struct reactor *reactor;
+	struct gps_setup setup;
+	rc_t rc;			/* updates since last pass */
+	int period;			/* RAL or simulated data read each, ms */
+	unsigned long acquired;		/* last of them, ms */
+	unsigned int ral_watched : 1;	/* RAL on reactor, not read each period */
+	unsigned int polled : 1;	/* period elapsed since last pass */
+	unsigned int urgent : 1;
+	unsigned int quit : 1;
+};
+
+static void ui_keyboard_handler(int fd, unsigned int events, void *userdata)
+{
+	struct ui_loop *ui = (struct ui_loop *)userdata;
+	int key = toupper(keyboard_getkey());
+
+	ui->urgent = 1;
+	ui->rc |= graphics_controls(ui->gc, &ui->course, &ui->flt, key);
+	if (ui->rc & RC_QUIT) {
+		ui->quit = 1;
+		return;
+	}
+	ui->rc |= flight_controls(&ui->flt, &ui->course, ui->run_mode, key);
+	ui->rc |= course_controls(&ui->course, &ui->flt, key);
+	trackbar_controls(&ui->course, key);
+}
+
+/* Feed receiver setup with reply @line, NULL when only time passed */
+static void ui_gps_setup(struct ui_loop *ui, const char *line)
+{
+	if (ui->run_mode != RUN_REAL_TIME)
+		return;
+	if (gps_setup_update(&ui->setup, line))
+		graphics_gps_setup_done(ui->gc, &ui->setup);
+}
+
+/* Simulated data, or RAL when its descriptor can't be watched */
+static void ui_acquire(struct ui_loop *ui, unsigned long now)
+{
+	if (ui->run_mode == RUN_REAL_TIME) {
+		if (!ui->ral_watched && !ral_acquire_data(&ui->ral))
+			ui->rc |= RC_RAL_UPDATE;
+	} else if (ui->run_mode == RUN_SIM_DATA) {
+		ui->rc |= sim_data_update(&ui->gps, &ui->ral, &ui->mag);
+	}
+	ui->acquired = now;
+	ui->polled = 1;
+}
+
+static void ui_gps_line(const char *line, void *userdata)
+{
+	ui_gps_setup((struct ui_loop *)userdata, line);
+}
+
+static void ui_gps_handler(int fd, unsigned int events, void *userdata)
+{
+	struct ui_loop *ui = (struct ui_loop *)userdata;
+	int updated = gps_port_acquire(&ui->gps, ui_gps_line, ui);
+
+	if (updated < 0) {
+		WARN("GPS port failed, no more GPS data.");
+		reactor_remove(ui->reactor, fd);
+		return;
+	}
+	if (updated)
+		ui->rc |= RC_GPS_UPDATE;
+}
+
+/* Device gone, stop watching it instead of waking up on it forever */
+static int ui_device_failed(struct ui_loop *ui, int fd, unsigned int events,
+			    const char *name)
+{
+	if (!(events & (EPOLLERR | EPOLLHUP)))
+		return 0;
+	WARN("%s device failed, no more %s data.", name, name);
+	reactor_remove(ui->reactor, fd);
+	return 1;
+}
+
+/* Take every pending sample, so a fast MAG never backs up */
+static void ui_mag_handler(int fd, unsigned int events, void *userdata)
+{
+	struct ui_loop *ui = (struct ui_loop *)userdata;
+	struct pollfd pfd = { .fd = fd, .events = POLLIN };
+
+	if (events & EPOLLIN) {
+		do {
+			if (mag_acquire_data(&ui->mag) != 0)
+				break;
+			ui->rc |= RC_MAG_UPDATE;
+		} while (poll(&pfd, 1, 0) > 0 && (pfd.revents & POLLIN));
+	}
+	ui_device_failed(ui, fd, events, "MAG");
+}
+
+static void ui_ral_handler(int fd, unsigned int events, void *userdata)
+{
+	struct ui_loop *ui = (struct ui_loop *)userdata;
+
+	if ((events & EPOLLIN) && !ral_acquire_data(&ui->ral))
+		ui->rc |= RC_RAL_UPDATE;
+	if (ui_device_failed(ui, fd, events, "RAL"))
+		ui->ral_watched = 0;
+}
+
+/*
+ * Receiver setup runs off the tick, its commands time out with no input
+ * and the view hidden. Simulated data, or RAL without a descriptor to
+ * wait on, is read here once per period.
+ */
+static void ui_tick_handler(int fd, unsigned int events, void *userdata)
+{
+	struct ui_loop *ui = (struct ui_loop *)userdata;
+	unsigned long now = timing_now_ms();
+
+	ui_gps_setup(ui, NULL);
+
+	if (timing_after_eq(now, ui->acquired + ui->period))
+		ui_acquire(ui, now);
+}
+
+int ui_run(run_mode_t run_mode)
+{
+	struct ui_loop ui;
 	struct trackbar_context *tbar_ctx = NULL;
-	int timeout = 200;
+	struct render_sched rs;
+	unsigned int datum = 0;
+	int retval = -1;
 
-	gps_data_init(&gps);
-	mag_data_init(&mag);
-	ral_data_init(&ral);
-	course_init(&course);
-	flight_init(&flt);
+	memset(&ui, 0, sizeof(struct ui_loop));
+	ui.run_mode = run_mode;
+	ui.period = 200;
+	gps_data_init(&ui.gps);
+	mag_data_init(&ui.mag);
+	ral_data_init(&ui.ral);
+	course_init(&ui.course);
+	flight_init(&ui.flt);
 
-	if (graphics_context_init(&gc, &course, &flt, &gps, &mag) != 0) {
+	if (graphics_context_init(&ui.gc, &ui.course, &ui.flt,
+				  &ui.gps, &ui.mag) != 0) {
 		DEBUG("graphics_context_init() failed.");
 		return -1;
 	}
 	trackbar_context_init(&tbar_ctx);
+	graphics_gps_setup_init(ui.gc, &ui.setup);
 
-	if (run_mode == RUN_REAL_TIME)
-		timeout = 500;
+	ui.acquired = timing_now_ms();
 
-	for (;;) {
-		rc_t rc = RC_NONE;
-		event_t event;
+	if (reactor_create(&ui.reactor) != 0)
+		goto exit;
+	if (reactor_set_timer(ui.reactor, UI_TICK, ui_tick_handler, &ui) != 0)
+		goto exit;
+	if (reactor_add(ui.reactor, STDIN_FILENO,
+			ui_keyboard_handler, &ui) != 0)
+		WARN("Keyboard can't be watched, controls disabled.");
+	if (run_mode == RUN_REAL_TIME) {
+		if (gps_port_descriptor() < 0 ||
+		    reactor_add(ui.reactor, gps_port_descriptor(),
+				ui_gps_handler, &ui) != 0)
+			WARN("GPS port not open, no GPS data.");
+		if (mag_descriptor() < 0 ||
+		    reactor_add(ui.reactor, mag_descriptor(),
+				ui_mag_handler, &ui) != 0)
+			WARN("MAG device not open, no MAG data.");
 
-		/* Wait on event */
-		event = event_wait_poll(timeout);
+		/* ADC driver may not signal its FIFO, then read each period */
+		ui.ral_watched = ral_descriptor() >= 0 &&
+				 reactor_add(ui.reactor, ral_descriptor(),
+					     ui_ral_handler, &ui) == 0;
+		if (!ui.ral_watched)
+			INFO("RAL read every %d ms.", ui.period);
+	}
 
-		if (event & EVENT_KEYPRESSED) {
-			int key = toupper(keyboard_getkey());
-			rc |= graphics_controls(gc, &course, &flt, key);
-			if (rc & RC_QUIT)
-				break;
-			rc |= flight_controls(&flt, &course, run_mode, key);
-			rc |= course_controls(&course, &flt, key);
-			trackbar_controls(&course, key);
-		}
+	render_sched_init(&rs, render_frame_rate, render_latency_budget);
+	datum = ui.flt.at_AGL_height;
 
-		if (run_mode == RUN_REAL_TIME) {
-			if (event & EVENT_GPS_READY) {
-				if (!gps_acquire_data(&gps))
-					rc |= RC_GPS_UPDATE;
-			}
-			if (event & (EVENT_GPS_READY | EVENT_TIMEOUT)) {
-				if (!ral_acquire_data(&ral))
-					rc |= RC_RAL_UPDATE;
-			}
-			if (event & EVENT_MAG_READY) {
-				if (!mag_acquire_data(&mag))
-					rc |= RC_MAG_UPDATE;
+	while (!ui.quit) {
+		/* Wait on devices, but not past the next due render */
+		if (reactor_run_once(ui.reactor,
+				     render_sched_timeout(&rs, UI_TICK)) < 0)
+			goto exit;
+		if (ui.quit)
+			break;
+
+		if (ui.rc != RC_NONE || ui.urgent || ui.polled) {
+			rc_t rc = ui.rc;
+
+			rc |= flight_update(&ui.flt, &ui.course, &ui.gps,
+					    &ui.ral, run_mode, rc);
+			rc |= course_update(&ui.course, &ui.flt, rc);
+			trackbar_context_display(tbar_ctx, &ui.course,
+						 &ui.flt, rc);
+			graphics_update(ui.gc, rc);
+
+			/* Pilot has to see datum switch at once */
+			if (ui.flt.at_AGL_height != datum) {
+				datum = ui.flt.at_AGL_height;
+				ui.urgent = 1;
 			}
+			render_sched_post(&rs, rc, ui.urgent);
+			doch_data_out(&ui.course, &ui.gps, &ui.ral, rc);
+			log_data(&ui.course, &ui.gps, &ui.ral, &ui.mag, rc);
 
-		} else if (run_mode == RUN_SIM_DATA) {
-			rc |= sim_data_update(&gps, &ral, &mag);
+			ui.rc = RC_NONE;
+			ui.urgent = 0;
+			ui.polled = 0;
 		}
 
-		rc |= flight_update(&flt, &course, &gps, &ral, run_mode, rc);
-		rc |= course_update(&course, &flt, rc);
-		trackbar_context_display(tbar_ctx, &course, &flt, rc);
-		graphics_update(gc, rc);
-		doch_data_out(&course, &gps, &ral, rc);
-		log_data(&course, &gps, &ral, &mag, rc);
+		if (render_sched_due(&rs)) {
+			render_sched_done(&rs);
+			graphics_render(ui.gc);
+		}
 	}
+	retval = 0;
 
+ exit:
+	reactor_destroy(ui.reactor);
 	trackbar_context_free(tbar_ctx);
-	graphics_context_destroy(gc);
-	return 0;
+	graphics_context_destroy(ui.gc);
+	return retval;
 }
 
 void ui_exit(void)